@@ -0,0 +1,69 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <linq.hpp>
+
+TEST_CASE( "contiguous sum/min/max" ) {
+    auto ints   = std::vector<int>( 10'000'000 );
+    auto floats = std::vector<float>( ints.size() );
+
+    for ( size_t i = 0; i < ints.size(); ++i ) {
+        ints[i]   = static_cast<int>( ( ( i * 2654435761ULL ) >> 7 ) % 100'000 ) - 50'000;
+        floats[i] = static_cast<float>( ints[i] ) / 100;
+    }
+
+    BENCHMARK( "sum() of 10000000 floats" ) {
+        return linq::from( &floats ).sum().value();
+    };
+
+    BENCHMARK( "max() of 10000000 floats" ) {
+        return linq::from( &floats ).max().value();
+    };
+
+    BENCHMARK( "sum() of 10000000 ints" ) {
+        return linq::from( &ints ).sum().value();
+    };
+
+    BENCHMARK( "min() of 10000000 ints" ) {
+        return linq::from( &ints ).min().value();
+    };
+
+    BENCHMARK( "average() of 10000000 ints" ) {
+        return linq::from( &ints ).average().value();
+    };
+}
+
+TEST_CASE( "fused aggregates" ) {
+    auto values = std::vector<double>( 10'000'000 );
+
+    for ( size_t i = 0; i < values.size(); ++i )
+        values[i] = static_cast<double>( ( ( i * 2654435761ULL ) >> 7 ) % 100'000 ) / 100;
+
+    const auto query = linq::from( &values )
+                           .where( []( double d ) {
+                               return d > 10;
+                           } )
+                           .select( []( double d ) {
+                               return d * 2;
+                           } );
+
+    BENCHMARK( "min(), max(), average() and count() in separate passes" ) {
+        return query.min().value() + query.max().value() + static_cast<double>( query.average().value() ) +
+               static_cast<double>( query.count() );
+    };
+
+    BENCHMARK( "aggregate_all( min, max, mean, count )" ) {
+        const auto [min, max, mean, count] =
+            query.aggregate_all( linq::agg::min, linq::agg::max, linq::agg::mean, linq::agg::count );
+
+        return min.value() + max.value() + static_cast<double>( mean.value() ) + static_cast<double>( count );
+    };
+
+    BENCHMARK( "min() and max() in separate passes" ) {
+        return query.min().value() + query.max().value();
+    };
+
+    BENCHMARK( "min_max()" ) {
+        const auto result = query.min_max().value();
+        return result.first + result.second;
+    };
+}
@@ -0,0 +1,107 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <linq.hpp>
+
+namespace {
+struct customer {
+    int id{};
+    int region{};
+};
+
+struct order {
+    int customer_id{};
+    int amount{};
+};
+
+// Key type without a std::hash specialization, which forces the nested loop join.
+struct unhashable_key {
+    int value{};
+
+    bool operator==( const unhashable_key& ) const = default;
+};
+
+auto make_customers( int count ) {
+    auto customers = std::vector<customer>();
+
+    for ( int i = 0; i < count; ++i )
+        customers.push_back( { .id = i, .region = i % 16 } );
+
+    return customers;
+}
+
+auto make_orders( int count, int customer_count ) {
+    auto orders = std::vector<order>();
+
+    for ( int i = 0; i < count; ++i )
+        orders.push_back( { .customer_id = ( i * 7919 ) % customer_count, .amount = i % 100 } );
+
+    return orders;
+}
+} // namespace
+
+TEST_CASE( "join (hashed)" ) {
+    const auto customers = make_customers( 50'000 );
+    const auto orders    = make_orders( 200'000, 50'000 );
+
+    BENCHMARK( "200k orders x 50k customers" ) {
+        return linq::from( &orders )
+            .join(
+                linq::from( &customers ),
+                []( const order& o ) {
+                    return o.customer_id;
+                },
+                []( const customer& c ) {
+                    return c.id;
+                },
+                []( const order& o, const customer& c ) {
+                    return o.amount * c.region;
+                } )
+            .count();
+    };
+}
+
+TEST_CASE( "join (nested loop)" ) {
+    const auto customers = make_customers( 2'000 );
+    const auto orders    = make_orders( 8'000, 2'000 );
+
+    BENCHMARK( "8k orders x 2k customers" ) {
+        return linq::from( &orders )
+            .join(
+                linq::from( &customers ),
+                []( const order& o ) {
+                    return unhashable_key{ o.customer_id };
+                },
+                []( const customer& c ) {
+                    return unhashable_key{ c.id };
+                },
+                []( const order& o, const customer& c ) {
+                    return o.amount * c.region;
+                } )
+            .count();
+    };
+}
+
+TEST_CASE( "join_sorted" ) {
+    const auto customers = make_customers( 50'000 );
+    const auto orders    = linq::from_to( 0, 199'999 )
+                            .select( []( int i ) {
+                                return order{ .customer_id = i / 4, .amount = i % 100 };
+                            } )
+                            .to_vector();
+
+    BENCHMARK( "200k orders x 50k customers" ) {
+        return linq::from( &orders )
+            .join_sorted(
+                linq::from( &customers ),
+                []( const order& o ) {
+                    return o.customer_id;
+                },
+                []( const customer& c ) {
+                    return c.id;
+                },
+                []( const order& o, const customer& c ) {
+                    return o.amount * c.region;
+                } )
+            .count();
+    };
+}
@@ -0,0 +1,148 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <linq.hpp>
+#include <string>
+
+TEST_CASE( "as_parallel" ) {
+    auto values = std::vector<double>( 10'000'000 );
+
+    for ( size_t i = 0; i < values.size(); ++i )
+        values[i] = static_cast<double>( ( ( i * 2654435761ULL ) >> 7 ) % 100'000 ) / 100;
+
+    const auto is_interesting = []( double d ) {
+        return std::sin( d ) > 0.5;
+    };
+
+    const auto scaled = []( double d ) {
+        return std::sqrt( d ) * 2;
+    };
+
+    BENCHMARK( "where/select/sum on 1 thread" ) {
+        return linq::from( &values ).where( is_interesting ).select( scaled ).sum().value();
+    };
+
+    BENCHMARK( "where/select/sum with as_parallel" ) {
+        return linq::from( &values ).as_parallel().where( is_interesting ).select( scaled ).sum().value();
+    };
+
+    BENCHMARK( "count( predicate ) on 1 thread" ) {
+        return linq::from( &values ).count( is_interesting );
+    };
+
+    BENCHMARK( "count( predicate ) with as_parallel" ) {
+        return linq::from( &values ).as_parallel().count( is_interesting );
+    };
+}
+
+TEST_CASE( "parallel reduce" ) {
+    auto values = std::vector<float>( 10'000'000 );
+
+    for ( size_t i = 0; i < values.size(); ++i )
+        values[i] = 1.0f / static_cast<float>( i % 1000 + 1 );
+
+    BENCHMARK( "reduce( std::plus() )" ) {
+        return linq::from( &values ).reduce( std::plus() );
+    };
+
+    BENCHMARK( "reduce( linq::parallel, std::plus() )" ) {
+        return linq::from( &values ).reduce( linq::parallel, std::plus() );
+    };
+
+    BENCHMARK( "aggregate( 0.0, accumulate, combine )" ) {
+        return linq::from( &values ).aggregate(
+            0.0,
+            []( double sum, float f ) {
+                return sum + f;
+            },
+            std::plus() );
+    };
+}
+
+TEST_CASE( "parallel to_vector" ) {
+    auto numbers = std::vector<int>( 2'000'000 );
+
+    for ( size_t i = 0; i < numbers.size(); ++i )
+        numbers[i] = static_cast<int>( i );
+
+    const auto to_text = []( int i ) {
+        return std::to_string( i );
+    };
+
+    BENCHMARK( "select( to_string ).to_vector()" ) {
+        return linq::from( &numbers ).select( to_text ).to_vector();
+    };
+
+    BENCHMARK( "select( to_string ).to_vector( linq::parallel )" ) {
+        return linq::from( &numbers ).select( to_text ).to_vector( linq::parallel );
+    };
+}
+
+TEST_CASE( "parallel to_unordered_map" ) {
+    auto numbers = std::vector<int>( 2'000'000 );
+
+    for ( size_t i = 0; i < numbers.size(); ++i )
+        numbers[i] = static_cast<int>( i * 7919 % 1'000'003 );
+
+    const auto to_pair = []( int i ) {
+        return std::pair( i, i / 2 );
+    };
+
+    BENCHMARK( "select( to_pair ).to_unordered_map()" ) {
+        return linq::from( &numbers ).select( to_pair ).to_unordered_map();
+    };
+
+    BENCHMARK( "select( to_pair ).to_unordered_map( linq::parallel )" ) {
+        return linq::from( &numbers ).select( to_pair ).to_unordered_map( linq::parallel );
+    };
+
+    BENCHMARK( "select( to_pair ).to_sharded_map()" ) {
+        return linq::from( &numbers ).select( to_pair ).to_sharded_map();
+    };
+}
+
+TEST_CASE( "parallel to_lookup" ) {
+    auto numbers = std::vector<int>( 2'000'000 );
+
+    for ( size_t i = 0; i < numbers.size(); ++i )
+        numbers[i] = static_cast<int>( i * 7919 % 1'000'003 );
+
+    const auto key = []( int i ) {
+        return i % 100'003;
+    };
+
+    BENCHMARK( "to_lookup( key )" ) {
+        return linq::from( &numbers ).to_lookup( key );
+    };
+
+    BENCHMARK( "to_lookup( linq::parallel, key )" ) {
+        return linq::from( &numbers ).to_lookup( linq::parallel, key );
+    };
+}
+
+TEST_CASE( "nested parallel operations" ) {
+    const auto inner = linq::from_to( 1, 200'000 ).select( []( int i ) {
+        return std::sqrt( static_cast<double>( i ) );
+    } );
+
+    const auto outer = linq::from_to( 0, 200'000 );
+
+    const auto nested_sum = [&inner]( int i ) {
+        return i % 10'000 == 0 ? inner.reduce( linq::parallel, std::plus() ) : 0.0;
+    };
+
+    BENCHMARK( "as_parallel() with nested reduce( linq::parallel )" ) {
+        return outer.as_parallel().select( nested_sum ).sum().value();
+    };
+
+    auto pool = linq::thread_pool( linq::max_threads() - 1 );
+
+    BENCHMARK( "as_parallel( thread_pool ) with nested reduce( linq::parallel.on( thread_pool ) )" ) {
+        return outer.as_parallel( pool )
+            .select( [&]( int i ) {
+                return i % 10'000 == 0 ? inner.reduce( linq::parallel.on( pool ), std::plus() ) : 0.0;
+            } )
+            .sum()
+            .value();
+    };
+}
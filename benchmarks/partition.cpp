@@ -0,0 +1,26 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <linq.hpp>
+
+TEST_CASE( "skip/take pagination" ) {
+    auto numbers = std::vector<int>( 10'000'000 );
+
+    for ( size_t i = 0; i < numbers.size(); ++i )
+        numbers[i] = static_cast<int>( i );
+
+    const auto query = linq::from( &numbers ).select( []( int i ) {
+        return i * 2;
+    } );
+
+    BENCHMARK( "last page of 10000000" ) {
+        return query.skip( 9'999'950 ).take( 50 ).to_vector().size();
+    };
+
+    BENCHMARK( "element_at( 9999999 )" ) {
+        return query.element_at( 9'999'999 ).value();
+    };
+
+    BENCHMARK( "count()" ) {
+        return query.count();
+    };
+}
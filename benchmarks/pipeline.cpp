@@ -0,0 +1,157 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <linq.hpp>
+
+TEST_CASE( "5-stage pipeline" ) {
+    auto numbers = std::vector<int>( 10'000'000 );
+
+    for ( size_t i = 0; i < numbers.size(); ++i )
+        numbers[i] = static_cast<int>( i % 1000 );
+
+    const auto is_odd = []( int i ) {
+        return i % 2 == 1;
+    };
+
+    const auto times_three = []( int i ) {
+        return static_cast<long long>( i ) * 3;
+    };
+
+    const auto below_1500 = []( long long i ) {
+        return i < 1500;
+    };
+
+    const auto plus_one = []( long long i ) {
+        return i + 1;
+    };
+
+    const auto query =
+        linq::from( &numbers ).where( is_odd ).select( times_three ).where( below_1500 ).select( plus_one ).skip( 10 );
+
+    BENCHMARK( "hand-written loop sum" ) {
+        auto result  = 0LL;
+        auto skipped = 0;
+
+        for ( const auto i : numbers ) {
+            if ( !is_odd( i ) )
+                continue;
+
+            const auto value = times_three( i );
+
+            if ( !below_1500( value ) )
+                continue;
+
+            if ( skipped < 10 ) {
+                ++skipped;
+                continue;
+            }
+
+            result += plus_one( value );
+        }
+
+        return result;
+    };
+
+    BENCHMARK( "iterator loop sum" ) {
+        auto result = 0LL;
+
+        for ( const auto value : query )
+            result += value;
+
+        return result;
+    };
+
+    BENCHMARK( "sum()" ) {
+        return query.sum().value();
+    };
+
+    BENCHMARK( "count()" ) {
+        return query.count();
+    };
+
+    BENCHMARK( "aggregate()" ) {
+        return query.aggregate( 0LL, []( long long a, long long b ) {
+            return a ^ b;
+        } );
+    };
+
+    BENCHMARK( "to_vector()" ) {
+        return query.to_vector().size();
+    };
+
+    // Not known at compile time, so the search can not be folded away.
+    const auto missing = static_cast<long long>( numbers.back() ) * 1000;
+
+    BENCHMARK( "any() without a match" ) {
+        return query.any( [missing]( long long i ) {
+            return i == missing;
+        } );
+    };
+}
+
+TEST_CASE( "batched pipeline" ) {
+    auto numbers = std::vector<int>( 10'000'000 );
+
+    // Scrambled values, so that filters can not be predicted by the branch predictor.
+    for ( size_t i = 0; i < numbers.size(); ++i )
+        numbers[i] = static_cast<int>( ( ( i * 2654435761ULL ) >> 7 ) % 1000 );
+
+    const auto is_odd = []( int i ) {
+        return ( i & 1 ) != 0;
+    };
+
+    const auto scale = []( int i ) {
+        return static_cast<float>( i ) * 1.5f + 2.0f;
+    };
+
+    const auto filtered = linq::from( &numbers ).where( is_odd );
+    const auto scaled   = linq::from( &numbers ).select( scale );
+
+    BENCHMARK( "where sum()" ) {
+        return filtered.sum().value();
+    };
+
+    BENCHMARK( "batched where sum()" ) {
+        return filtered.batched().sum().value();
+    };
+
+    BENCHMARK( "select to_vector()" ) {
+        return scaled.to_vector().size();
+    };
+
+    BENCHMARK( "batched select to_vector()" ) {
+        return scaled.batched().to_vector().size();
+    };
+}
+
+TEST_CASE( "cached pipeline" ) {
+    auto numbers = std::vector<int>( 1'000'000 );
+
+    for ( size_t i = 0; i < numbers.size(); ++i )
+        numbers[i] = static_cast<int>( ( ( i * 2654435761ULL ) >> 7 ) % 100'000 );
+
+    const auto query = linq::from( &numbers )
+                           .where( []( int i ) {
+                               return i % 3 != 0;
+                           } )
+                           .order_by_ascending( []( int i ) {
+                               return i;
+                           } );
+
+    // count(), to_vector() and an enumeration of the same query.
+    const auto use_three_times = []( const auto& range ) {
+        auto sum = 0LL;
+
+        for ( const auto element : range )
+            sum += element;
+
+        return range.count() + range.to_vector().size() + static_cast<size_t>( sum );
+    };
+
+    BENCHMARK( "where/order_by used three times" ) {
+        return use_three_times( query );
+    };
+
+    BENCHMARK( "where/order_by/cache used three times" ) {
+        return use_three_times( query.cache() );
+    };
+}
@@ -0,0 +1,48 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <linq.hpp>
+
+namespace {
+// Element type without a std::hash specialization, which forces the linear-search distinct.
+struct unhashable_id {
+    int value{};
+
+    bool operator==( const unhashable_id& ) const = default;
+};
+
+auto make_ids( int count ) {
+    auto ids = std::vector<int>();
+    ids.reserve( static_cast<size_t>( count ) );
+
+    // Every id appears twice, so half of the elements are distinct.
+    for ( int i = 0; i < count; ++i )
+        ids.push_back( i / 2 );
+
+    return ids;
+}
+} // namespace
+
+TEST_CASE( "distinct (hashed)" ) {
+    for ( const int count : { 10'000, 100'000, 1'000'000 } ) {
+        const auto ids = make_ids( count );
+
+        BENCHMARK( "n = " + std::to_string( count ) ) {
+            return linq::from( &ids ).distinct().count();
+        };
+    }
+}
+
+TEST_CASE( "distinct (linear search)" ) {
+    for ( const int count : { 1'000, 10'000 } ) {
+        const auto raw_ids = make_ids( count );
+        const auto ids     = linq::from( &raw_ids )
+                             .select( []( int id ) {
+                                 return unhashable_id{ id };
+                             } )
+                             .to_vector();
+
+        BENCHMARK( "n = " + std::to_string( count ) ) {
+            return linq::from( &ids ).distinct().count();
+        };
+    }
+}
@@ -0,0 +1,172 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <linq.hpp>
+
+namespace {
+struct record {
+    int         id{};
+    int         score{};
+    std::string name;
+};
+
+auto make_records( int count ) {
+    auto records = std::vector<record>();
+    records.reserve( static_cast<size_t>( count ) );
+
+    for ( int i = 0; i < count; ++i ) {
+        const auto value = static_cast<int>( ( i * 7919LL ) % count );
+        records.push_back( { .id = i, .score = value % 1000, .name = "record-" + std::to_string( value ) } );
+    }
+
+    return records;
+}
+} // namespace
+
+TEST_CASE( "order_by derived string key" ) {
+    const auto records = make_records( 100'000 );
+
+    BENCHMARK( "n = 100000" ) {
+        return linq::from( &records )
+            .order_by_ascending( []( const record& r ) {
+                return r.name.substr( 7 ) + r.name.substr( 0, 6 );
+            } )
+            .first()
+            ->id;
+    };
+}
+
+TEST_CASE( "order_by/then_by chain" ) {
+    const auto records = make_records( 100'000 );
+
+    BENCHMARK( "3 keys, n = 100000" ) {
+        return linq::from( &records )
+            .order_by_ascending( []( const record& r ) {
+                return r.score / 100;
+            } )
+            .then_by_descending( []( const record& r ) {
+                return r.score % 10;
+            } )
+            .then_by_ascending( []( const record& r ) -> const std::string& {
+                return r.name;
+            } )
+            .first()
+            ->id;
+    };
+}
+
+TEST_CASE( "order_by with take" ) {
+    const auto records = make_records( 1'000'000 );
+
+    const auto by_score = []( const record& r ) {
+        return r.score;
+    };
+
+    BENCHMARK( "top 10, n = 1000000" ) {
+        return linq::from( &records ).order_by_descending( by_score ).take( 10 ).to_vector().size();
+    };
+
+    BENCHMARK( "top 1000, n = 1000000" ) {
+        return linq::from( &records ).order_by_descending( by_score ).take( 1000 ).to_vector().size();
+    };
+
+    BENCHMARK( "full sort, n = 1000000" ) {
+        return linq::from( &records ).order_by_descending( by_score ).to_vector().size();
+    };
+}
+
+TEST_CASE( "order_by integer key" ) {
+    const auto records = make_records( 1'000'000 );
+
+    BENCHMARK( "radix sort, n = 1000000" ) {
+        return linq::from( &records )
+            .order_by_ascending( []( const record& r ) {
+                return static_cast<int>( r.id * 2654435761LL % 1'000'003 );
+            } )
+            .first()
+            ->id;
+    };
+
+    BENCHMARK( "small domain, n = 1000000" ) {
+        return linq::from( &records )
+            .order_by_descending( []( const record& r ) {
+                return r.score;
+            } )
+            .first()
+            ->id;
+    };
+
+    // The same keys wrapped in a tuple, which are sorted by comparisons.
+    BENCHMARK( "comparison sort, n = 1000000" ) {
+        return linq::from( &records )
+            .order_by_ascending( []( const record& r ) {
+                return std::tuple( static_cast<int>( r.id * 2654435761LL % 1'000'003 ) );
+            } )
+            .first()
+            ->id;
+    };
+}
+
+TEST_CASE( "order_by stability" ) {
+    const auto records = make_records( 1'000'000 );
+
+    const auto by_name = []( const record& r ) -> const std::string& {
+        return r.name;
+    };
+
+    BENCHMARK( "stable, n = 1000000" ) {
+        return linq::from( &records ).order_by_ascending( by_name ).first()->id;
+    };
+
+    BENCHMARK( "unstable, n = 1000000" ) {
+        return linq::from( &records ).order_by_ascending( by_name, linq::sort_stability::unstable ).first()->id;
+    };
+}
+
+TEST_CASE( "order_by element storage" ) {
+    const auto records = make_records( 1'000'000 );
+
+    const auto by_score = []( const record& r ) {
+        return r.score;
+    };
+
+    BENCHMARK( "pointers, n = 1000000" ) {
+        return linq::from( &records ).order_by_ascending( by_score ).first()->id;
+    };
+
+    // A select yields prvalues, so the sort has to copy the elements.
+    BENCHMARK( "copies, n = 1000000" ) {
+        return linq::from( &records )
+            .select( []( const record& r ) {
+                return r;
+            } )
+            .order_by_ascending( by_score )
+            .first()
+            ->id;
+    };
+}
+
+#ifndef LINQ_NO_THREADS
+TEST_CASE( "order_by parallel scaling" ) {
+    auto values = std::vector<std::pair<int, int>>();
+    values.reserve( 10'000'000 );
+
+    for ( int i = 0; i < 10'000'000; ++i )
+        values.emplace_back( static_cast<int>( i * 2654435761LL % 1'000'003 ), i );
+
+    // A pair key is sorted by comparisons rather than by radix sort.
+    const auto by_value = []( const std::pair<int, int>& p ) {
+        return std::pair( p.first, 0 );
+    };
+
+    for ( size_t thread_count = 1; thread_count <= std::max( std::thread::hardware_concurrency(), 1u );
+          thread_count *= 2 ) {
+        linq::set_max_threads( thread_count );
+
+        BENCHMARK( "threads = " + std::to_string( thread_count ) + ", n = 10000000" ) {
+            return linq::from( &values ).order_by_ascending( by_value ).first()->second;
+        };
+    }
+
+    linq::set_max_threads( 0 );
+}
+#endif
@@ -37,10 +37,18 @@
 
 #include <algorithm>
 #include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <initializer_list>
+#include <iterator>
+#include <memory>
 #include <optional>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 // clang-format off
 
@@ -72,10 +80,44 @@
 #  define LINQ_TO_STRING_FUNC std::to_string
 #endif
 
+#ifndef LINQ_RADIX_SORT_THRESHOLD
+#  define LINQ_RADIX_SORT_THRESHOLD 1024
+#endif
+
+#ifndef LINQ_PARALLEL_SORT_THRESHOLD
+#  define LINQ_PARALLEL_SORT_THRESHOLD 65536
+#endif
+
+#ifndef LINQ_BATCH_SIZE
+#  define LINQ_BATCH_SIZE 1024
+#endif
+
+#ifndef LINQ_PARALLEL_THRESHOLD
+#  define LINQ_PARALLEL_THRESHOLD 65536
+#endif
+
+#if !defined( LINQ_NO_SIMD ) && defined( __cpp_lib_is_constant_evaluated )
+#  define LINQ_SIMD_KERNELS
+#  if defined( __x86_64__ ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#    define LINQ_SIMD_DISPATCH
+#  endif
+#endif
+
+#ifndef LINQ_NO_THREADS
+#  include <atomic>
+#  include <exception>
+#  include <mutex>
+#  include <thread>
+#endif
+
 #ifdef __cpp_lib_concepts
 #  include <concepts>
 #endif
 
+#ifdef __cpp_impl_three_way_comparison
+#  include <compare>
+#endif
+
 // clang-format on
 
 namespace linq {
@@ -88,1952 +130,6375 @@ enum class sort_direction {
     descending
 };
 
-namespace details {
-// ----------------------------------
-// Range declaration
-// ----------------------------------
+/// Defines whether sorting ranges preserves the order of equivalent elements.
+enum class sort_stability {
+    /// Equivalent elements keep their relative order.
+    stable,
 
-template <typename TPrevRange, typename TPredicate>
-class where_range;
+    /// Equivalent elements may be reordered, which allows sorting in place.
+    unstable
+};
 
-template <typename TPrevRange>
-class distinct_range;
+/// Describes what is known about the number of elements of a range before it is enumerated.
+/// Buffers are pre-sized to the lower bound only: an upper bound may be far larger than the actual
+/// number of elements, e.g. after filtering a repeated range.
+struct size_hint {
+    /// The minimum number of elements.
+    size_t lower{ 0 };
 
-template <typename TPrevRange, typename TTransform>
-class select_range;
+    /// The maximum number of elements, if known.
+    std::optional<size_t> upper;
 
-template <typename TPrevRange, typename StringType>
-class select_to_string_range;
+    /// A range with exactly count elements.
+    [[nodiscard]]
+    static constexpr auto exact( size_t count ) -> size_hint {
+        return size_hint{ count, count };
+    }
 
-template <typename TPrevRange, typename TTransform>
-class select_many_range;
+    /// A range of unknown size.
+    [[nodiscard]]
+    static constexpr auto unknown() -> size_hint {
+        return size_hint{};
+    }
 
-template <typename TPrevRange>
-class reverse_range;
+    /// Determines whether the number of elements is known exactly.
+    [[nodiscard]]
+    constexpr auto is_exact() const -> bool {
+        return upper.has_value() && *upper == lower;
+    }
 
-template <typename TPrevRange>
-class take_range;
+    /// The hint of a subset of the elements, e.g. after filtering them.
+    [[nodiscard]]
+    constexpr auto filtered() const -> size_hint {
+        return size_hint{ 0, upper };
+    }
 
-template <typename TPrevRange, typename TPredicate>
-class take_while_range;
+    /// The hint of the distinct elements, of which there is at least one if there are any elements.
+    [[nodiscard]]
+    constexpr auto deduplicated() const -> size_hint {
+        return size_hint{ std::min<size_t>( lower, 1 ), upper };
+    }
 
-template <typename TPrevRange>
-class skip_range;
+    /// The hint of at most count of the elements.
+    [[nodiscard]]
+    constexpr auto limited( size_t count ) const -> size_hint {
+        return size_hint{
+            std::min( lower, count ),
+            upper ? std::optional<size_t>( std::min( *upper, count ) ) : std::nullopt };
+    }
 
-template <typename TPrevRange, typename TPredicate>
-class skip_while_range;
+    /// The hint of the elements after skipping count of them.
+    [[nodiscard]]
+    constexpr auto skipped( size_t count ) const -> size_hint {
+        return size_hint{
+            lower - std::min( lower, count ),
+            upper ? std::optional<size_t>( *upper - std::min( *upper, count ) ) : std::nullopt };
+    }
 
-template <typename TPrevRange, typename TOtherRange>
-class append_range;
+    /// The hint of the elements, enumerated times times. Counts that do not fit into size_t
+    /// saturate the lower bound and drop the upper one.
+    [[nodiscard]]
+    constexpr auto repeated( size_t times ) const -> size_hint {
+        return size_hint{
+            multiplied( lower, times ).value_or( max_count ),
+            upper ? multiplied( *upper, times ) : std::nullopt };
+    }
 
-template <typename TPrevRange>
-class repeat_range;
+    /// The hint of two concatenated ranges. Counts that do not fit into size_t saturate the lower
+    /// bound and drop the upper one.
+    [[nodiscard]]
+    constexpr auto operator+( const size_hint& o ) const -> size_hint {
+        return size_hint{
+            added( lower, o.lower ).value_or( max_count ),
+            upper && o.upper ? added( *upper, *o.upper ) : std::nullopt };
+    }
 
-template <
-    typename TPrevRange,
-    typename TOtherRange,
-    typename TKeySelectorA,
-    typename TKeySelectorB,
-    typename TTransform>
-class join_range;
+  private:
+    static constexpr auto max_count = static_cast<size_t>( -1 );
 
-template <typename TPrevRange, typename TKeySelector>
-class order_by_range;
+    static constexpr auto multiplied( size_t a, size_t b ) -> std::optional<size_t> {
+        if ( b != 0 && a > max_count / b )
+            return std::nullopt;
 
-template <typename TPrevRange, typename TKeySelector>
-class then_by_range;
+        return a * b;
+    }
 
-// ----------------------------------
-// Average calculators
-// ----------------------------------
+    static constexpr auto added( size_t a, size_t b ) -> std::optional<size_t> {
+        if ( a > max_count - b )
+            return std::nullopt;
 
-#ifdef __cpp_lib_concepts
-template <typename T>
-concept number = std::integral<T> || std::floating_point<T>;
+        return a + b;
+    }
+};
 
-template <typename T>
-concept averageable = requires( T a, T b, size_t c ) {
-    requires std::is_default_constructible_v<T>;
-    { a / c } -> std::same_as<T>;
-    a += b;
-} || number<T>;
+#ifndef LINQ_NO_THREADS
+namespace details {
+inline std::atomic<size_t> max_thread_count{ 0 };
+} // namespace details
+
+/// Sets the maximum number of threads that linq uses for parallel work, such as sorting large ranges.
+/// This limits the default thread pool, whose workers are started on demand; executors that are passed
+/// to an operation use all of their threads. A value of zero (the default) uses as many threads as the
+/// hardware supports. The default thread pool is sized when it is first used, to the largest of this
+/// maximum, the hardware concurrency and 64 threads; raising the maximum beyond that size later on
+/// has no effect.
+inline void set_max_threads( size_t count ) {
+    details::max_thread_count.store( count, std::memory_order_relaxed );
+}
 
-template <typename T>
-concept addable = requires( T a, T b ) {
-    { a += b } -> std::convertible_to<T>;
-    { a < b } -> std::same_as<bool>;
-} || number<T>;
+/// Gets the maximum number of threads that linq uses for parallel work.
+[[nodiscard]]
+inline auto max_threads() -> size_t {
+    if ( const auto count = details::max_thread_count.load( std::memory_order_relaxed ); count != 0 )
+        return count;
+
+    return std::max( std::thread::hardware_concurrency(), 1u );
+}
+
+class thread_pool;
+
+namespace details {
+// ----------------------------------
+// Executors
+// ----------------------------------
 
+#  ifdef __cpp_lib_concepts
+// An executor runs the tasks of parallel operations. submit( task ) schedules a task, wait( is_done )
+// blocks until is_done() returns true, and concurrency() gets the number of threads that execute tasks.
 template <typename T>
-concept has_fixed_size = requires( T t ) {
-    { t.size() } -> std::same_as<size_t>;
+concept task_executor = requires( T& executor, std::function<void()> task, const std::function<bool()>& is_done ) {
+    executor.submit( std::move( task ) );
+    executor.wait( is_done );
+    { executor.concurrency() } -> std::convertible_to<size_t>;
 };
+#  endif
 
-template <typename T>
-concept has_first_and_second_type = requires {
-    typename T::first_type;
-    typename T::second_type;
+// A task of a thread_pool. Tasks that are submitted from outside the pool are linked into a list.
+struct pool_task {
+    std::function<void()> func;
+    pool_task*            next{};
 };
-#endif
 
-template <typename T, typename TRange>
-#ifdef __cpp_lib_concepts
-    requires( averageable<T> )
-#endif
-static constexpr auto calculate_average( const TRange& op ) {
-    using float_type = long double;
-    using output_t   = typename TRange::output_t;
+// A Chase-Lev deque of tasks: its owner pushes and pops tasks at the bottom, while other threads
+// steal tasks from the top. No operation takes a lock.
+class work_stealing_deque final {
+  public:
+    work_stealing_deque()
+        : m_owned( std::make_unique<buffer>( 32, nullptr ) ) {
+        m_buffer.store( m_owned.get(), std::memory_order_relaxed );
+    }
 
-#ifdef __cpp_lib_concepts
-    using return_t = std::conditional_t<number<output_t>, float_type, output_t>;
-#else
-    using return_t = std::
-        conditional_t<std::is_integral<output_t>::value || std::is_floating_point_v<output_t>, float_type, output_t>;
-#endif
+    // Pushes a task; only called by the owner.
+    void push( pool_task* task ) {
+        const auto bottom = m_bottom.load( std::memory_order_relaxed );
+        const auto top    = m_top.load( std::memory_order_acquire );
+        auto*      tasks  = m_owned.get();
 
-    if ( const auto maybe_sum_and_count = op.sum_and_count() ) {
-        const auto& sum_and_count = *maybe_sum_and_count;
-        return std::optional<return_t>( static_cast<return_t>( sum_and_count.first ) / sum_and_count.second );
+        if ( bottom - top >= static_cast<int64_t>( tasks->capacity ) ) {
+            // Thieves may still read the previous buffer, so it is kept alive by the new one.
+            auto grown = std::make_unique<buffer>( tasks->capacity * 2, std::move( m_owned ) );
+
+            for ( auto i = top; i < bottom; ++i )
+                grown->slot( i ).store( tasks->slot( i ).load( std::memory_order_relaxed ), std::memory_order_relaxed );
+
+            m_owned = std::move( grown );
+            tasks   = m_owned.get();
+            m_buffer.store( tasks, std::memory_order_release );
+        }
+
+        tasks->slot( bottom ).store( task, std::memory_order_relaxed );
+        m_bottom.store( bottom + 1, std::memory_order_release );
     }
 
-    return std::optional<return_t>();
-}
+    // Pops the most recently pushed task, or returns null; only called by the owner.
+    auto pop() -> pool_task* {
+        const auto bottom = m_bottom.load( std::memory_order_relaxed ) - 1;
+        auto*      tasks  = m_owned.get();
 
-// ----------------------------------
-// base_range
-// ----------------------------------
+        m_bottom.store( bottom, std::memory_order_seq_cst );
+        auto top = m_top.load( std::memory_order_seq_cst );
 
-/// Base class to identify all range types (for compile-time type checking).
-class range_ident {
-    // Nothing to define here.
-};
+        if ( top > bottom ) {
+            m_bottom.store( bottom + 1, std::memory_order_relaxed );
+            return nullptr;
+        }
 
-/// Base class for sorting ranges (for compile-time type checking).
-class sorting_range {
-    // Nothing to define here.
-};
+        auto* task = tasks->slot( bottom ).load( std::memory_order_relaxed );
 
-template <typename Range>
-static constexpr auto get_range_size( const Range& range ) -> size_t
-    requires( has_fixed_size<Range> )
-{
-    return range.size();
-}
+        if ( top == bottom ) {
+            // The last task, which a thief may take at the same time.
+            if ( !m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+                task = nullptr;
 
-/// @brief Represents the base class of all linq ranges.
-/// @tparam TOutput The full, unmodified type that is returned by the range.
-template <typename Derived, typename TOutput>
-class range : public range_ident {
-  public:
-    /// Return non-const, non-volatile, non-reference types from methods such as sum, min and max.
-    using output_t = std::decay_t<TOutput>;
+            m_bottom.store( bottom + 1, std::memory_order_relaxed );
+        }
 
-    /// @brief Appends a filter to the range.
-    /// @tparam TPredicate The type of the predicate: f(x) -> bool
-    /// @param predicate The predicate
-    /// @return A new range that combines this range with the where-range
-    template <typename TPredicate>
-    [[nodiscard]]
-    constexpr auto where( TPredicate&& predicate ) const;
+        return task;
+    }
 
-    /// @brief Appends a distinct-filter to the range that removes duplicate elements.
-    /// @return A new range that combines this range with the distinct-range
-    [[nodiscard]]
-    constexpr auto distinct() const;
+    // Steals the least recently pushed task, or returns null; called by any thread.
+    auto steal() -> pool_task* {
+        auto       top    = m_top.load( std::memory_order_seq_cst );
+        const auto bottom = m_bottom.load( std::memory_order_seq_cst );
 
-    template <typename TTransform>
-    [[nodiscard]]
-    constexpr auto select( TTransform&& transform ) const;
+        if ( top >= bottom )
+            return nullptr;
 
-#ifdef LINQ_NO_STL_CONTAINERS
-    template <typename StringType>
-#endif
-    [[nodiscard]]
-    constexpr auto
-    select_to_string( int int_base = 10, std::chars_format float_format = std::chars_format::general ) const;
+        auto* task = m_buffer.load( std::memory_order_acquire )->slot( top ).load( std::memory_order_relaxed );
 
-    template <typename TTransform>
-    [[nodiscard]]
-    constexpr auto select_many( TTransform&& transform ) const;
+        if ( !m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+            return nullptr;
 
-    [[nodiscard]]
-    constexpr auto reverse() const;
+        return task;
+    }
 
-    [[nodiscard]]
-    constexpr auto take( size_t count ) const;
+  private:
+    struct buffer {
+        buffer( size_t capacity, std::unique_ptr<buffer> previous )
+            : capacity( capacity )
+            , slots( new std::atomic<pool_task*>[capacity] )
+            , previous( std::move( previous ) ) {
+        }
 
-    template <typename TPredicate>
-    [[nodiscard]]
-    constexpr auto take_while( TPredicate&& predicate ) const;
+        auto slot( int64_t index ) -> std::atomic<pool_task*>& {
+            return slots[static_cast<size_t>( index ) & ( capacity - 1 )];
+        }
 
-    [[nodiscard]]
-    constexpr auto skip( size_t count ) const;
+        size_t                                      capacity;
+        std::unique_ptr<std::atomic<pool_task*>[]> slots;
+        std::unique_ptr<buffer>                     previous;
+    };
 
-    template <typename TPredicate>
-    [[nodiscard]]
-    constexpr auto skip_while( TPredicate&& predicate ) const;
+    std::atomic<int64_t>    m_top{ 0 };
+    std::atomic<int64_t>    m_bottom{ 0 };
+    std::atomic<buffer*>    m_buffer{};
+    std::unique_ptr<buffer> m_owned;
+};
 
-    template <typename TOtherRange>
-    [[nodiscard]]
-    constexpr auto append( const TOtherRange& other_range ) const;
+// The pool and worker index of the current thread, if it is a worker of a thread_pool.
+inline thread_local const thread_pool* current_pool   = nullptr;
+inline thread_local size_t             current_worker = 0;
 
-    [[nodiscard]]
-    constexpr auto repeat( size_t count ) const;
+inline auto default_thread_pool() -> thread_pool&;
+} // namespace details
 
-    template <typename TOtherRange, typename TKeySelectorA, typename TKeySelectorB, typename TTransform>
-    [[nodiscard]]
-    constexpr auto join(
-        const TOtherRange& other_range,
-        TKeySelectorA&&    key_selector_a,
-        TKeySelectorB&&    key_selector_b,
-        TTransform&&       transform ) const;
+/// @brief A work-stealing thread pool, which executes the parallel operations of linq by default.
+/// Every worker thread owns a deque of tasks: tasks that a worker submits are pushed onto its own deque,
+/// and idle workers steal tasks from the deques of the others. Tasks that other threads submit are taken
+/// over by the next idle worker. Threads that wait for tasks execute pending tasks meanwhile, so that nested
+/// parallel operations share the workers of the pool instead of starting more threads.
+class thread_pool final {
+  public:
+    /// Creates a pool of worker_count worker threads.
+    explicit thread_pool( size_t worker_count )
+        : thread_pool( worker_count, false ) {
+        start_workers( worker_count );
+    }
 
-    template <typename TKeySelector>
-    [[nodiscard]]
-    constexpr auto order_by( TKeySelector&& key_selector, sort_direction sort_dir ) const;
+    thread_pool( const thread_pool& )                    = delete;
+    auto operator=( const thread_pool& ) -> thread_pool& = delete;
 
-    template <typename TKeySelector>
-    [[nodiscard]]
-    constexpr auto order_by_ascending( TKeySelector&& key_selector ) const;
+    /// Finishes the pending tasks and stops the workers.
+    ~thread_pool() {
+        m_is_stopping.store( true, std::memory_order_seq_cst );
+        wake_workers( true );
 
-    template <typename TKeySelector>
-    [[nodiscard]]
-    constexpr auto order_by_descending( TKeySelector&& key_selector ) const;
+        for ( size_t i = 0; i < m_started.load( std::memory_order_relaxed ); ++i )
+            m_workers[i].thread.join();
 
-    template <typename TKeySelector>
-    [[nodiscard]]
-    constexpr auto then_by( TKeySelector&& key_selector, sort_direction sort_dir ) const;
+        // Without workers, tasks that no thread waited for were never taken.
+        for ( auto* task = m_submitted.exchange( nullptr ); task != nullptr; ) {
+            auto* const next = task->next;
+            delete task;
+            task = next;
+        }
+    }
 
-    template <typename TKeySelector>
-    [[nodiscard]]
-    constexpr auto then_by_ascending( TKeySelector&& key_selector ) const;
+    /// Schedules a task. Tasks must not throw exceptions.
+    void submit( std::function<void()> task ) {
+        if ( m_follows_max_threads )
+            start_workers( std::min( max_threads(), m_capacity + 1 ) - 1 );
 
-    template <typename TKeySelector>
-    [[nodiscard]]
-    constexpr auto then_by_descending( TKeySelector&& key_selector ) const;
+        auto* const pool_task = new details::pool_task{ std::move( task ), nullptr };
 
-    [[nodiscard]]
-    constexpr auto sum() const;
+        if ( details::current_pool == this ) {
+            m_workers[details::current_worker].deque.push( pool_task );
+        }
+        else {
+            pool_task->next = m_submitted.load( std::memory_order_relaxed );
 
-    [[nodiscard]]
-    constexpr auto min() const;
+            while ( !m_submitted.compare_exchange_weak( pool_task->next, pool_task, std::memory_order_release ) ) {
+                // Retry with the new head.
+            }
+        }
 
-    [[nodiscard]]
-    constexpr auto max() const;
+        wake_workers( false );
+    }
 
-    [[nodiscard]]
-    constexpr auto sum_and_count() const;
+    /// Blocks until is_done() returns true, executing pending tasks meanwhile. Without pending tasks, the thread
+    /// sleeps until a task is submitted or finishes, so is_done() must become true through a task of the pool.
+    void wait( const std::function<bool()>& is_done ) {
+        const auto worker = details::current_pool == this ? details::current_worker : no_worker;
 
-    [[nodiscard]]
-    constexpr auto average() const
-#ifdef __cpp_lib_concepts
-        requires( averageable<output_t> )
-#endif
-    ;
+        for ( ;; ) {
+            // Reading the epoch first ensures that tasks submitted or finished after the checks wake this thread up.
+            const auto epoch = m_epoch.load( std::memory_order_seq_cst );
 
-#ifdef __cpp_lib_concepts
-    template <typename TSeed, std::invocable<TSeed&&, const TOutput&> TAccumFunc>
-#else
-    template <typename TSeed, typename TAccumFunc>
-#endif
-    [[nodiscard]]
-    constexpr auto aggregate( TSeed seed, TAccumFunc&& func ) const;
+            if ( is_done() )
+                return;
 
-#ifdef __cpp_lib_concepts
-    template <std::invocable<TOutput&&, const TOutput&> TAccumFunc>
-#else
-    template <typename TAccumFunc>
-#endif
-    [[nodiscard]]
-    constexpr auto reduce( const TAccumFunc& func ) const;
+            if ( auto* const task = take_task( worker ) ) {
+                execute( task );
+                continue;
+            }
 
-    [[nodiscard]]
-    constexpr auto first() const -> std::optional<output_t>;
+            // Finished tasks only advance the epoch while threads are waiting, so check again after registering.
+            m_waiting.fetch_add( 1, std::memory_order_acq_rel );
 
-    template <typename TPredicate>
-    [[nodiscard]]
-    constexpr auto first( const TPredicate& predicate ) const -> std::optional<output_t>;
+            if ( !is_done() )
+                wait_for_epoch( epoch );
 
-    [[nodiscard]]
-    constexpr auto last() const -> std::optional<output_t>;
+            m_waiting.fetch_sub( 1, std::memory_order_relaxed );
+        }
+    }
 
-    template <typename TPredicate>
+    /// Gets the number of threads that execute tasks: the workers and the thread that waits for them.
     [[nodiscard]]
-    constexpr auto last( const TPredicate& predicate ) const -> std::optional<output_t>;
+    auto concurrency() const -> size_t {
+        if ( m_follows_max_threads )
+            return std::min( max_threads(), m_capacity + 1 );
 
-    template <typename TPredicate>
-    [[nodiscard]]
-    constexpr auto any( const TPredicate& predicate ) const -> bool;
+        return m_capacity + 1;
+    }
 
-    template <typename TPredicate>
-    [[nodiscard]]
-    constexpr auto all( const TPredicate& predicate ) const -> bool;
+  private:
+    friend auto details::default_thread_pool() -> thread_pool&;
 
-    template <typename TPredicate>
-    [[nodiscard]]
-    constexpr auto none( const TPredicate& predicate ) const -> bool;
+    static constexpr size_t no_worker = SIZE_MAX;
 
-    [[nodiscard]]
-    constexpr auto count() const -> size_t;
+    struct worker {
+        details::work_stealing_deque deque;
+        std::thread                  thread;
+    };
 
-    template <typename TPredicate>
-    [[nodiscard]]
-    constexpr auto count( const TPredicate& predicate ) const -> size_t;
+    // Creates a pool that can hold up to capacity workers, none of which are started yet.
+    thread_pool( size_t capacity, bool follows_max_threads )
+        : m_workers( std::make_unique<worker[]>( capacity ) )
+        , m_capacity( capacity )
+        , m_follows_max_threads( follows_max_threads ) {
+    }
 
-    [[nodiscard]]
-    constexpr auto element_at( size_t index ) const -> std::optional<output_t>;
+    void start_workers( size_t count ) {
+        if ( m_started.load( std::memory_order_acquire ) >= count )
+            return;
 
-    template <typename U>
-    constexpr auto equals( const range<U, TOutput>& other_range ) const -> bool;
+        const auto lock = std::lock_guard( m_start_mutex );
 
-    constexpr auto equals( const std::initializer_list<TOutput>& list ) const -> bool;
+        for ( auto i = m_started.load( std::memory_order_relaxed ); i < count; ++i ) {
+            m_workers[i].thread = std::thread( [this, i]() {
+                run_worker( i );
+            } );
 
-#ifndef LINQ_NO_STL_CONTAINERS
+            // Thieves only look at the deques of started workers.
+            m_started.store( i + 1, std::memory_order_release );
+        }
+    }
 
-    [[nodiscard]]
-    auto to_vector() const -> std::vector<output_t>;
+    void run_worker( size_t index ) {
+        details::current_pool   = this;
+        details::current_worker = index;
 
-    [[nodiscard]]
-    auto to_map() const
-#ifdef __cpp_lib_concepts
-        requires( has_first_and_second_type<output_t> )
-#endif
-    ;
+        for ( ;; ) {
+            // Reading the epoch first ensures that tasks submitted after the search wake this worker up.
+            const auto epoch = m_epoch.load( std::memory_order_seq_cst );
 
-    [[nodiscard]]
-    auto to_unordered_map() const
-#ifdef __cpp_lib_concepts
-        requires( has_first_and_second_type<output_t> )
-#endif
-    ;
+            if ( auto* const task = take_task( index ) ) {
+                execute( task );
+                continue;
+            }
 
-#endif // LINQ_NO_STL_CONTAINERS
+            if ( m_is_stopping.load( std::memory_order_seq_cst ) )
+                break;
 
-  private:
-    constexpr auto self_ref() {
-        return static_cast<Derived&>( *this );
+            wait_for_epoch( epoch );
+        }
     }
 
-    constexpr auto self_ref() const {
-        return static_cast<const Derived&>( *this );
+    // Blocks until the epoch differs from the given one, i.e. until tasks were submitted or finished.
+    void wait_for_epoch( uint32_t epoch ) const {
+#  ifdef __cpp_lib_atomic_wait
+        m_epoch.wait( epoch, std::memory_order_seq_cst );
+#  else
+        if ( m_epoch.load( std::memory_order_seq_cst ) == epoch )
+            std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+#  endif
     }
-};
 
-// ----------------------------------
-// where
-// ----------------------------------
+    auto take_task( size_t worker ) -> details::pool_task* {
+        if ( worker != no_worker ) {
+            if ( auto* const task = m_workers[worker].deque.pop() )
+                return task;
+        }
 
-template <typename TPrevRange, typename TPredicate>
-class where_range final : public range<where_range<TPrevRange, TPredicate>, typename TPrevRange::iterator::output_t> {
-  public:
-    struct iterator {
-        using prev_iter_t = typename TPrevRange::iterator;
-        using output_t    = typename prev_iter_t::output_t;
+        if ( auto* const task = take_submitted( worker ) )
+            return task;
 
-        constexpr iterator( const where_range* parent, prev_iter_t begin, prev_iter_t end )
-            : m_parent( parent )
-            , m_begin( begin )
-            , m_end( end ) {
-            const auto& pred = m_parent->m_predicate;
+        const auto started = m_started.load( std::memory_order_acquire );
+        const auto first   = worker != no_worker ? worker + 1 : 0;
 
-            // Seek the first match.
-            while ( m_begin != m_end && !std::invoke( pred, *m_begin ) )
-                ++m_begin;
-        }
+        for ( size_t i = 0; i < started; ++i ) {
+            const auto victim = ( first + i ) % started;
 
-        constexpr bool operator==( const iterator& o ) const {
-            return m_begin == o.m_begin;
+            if ( victim == worker )
+                continue;
+
+            if ( auto* const task = m_workers[victim].deque.steal() )
+                return task;
         }
 
-        constexpr bool operator!=( const iterator& o ) const {
-            return m_begin != o.m_begin;
+        return nullptr;
+    }
+
+    // Takes the oldest of the tasks that were submitted from outside the pool. A worker moves the
+    // others onto its deque, where idle workers can steal them; other threads submit them again.
+    auto take_submitted( size_t worker ) -> details::pool_task* {
+        if ( m_submitted.load( std::memory_order_relaxed ) == nullptr )
+            return nullptr;
+
+        auto* list = m_submitted.exchange( nullptr, std::memory_order_acquire );
+
+        if ( list == nullptr )
+            return nullptr;
+
+        // The list is in reverse order of submission.
+        auto* oldest = static_cast<details::pool_task*>( nullptr );
+
+        while ( list != nullptr ) {
+            auto* const next = list->next;
+            list->next       = oldest;
+            oldest           = list;
+            list             = next;
         }
 
-        constexpr iterator& operator++() {
-            const auto& pred = m_parent->m_predicate;
+        auto* const rest = oldest->next;
 
-            do {
-                ++m_begin;
-            } while ( m_begin != m_end && !std::invoke( pred, *m_begin ) );
+        if ( rest == nullptr )
+            return oldest;
 
-            return *this;
+        if ( worker != no_worker ) {
+            for ( auto* task = rest; task != nullptr; task = task->next )
+                m_workers[worker].deque.push( task );
         }
+        else {
+            auto* last = rest;
 
-        constexpr auto operator*() const -> const output_t& {
-            return *m_begin;
+            while ( last->next != nullptr )
+                last = last->next;
+
+            last->next = m_submitted.load( std::memory_order_relaxed );
+
+            while ( !m_submitted.compare_exchange_weak( last->next, rest, std::memory_order_release ) ) {
+                // Retry with the new head.
+            }
         }
 
-        const where_range* m_parent;
-        prev_iter_t        m_begin;
-        prev_iter_t        m_end;
-    };
+        wake_workers( false );
+        return oldest;
+    }
 
-    constexpr where_range() = default;
+    void wake_workers( bool all ) {
+        m_epoch.fetch_add( 1, std::memory_order_seq_cst );
 
-    constexpr where_range( const TPrevRange& prev, TPredicate predicate )
-        : m_prev( prev )
-        , m_predicate( std::move( predicate ) ) {
+#  ifdef __cpp_lib_atomic_wait
+        if ( all )
+            m_epoch.notify_all();
+        else
+            m_epoch.notify_one();
+#  else
+        static_cast<void>( all );
+#  endif
     }
 
-    constexpr auto begin() const -> iterator {
-        return iterator( this, m_prev.begin(), m_prev.end() );
+    void execute( details::pool_task* task ) noexcept {
+        task->func();
+        delete task;
+
+        // Threads in wait() may be waiting for this task. Unlike a load, the read-modify-write either sees a thread
+        // that registered in wait(), or that thread's registration synchronizes with it and sees what the task did.
+        if ( m_waiting.fetch_add( 0, std::memory_order_acq_rel ) != 0 )
+            wake_workers( true );
     }
 
-    constexpr auto end() const -> iterator {
-        const auto prev_end = m_prev.end();
-        return iterator( this, prev_end, prev_end );
+    std::unique_ptr<worker[]>        m_workers;
+    size_t                           m_capacity{};
+    bool                             m_follows_max_threads{};
+    std::atomic<size_t>              m_started{ 0 };
+    std::atomic<details::pool_task*> m_submitted{ nullptr };
+    std::atomic<uint32_t>            m_epoch{ 0 };
+    std::atomic<size_t>              m_waiting{ 0 };
+    std::atomic<bool>                m_is_stopping{ false };
+    std::mutex                       m_start_mutex;
+};
+
+namespace details {
+// The thread pool that executes parallel operations unless another executor is given. Its workers are
+// started on demand, up to max_threads() - 1, since the thread that waits for a task helps executing it.
+// Its capacity is fixed when it is first used (see set_max_threads).
+inline auto default_thread_pool() -> thread_pool& {
+    static auto pool = thread_pool(
+        std::max<size_t>( { max_threads(), std::thread::hardware_concurrency(), 64 } ) - 1,
+        true );
+    return pool;
+}
+} // namespace details
+#endif
+
+namespace details {
+// A non-owning reference to an executor. A default-constructed reference refers to the default executor,
+// see linq::set_default_executor.
+class executor_ref final {
+  public:
+    constexpr executor_ref() = default;
+
+#ifndef LINQ_NO_THREADS
+    // References are copied rather than nested.
+    template <
+        typename TExecutor,
+        typename = std::enable_if_t<!std::is_same_v<std::remove_const_t<TExecutor>, executor_ref>>>
+#  ifdef __cpp_lib_concepts
+        requires( task_executor<TExecutor> )
+#  endif
+    executor_ref( TExecutor& executor ) // NOLINT(*-explicit-constructor)
+        : m_executor( std::addressof( executor ) )
+        , m_table( &table_of<TExecutor> ) {
+    }
+
+    void submit( std::function<void()> task ) const {
+        m_table->submit( m_executor, std::move( task ) );
+    }
+
+    void wait( const std::function<bool()>& is_done ) const {
+        m_table->wait( m_executor, is_done );
+    }
+
+    [[nodiscard]]
+    auto concurrency() const -> size_t {
+        return m_table->concurrency( m_executor );
     }
 
+    [[nodiscard]]
+    auto is_default() const -> bool {
+        return m_executor == nullptr;
+    }
+
+    // Gets the executor that this reference refers to, resolving the default executor.
+    [[nodiscard]]
+    inline auto resolve() const -> executor_ref;
+
   private:
-    TPrevRange m_prev;
-    TPredicate m_predicate;
+    struct table {
+        void ( *submit )( void*, std::function<void()>&& );
+        void ( *wait )( void*, const std::function<bool()>& );
+        size_t ( *concurrency )( void* );
+    };
+
+    template <typename TExecutor>
+    static constexpr table table_of{
+        []( void* executor, std::function<void()>&& task ) {
+            static_cast<TExecutor*>( executor )->submit( std::move( task ) );
+        },
+        []( void* executor, const std::function<bool()>& is_done ) {
+            static_cast<TExecutor*>( executor )->wait( is_done );
+        },
+        []( void* executor ) -> size_t {
+            return static_cast<TExecutor*>( executor )->concurrency();
+        } };
+
+    void*        m_executor{};
+    const table* m_table{};
+#else
+    // Without threads, all work is performed on the calling thread.
+    [[nodiscard]]
+    constexpr auto concurrency() const -> size_t {
+        return 1;
+    }
+
+    [[nodiscard]]
+    constexpr auto resolve() const -> executor_ref {
+        return *this;
+    }
+#endif
 };
 
-// ----------------------------------
-// distinct
-// ----------------------------------
+#ifndef LINQ_NO_THREADS
+inline std::mutex   default_executor_mutex;
+inline executor_ref default_executor;
 
-template <typename TPrevRange>
-class distinct_range final : public range<distinct_range<TPrevRange>, typename TPrevRange::iterator::output_t> {
-    using prev_iter_t      = typename TPrevRange::iterator;
-    using object_container = std::vector<prev_iter_t>;
+inline auto executor_ref::resolve() const -> executor_ref {
+    if ( !is_default() )
+        return *this;
 
-  public:
-    struct iterator {
-        using output_t = typename prev_iter_t::output_t;
+    {
+        const auto lock = std::lock_guard( default_executor_mutex );
 
-        constexpr iterator( prev_iter_t begin, prev_iter_t end, object_container* encountered_objects )
-            : m_begin( begin )
-            , m_end( end )
-            , m_encountered_objects( encountered_objects ) {
-            if ( m_begin != m_end ) {
-                encountered_objects->clear();
-                encountered_objects->push_back( m_begin );
-            }
-        }
+        if ( !default_executor.is_default() )
+            return default_executor;
+    }
 
-        constexpr bool operator==( const iterator& o ) const {
-            return m_begin == o.m_begin;
-        }
+    return executor_ref( default_thread_pool() );
+}
 
-        constexpr bool operator!=( const iterator& o ) const {
-            return m_begin != o.m_begin;
-        }
+// Executes first() and second() concurrently: second() is submitted to the executor, while the calling
+// thread executes first(). If no thread has started second() by then, the calling thread executes it
+// as well, so that waiting never depends on an idle thread of the executor. Exceptions are rethrown.
+template <typename TFirst, typename TSecond>
+void fork_join( const executor_ref& executor, const TFirst& first, const TSecond& second ) {
+    enum status : int { pending, started, done };
+
+    struct state_t {
+        std::atomic<int>   status{ pending };
+        const TSecond*     second{};
+        std::exception_ptr exception;
+    };
 
-        constexpr iterator& operator++() {
-            do {
-                ++m_begin;
-            } while ( m_begin != m_end && contains_object( m_begin ) );
+    // The submitted task may run after this function returned, and must then only touch the state.
+    const auto state = std::make_shared<state_t>();
+    state->second    = std::addressof( second );
 
-            if ( m_begin != m_end )
-                m_encountered_objects->push_back( m_begin );
+    executor.submit( [state]() {
+        auto expected = int( pending );
 
-            return *this;
+        if ( !state->status.compare_exchange_strong( expected, started, std::memory_order_acquire ) )
+            return;
+
+        try {
+            ( *state->second )();
+        }
+        catch ( ... ) {
+            state->exception = std::current_exception();
         }
 
-        constexpr bool contains_object( const prev_iter_t& it ) {
-            const auto& it_val = *it;
+        state->status.store( done, std::memory_order_release );
+    } );
 
-            const auto&  encountered_objects = *m_encountered_objects;
-            const size_t size                = encountered_objects.size();
+    auto exception = std::exception_ptr();
 
-            for ( size_t i = 0; i < size; ++i ) {
-                if ( *encountered_objects[i] == it_val )
-                    return true;
-            }
+    try {
+        first();
+    }
+    catch ( ... ) {
+        exception = std::current_exception();
+    }
 
-            return false;
-        }
+    auto expected = int( pending );
 
-        constexpr const output_t& operator*() const {
-            return *m_begin;
-        }
+    if ( state->status.compare_exchange_strong( expected, started, std::memory_order_acquire ) ) {
+        if ( !exception )
+            second();
+    }
+    else {
+        executor.wait( [&state]() {
+            return state->status.load( std::memory_order_acquire ) == done;
+        } );
 
-        prev_iter_t       m_begin;
-        prev_iter_t       m_end;
-        object_container* m_encountered_objects;
-    };
+        if ( !exception )
+            exception = state->exception;
+    }
 
-    constexpr distinct_range() = default;
+    if ( exception )
+        std::rethrow_exception( exception );
+}
 
-    constexpr explicit distinct_range( const TPrevRange& prev )
-        : m_prev( prev ) {
+// Executes func( task ) for every task in [first, last), splitting the range in halves recursively.
+template <typename TFunc>
+void fork_join_tasks( const executor_ref& executor, size_t first, size_t last, const TFunc& func ) {
+    if ( last - first == 1 ) {
+        func( first );
+        return;
     }
 
-    constexpr iterator begin() const {
-        return iterator{ m_prev.begin(), m_prev.end(), std::addressof( m_encountered_objects ) };
+    const auto middle = first + ( last - first ) / 2;
+
+    fork_join(
+        executor,
+        [&]() {
+            fork_join_tasks( executor, first, middle, func );
+        },
+        [&]() {
+            fork_join_tasks( executor, middle, last, func );
+        } );
+}
+#endif
+
+// Executes func( task ) for every task in [0, task_count) on up to thread_count threads of an executor.
+// The tasks are split in halves recursively: one half is submitted to the executor, while the current
+// thread continues with the other. Nested parallel operations thereby share the threads of the executor.
+// Once func returns false, no further tasks are started.
+template <typename TFunc>
+void run_tasks( const executor_ref& executor, size_t task_count, size_t thread_count, const TFunc& func ) {
+#ifndef LINQ_NO_THREADS
+    if ( thread_count > 1 && task_count > 1 ) {
+        const auto resolved   = executor.resolve();
+        auto       is_stopped = std::atomic<bool>( false );
+
+        fork_join_tasks( resolved, 0, task_count, [&]( size_t task ) {
+            if ( !is_stopped.load( std::memory_order_relaxed ) && !func( task ) )
+                is_stopped.store( true, std::memory_order_relaxed );
+        } );
+
+        return;
     }
+#else
+    static_cast<void>( executor );
+    static_cast<void>( thread_count );
+#endif
 
-    constexpr iterator end() const {
-        const auto prev_end = m_prev.end();
-        return iterator{ prev_end, prev_end, std::addressof( m_encountered_objects ) };
+    for ( size_t task = 0; task < task_count; ++task ) {
+        if ( !func( task ) )
+            break;
     }
+}
+} // namespace details
+
+#ifndef LINQ_NO_THREADS
+/// @brief Sets the executor of the parallel operations that are not given one, and of parallel sorting.
+/// The executor must outlive its use by linq; see linq::thread_pool for the requirements of an executor.
+template <typename TExecutor>
+#  ifdef __cpp_lib_concepts
+    requires( details::task_executor<TExecutor> )
+#  endif
+void set_default_executor( TExecutor& executor ) {
+    const auto lock           = std::lock_guard( details::default_executor_mutex );
+    details::default_executor = details::executor_ref( executor );
+}
 
-  private:
-    TPrevRange               m_prev;
-    mutable object_container m_encountered_objects;
-};
+/// Makes the built-in thread pool the default executor again.
+inline void reset_default_executor() {
+    const auto lock           = std::lock_guard( details::default_executor_mutex );
+    details::default_executor = details::executor_ref();
+}
+#endif
 
+namespace details {
 // ----------------------------------
-// select
+// Range declaration
 // ----------------------------------
 
-// Resolves the arguments that are passed to a select functor.
-template <typename TPrevRange>
-using select_transform_arg_t = std::add_const_t<std::add_lvalue_reference_t<typename TPrevRange::iterator::output_t>>;
+template <typename TPrevRange, typename TPredicate>
+class where_range;
+
+template <typename TPrevRange>
+class distinct_range;
+
+template <typename TPrevRange, typename THash, typename TEqual>
+class hash_distinct_range;
 
-// Resolves the return type of a select functor.
 template <typename TPrevRange, typename TTransform>
-using select_output_t = std::invoke_result_t<TTransform, select_transform_arg_t<TPrevRange>>;
+class select_range;
+
+template <typename TPrevRange, typename StringType>
+class select_to_string_range;
+
+template <typename TPrevRange, typename TTransform>
+class select_many_range;
+
+template <typename TPrevRange>
+class reverse_range;
+
+template <typename TPrevRange>
+class take_range;
+
+template <typename TPrevRange, typename TPredicate>
+class take_while_range;
+
+template <typename TPrevRange>
+class skip_range;
+
+template <typename TPrevRange, typename TPredicate>
+class skip_while_range;
+
+template <typename TPrevRange, typename TOtherRange>
+class append_range;
+
+template <typename TPrevRange>
+class repeat_range;
+
+template <typename TPrevRange>
+class batched_range;
+
+template <typename TPrevRange>
+class cache_range;
+
+template <typename TSource, typename TQuery>
+class parallel_range;
+
+template <
+    typename TPrevRange,
+    typename TOtherRange,
+    typename TKeySelectorA,
+    typename TKeySelectorB,
+    typename TTransform>
+class join_range;
+
+template <
+    typename TPrevRange,
+    typename TOtherRange,
+    typename TKeySelectorA,
+    typename TKeySelectorB,
+    typename TTransform>
+class hash_join_range;
+
+template <
+    typename TPrevRange,
+    typename TOtherRange,
+    typename TKeySelectorA,
+    typename TKeySelectorB,
+    typename TTransform>
+class merge_join_range;
+
+template <typename TPrevRange, typename TKeySelector>
+class group_by_range;
+
+template <typename TPrevRange, typename TKeySelector>
+class order_by_range;
+
+template <typename TPrevRange, typename TKeySelector>
+class then_by_range;
+
+template <typename TContainer>
+class container_range;
+
+template <typename TContainer>
+class mutable_container_range;
+
+template <typename T>
+class from_to_range;
+
+/// Selects the parallel overload of an operation, see linq::parallel.
+struct parallel_tag {
+#ifndef LINQ_NO_THREADS
+    /// Selects the parallel overload of an operation, executed by the given executor.
+    template <typename TExecutor>
+#  ifdef __cpp_lib_concepts
+        requires( task_executor<TExecutor> )
+#  endif
+    [[nodiscard]]
+    auto on( TExecutor& executor ) const -> parallel_tag {
+        return parallel_tag{ executor_ref( executor ) };
+    }
+#endif
+
+    executor_ref executor;
+};
+
+// ----------------------------------
+// Average calculators
+// ----------------------------------
+
+#ifdef __cpp_lib_concepts
+template <typename T>
+concept number = std::integral<T> || std::floating_point<T>;
+
+template <typename T>
+concept averageable = requires( T a, T b, size_t c ) {
+    requires std::is_default_constructible_v<T>;
+    { a / c } -> std::same_as<T>;
+    a += b;
+} || number<T>;
+
+template <typename T>
+concept addable = requires( T a, T b ) {
+    { a += b } -> std::convertible_to<T>;
+    { a < b } -> std::same_as<bool>;
+} || number<T>;
+
+template <typename T>
+concept has_fixed_size = requires( T t ) {
+    { t.size() } -> std::same_as<size_t>;
+};
+
+template <typename T>
+concept has_first_and_second_type = requires {
+    typename T::first_type;
+    typename T::second_type;
+};
+
+// A range whose iterators can move backwards, including from the end iterator.
+template <typename T>
+concept bidirectional_range = requires( typename T::iterator it ) {
+    { --it } -> std::same_as<typename T::iterator&>;
+};
+
+// A range whose iterators can move forward by any number of elements in constant time,
+// and whose distance can be determined in constant time.
+template <typename T>
+concept random_access_range = requires( typename T::iterator it, const typename T::iterator& other, std::ptrdiff_t n ) {
+    { it += n } -> std::same_as<typename T::iterator&>;
+    { other - other } -> std::same_as<std::ptrdiff_t>;
+};
+
+// A range whose elements are stored in one contiguous array.
+template <typename T>
+concept contiguous_range = requires( const T& range ) {
+    { range.data() } -> std::same_as<const typename T::output_t*>;
+    { range.size() } -> std::same_as<size_t>;
+};
+
+template <typename T>
+struct is_from_to_range : std::false_type {};
+
+template <typename T>
+struct is_from_to_range<from_to_range<T>> : std::true_type {};
+
+// A range that can be split into parts in constant time, e.g. to process the parts on multiple threads.
+template <typename T>
+concept partitionable_range = has_fixed_size<T> && ( random_access_range<T> || is_from_to_range<T>::value );
+#endif
+
+/// Determines whether std::hash is enabled for a type.
+template <typename T, typename = void>
+struct is_hashable : std::false_type {};
+
+template <typename T>
+struct is_hashable<T, std::void_t<decltype( std::hash<T>()( std::declval<const T&>() ) )>> : std::true_type {};
+
+template <typename T>
+static constexpr bool is_hashable_v = is_hashable<T>::value;
+
+template <typename T, typename TRange>
+#ifdef __cpp_lib_concepts
+    requires( averageable<T> )
+#endif
+static constexpr auto calculate_average( const TRange& op ) {
+    using float_type = long double;
+    using output_t   = typename TRange::output_t;
+
+#ifdef __cpp_lib_concepts
+    using return_t = std::conditional_t<number<output_t>, float_type, output_t>;
+#else
+    using return_t = std::
+        conditional_t<std::is_integral<output_t>::value || std::is_floating_point_v<output_t>, float_type, output_t>;
+#endif
+
+    if ( const auto maybe_sum_and_count = op.sum_and_count() ) {
+        const auto& sum_and_count = *maybe_sum_and_count;
+        return std::optional<return_t>( static_cast<return_t>( sum_and_count.first ) / sum_and_count.second );
+    }
+
+    return std::optional<return_t>();
+}
+
+// ----------------------------------
+// aggregators (linq::agg)
+// ----------------------------------
+
+// An aggregator describes a running state for elements of type T: add() folds an element into it
+// and result() produces the aggregate. aggregate_all() feeds every element into all states at once.
+
+struct count_aggregator {
+    template <typename T>
+    struct state {
+        constexpr void add( const T& ) {
+            ++m_count;
+        }
+
+        constexpr auto result() const -> size_t {
+            return m_count;
+        }
+
+        size_t m_count{};
+    };
+};
+
+struct sum_aggregator {
+    template <typename T>
+    struct state {
+        constexpr void add( const T& value ) {
+            if ( m_sum )
+                *m_sum += value;
+            else
+                m_sum = value;
+        }
+
+        constexpr auto result() const -> std::optional<T> {
+            return m_sum;
+        }
+
+        std::optional<T> m_sum;
+    };
+};
+
+struct min_aggregator {
+    template <typename T>
+    struct state {
+        constexpr void add( const T& value ) {
+            if ( !m_min || value < *m_min )
+                m_min = value;
+        }
+
+        constexpr auto result() const -> std::optional<T> {
+            return m_min;
+        }
+
+        std::optional<T> m_min;
+    };
+};
+
+struct max_aggregator {
+    template <typename T>
+    struct state {
+        constexpr void add( const T& value ) {
+            if ( !m_max || *m_max < value )
+                m_max = value;
+        }
+
+        constexpr auto result() const -> std::optional<T> {
+            return m_max;
+        }
+
+        std::optional<T> m_max;
+    };
+};
+
+// The floating-point type that the mean and variance of T are computed in. Only long double elements
+// use long double, since x87 arithmetic is several times slower.
+template <typename T>
+using statistics_float_t = std::conditional_t<std::is_same_v<T, long double>, long double, double>;
+
+// Welford's online algorithm for the variance, which stays accurate when the values are large
+// compared to their spread (unlike summing values and squares).
+template <typename T>
+struct welford_state {
+    static_assert( std::is_arithmetic_v<T>, "The variance requires arithmetic elements." );
+
+    using float_t = statistics_float_t<T>;
+
+    constexpr void add( const T& value ) {
+        const auto x     = static_cast<float_t>( value );
+        const auto delta = x - m_mean;
+
+        ++m_count;
+        m_mean += delta / static_cast<float_t>( m_count );
+        m_m2 += delta * ( x - m_mean );
+    }
+
+    constexpr auto population_variance() const -> std::optional<long double> {
+        return m_count == 0 ? std::optional<long double>()
+                            : std::optional<long double>( m_m2 / static_cast<float_t>( m_count ) );
+    }
+
+    size_t  m_count{};
+    float_t m_mean{};
+    float_t m_m2{};
+};
+
+// Sums in floating point rather than updating a running mean, which would put a division on the
+// critical path of every element.
+struct mean_aggregator {
+    template <typename T>
+    struct state {
+        static_assert( std::is_arithmetic_v<T>, "The mean requires arithmetic elements." );
+
+        constexpr void add( const T& value ) {
+            m_sum += static_cast<statistics_float_t<T>>( value );
+            ++m_count;
+        }
+
+        constexpr auto result() const -> std::optional<long double> {
+            return m_count == 0 ? std::optional<long double>()
+                                : std::optional<long double>( m_sum / static_cast<statistics_float_t<T>>( m_count ) );
+        }
+
+        size_t                m_count{};
+        statistics_float_t<T> m_sum{};
+    };
+};
+
+struct variance_aggregator {
+    template <typename T>
+    struct state : welford_state<T> {
+        constexpr auto result() const -> std::optional<long double> {
+            return this->population_variance();
+        }
+    };
+};
+
+struct stddev_aggregator {
+    template <typename T>
+    struct state : welford_state<T> {
+        auto result() const -> std::optional<long double> {
+            const auto variance = this->population_variance();
+            return variance ? std::optional<long double>( std::sqrt( *variance ) ) : std::optional<long double>();
+        }
+    };
+};
+
+#ifdef LINQ_SIMD_KERNELS
+
+// ----------------------------------
+// SIMD kernels
+// ----------------------------------
+
+// Element types that sum(), min() and max() reduce with vectorized kernels when their range is contiguous.
+template <typename T>
+static constexpr bool has_simd_kernels_v =
+    std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, long double>;
+
+// The type that elements of type T are summed in. Integers are summed as 64-bit unsigned integers,
+// which wrap around instead of overflowing, and are converted back to T at the end.
+template <typename T>
+using simd_sum_t = std::conditional_t<std::is_integral_v<T>, uint64_t, T>;
+
+// The number of independent accumulators of a kernel, which fill several vector registers.
+static constexpr size_t simd_lanes = 32;
+
+#  if defined( __GNUC__ ) || defined( __clang__ )
+#    define LINQ_ALWAYS_INLINE [[gnu::always_inline]] inline
+#  else
+#    define LINQ_ALWAYS_INLINE inline
+#  endif
+
+template <typename T>
+LINQ_ALWAYS_INLINE auto sum_kernel( const T* elements, size_t count ) -> simd_sum_t<T> {
+    using sum_t = simd_sum_t<T>;
+
+    sum_t  lanes[simd_lanes]{};
+    size_t i = 0;
+
+    for ( ; i + simd_lanes <= count; i += simd_lanes ) {
+        for ( size_t j = 0; j < simd_lanes; ++j )
+            lanes[j] += static_cast<sum_t>( elements[i + j] );
+    }
+
+    auto result = sum_t();
+
+    for ( size_t j = 0; j < simd_lanes; ++j )
+        result += lanes[j];
+
+    for ( ; i < count; ++i )
+        result += static_cast<sum_t>( elements[i] );
+
+    return result;
+}
+
+// Determines the element for which no other element is_better. Comparing like the scalar loop
+// keeps its NaN semantics: a leading NaN is the result, every other NaN is ignored.
+template <typename T, typename TCompare>
+LINQ_ALWAYS_INLINE auto extremum_kernel( const T* elements, size_t count, TCompare is_better ) -> T {
+    T lanes[simd_lanes];
+
+    for ( size_t j = 0; j < simd_lanes; ++j )
+        lanes[j] = elements[0];
+
+    size_t i = 0;
+
+    for ( ; i + simd_lanes <= count; i += simd_lanes ) {
+        for ( size_t j = 0; j < simd_lanes; ++j )
+            lanes[j] = is_better( elements[i + j], lanes[j] ) ? elements[i + j] : lanes[j];
+    }
+
+    auto result = lanes[0];
+
+    for ( size_t j = 1; j < simd_lanes; ++j )
+        result = is_better( lanes[j], result ) ? lanes[j] : result;
+
+    for ( ; i < count; ++i )
+        result = is_better( elements[i], result ) ? elements[i] : result;
+
+    return result;
+}
+
+// Determines the minimum and the maximum of a non-empty array in a single pass, with the
+// semantics of extremum_kernel.
+template <typename T>
+LINQ_ALWAYS_INLINE auto min_max_kernel( const T* elements, size_t count ) -> std::pair<T, T> {
+    T lows[simd_lanes];
+    T highs[simd_lanes];
+
+    for ( size_t j = 0; j < simd_lanes; ++j ) {
+        lows[j]  = elements[0];
+        highs[j] = elements[0];
+    }
+
+    size_t i = 0;
+
+    for ( ; i + simd_lanes <= count; i += simd_lanes ) {
+        for ( size_t j = 0; j < simd_lanes; ++j ) {
+            lows[j]  = elements[i + j] < lows[j] ? elements[i + j] : lows[j];
+            highs[j] = highs[j] < elements[i + j] ? elements[i + j] : highs[j];
+        }
+    }
+
+    auto low  = lows[0];
+    auto high = highs[0];
+
+    for ( size_t j = 1; j < simd_lanes; ++j ) {
+        low  = lows[j] < low ? lows[j] : low;
+        high = high < highs[j] ? highs[j] : high;
+    }
+
+    for ( ; i < count; ++i ) {
+        low  = elements[i] < low ? elements[i] : low;
+        high = high < elements[i] ? elements[i] : high;
+    }
+
+    return std::make_pair( low, high );
+}
+
+struct is_less {
+    template <typename T>
+    constexpr auto operator()( const T& a, const T& b ) const -> bool {
+        return a < b;
+    }
+};
+
+struct is_greater {
+    template <typename T>
+    constexpr auto operator()( const T& a, const T& b ) const -> bool {
+        return b < a;
+    }
+};
+
+#  ifdef LINQ_SIMD_DISPATCH
+// The widest instruction set that the kernels are compiled for and that the CPU supports.
+enum class simd_level { baseline, avx2, avx512 };
+
+inline auto detect_simd_level() -> simd_level {
+    static const auto level = [] {
+        __builtin_cpu_init();
+
+        if ( __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512bw" ) &&
+             __builtin_cpu_supports( "avx512dq" ) && __builtin_cpu_supports( "avx512vl" ) )
+            return simd_level::avx512;
+
+        if ( __builtin_cpu_supports( "avx2" ) )
+            return simd_level::avx2;
+
+        return simd_level::baseline;
+    }();
+
+    return level;
+}
+
+template <typename T>
+[[gnu::target( "avx2" )]]
+auto sum_kernel_avx2( const T* elements, size_t count ) -> simd_sum_t<T> {
+    return sum_kernel( elements, count );
+}
+
+template <typename T>
+[[gnu::target( "avx512f,avx512bw,avx512dq,avx512vl" )]]
+auto sum_kernel_avx512( const T* elements, size_t count ) -> simd_sum_t<T> {
+    return sum_kernel( elements, count );
+}
+
+template <typename T, typename TCompare>
+[[gnu::target( "avx2" )]]
+auto extremum_kernel_avx2( const T* elements, size_t count, TCompare is_better ) -> T {
+    return extremum_kernel( elements, count, is_better );
+}
+
+template <typename T, typename TCompare>
+[[gnu::target( "avx512f,avx512bw,avx512dq,avx512vl" )]]
+auto extremum_kernel_avx512( const T* elements, size_t count, TCompare is_better ) -> T {
+    return extremum_kernel( elements, count, is_better );
+}
+
+template <typename T>
+[[gnu::target( "avx2" )]]
+auto min_max_kernel_avx2( const T* elements, size_t count ) -> std::pair<T, T> {
+    return min_max_kernel( elements, count );
+}
+
+template <typename T>
+[[gnu::target( "avx512f,avx512bw,avx512dq,avx512vl" )]]
+auto min_max_kernel_avx512( const T* elements, size_t count ) -> std::pair<T, T> {
+    return min_max_kernel( elements, count );
+}
+#  endif
+
+// Sums a non-empty array with the widest kernel that the CPU supports.
+template <typename T>
+auto simd_sum( const T* elements, size_t count ) -> T {
+#  ifdef LINQ_SIMD_DISPATCH
+    switch ( detect_simd_level() ) {
+        case simd_level::avx512: return static_cast<T>( sum_kernel_avx512( elements, count ) );
+        case simd_level::avx2: return static_cast<T>( sum_kernel_avx2( elements, count ) );
+        case simd_level::baseline: break;
+    }
+#  endif
+
+    return static_cast<T>( sum_kernel( elements, count ) );
+}
+
+// Determines the minimum or maximum of a non-empty array with the widest kernel that the CPU supports.
+template <typename T, typename TCompare>
+auto simd_extremum( const T* elements, size_t count, TCompare is_better ) -> T {
+#  ifdef LINQ_SIMD_DISPATCH
+    switch ( detect_simd_level() ) {
+        case simd_level::avx512: return extremum_kernel_avx512( elements, count, is_better );
+        case simd_level::avx2: return extremum_kernel_avx2( elements, count, is_better );
+        case simd_level::baseline: break;
+    }
+#  endif
+
+    return extremum_kernel( elements, count, is_better );
+}
+
+// Determines the minimum and the maximum of a non-empty array with the widest kernel that the CPU supports.
+template <typename T>
+auto simd_min_max( const T* elements, size_t count ) -> std::pair<T, T> {
+#  ifdef LINQ_SIMD_DISPATCH
+    switch ( detect_simd_level() ) {
+        case simd_level::avx512: return min_max_kernel_avx512( elements, count );
+        case simd_level::avx2: return min_max_kernel_avx2( elements, count );
+        case simd_level::baseline: break;
+    }
+#  endif
+
+    return min_max_kernel( elements, count );
+}
+
+#  undef LINQ_ALWAYS_INLINE
+
+#endif // LINQ_SIMD_KERNELS
+
+// ----------------------------------
+// base_range
+// ----------------------------------
+
+/// Base class to identify all range types (for compile-time type checking).
+class range_ident {
+    // Nothing to define here.
+};
+
+/// Base class for sorting ranges (for compile-time type checking).
+class sorting_range {
+    // Nothing to define here.
+};
+
+// Pushes the elements in [pos, last) into a sink until the sink returns false.
+template <typename TIter, typename TSink>
+constexpr auto push_elements( TIter pos, const TIter last, TSink& sink ) -> bool {
+    for ( ; pos != last; ++pos ) {
+        if ( !sink( *pos ) )
+            return false;
+    }
+
+    return true;
+}
+
+#ifndef LINQ_NO_STL_CONTAINERS
+
+/// @brief A batch of elements that is passed between the stages of a batched range.
+/// Filters narrow a batch down by building a selection vector instead of copying its elements.
+template <typename T>
+struct element_batch {
+    /// The elements of the batch.
+    const T* elements{};
+
+    /// The indices of the selected elements, or null if the first `count` elements are selected.
+    const uint32_t* selection{};
+
+    /// The number of selected elements.
+    size_t count{};
+
+    /// Invokes func for every selected element until it returns false.
+    template <typename TFunc>
+    constexpr auto for_each_selected( TFunc& func ) const -> bool {
+        if ( selection == nullptr ) {
+            for ( size_t i = 0; i < count; ++i ) {
+                if ( !func( elements[i] ) )
+                    return false;
+            }
+        }
+        else {
+            for ( size_t i = 0; i < count; ++i ) {
+                if ( !func( elements[selection[i]] ) )
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// Gets the batch without its first n selected elements.
+    constexpr auto dropped( size_t n ) const -> element_batch {
+        return selection == nullptr ? element_batch{ elements + n, nullptr, count - n }
+                                    : element_batch{ elements, selection + n, count - n };
+    }
+
+    /// Gets the batch limited to its first n selected elements.
+    constexpr auto limited( size_t n ) const -> element_batch {
+        return element_batch{ elements, selection, std::min( count, n ) };
+    }
+};
+
+// Pushes a contiguous array of elements into a batch sink.
+template <typename T, typename TSink>
+auto push_contiguous_batches( const T* elements, size_t count, TSink& sink, size_t batch_size ) -> bool {
+    for ( size_t offset = 0; offset < count; offset += batch_size ) {
+        if ( !sink( element_batch<T>{ elements + offset, nullptr, std::min( batch_size, count - offset ) } ) )
+            return false;
+    }
+
+    return true;
+}
+
+#endif // LINQ_NO_STL_CONTAINERS
+
+template <typename Range>
+static constexpr auto get_range_size( const Range& range ) -> size_t
+    requires( has_fixed_size<Range> )
+{
+    return range.size();
+}
+
+/// @brief Represents the base class of all linq ranges.
+/// @tparam TOutput The full, unmodified type that is returned by the range.
+template <typename Derived, typename TOutput>
+class range : public range_ident {
+  public:
+    /// Return non-const, non-volatile, non-reference types from methods such as sum, min and max.
+    using output_t = std::decay_t<TOutput>;
+
+    /// @brief Appends a filter to the range.
+    /// @tparam TPredicate The type of the predicate: f(x) -> bool
+    /// @param predicate The predicate
+    /// @return A new range that combines this range with the where-range
+    template <typename TPredicate>
+    [[nodiscard]]
+    constexpr auto where( TPredicate&& predicate ) const;
+
+    /// @brief Appends a distinct-filter to the range that removes duplicate elements.
+    /// Hashable elements are tracked in a hash set; other elements fall back to a linear search.
+    /// @return A new range that combines this range with the distinct-range
+    [[nodiscard]]
+    constexpr auto distinct() const;
+
+#ifndef LINQ_NO_STL_CONTAINERS
+    /// @brief Appends a distinct-filter to the range that tracks encountered elements in a hash set.
+    /// @tparam THash The type of the hash function: f(x) -> size_t
+    /// @tparam TEqual The type of the equality function: f(x, y) -> bool
+    /// @param hasher The hash function
+    /// @param equal The equality function
+    /// @return A new range that combines this range with the distinct-range
+    template <typename THash, typename TEqual = std::equal_to<>>
+    [[nodiscard]]
+    constexpr auto distinct( THash hasher, TEqual equal = TEqual() ) const;
+#endif
+
+    template <typename TTransform>
+    [[nodiscard]]
+    constexpr auto select( TTransform&& transform ) const;
+
+#ifdef LINQ_NO_STL_CONTAINERS
+    template <typename StringType>
+#endif
+    [[nodiscard]]
+    constexpr auto
+    select_to_string( int int_base = 10, std::chars_format float_format = std::chars_format::general ) const;
+
+    template <typename TTransform>
+    [[nodiscard]]
+    constexpr auto select_many( TTransform&& transform ) const;
+
+    [[nodiscard]]
+    constexpr auto reverse() const;
+
+    [[nodiscard]]
+    constexpr auto take( size_t count ) const;
+
+    template <typename TPredicate>
+    [[nodiscard]]
+    constexpr auto take_while( TPredicate&& predicate ) const;
+
+    [[nodiscard]]
+    constexpr auto skip( size_t count ) const;
+
+    template <typename TPredicate>
+    [[nodiscard]]
+    constexpr auto skip_while( TPredicate&& predicate ) const;
+
+    template <typename TOtherRange>
+    [[nodiscard]]
+    constexpr auto append( const TOtherRange& other_range ) const;
+
+    [[nodiscard]]
+    constexpr auto repeat( size_t count ) const;
+
+    template <typename TOtherRange, typename TKeySelectorA, typename TKeySelectorB, typename TTransform>
+    [[nodiscard]]
+    constexpr auto join(
+        const TOtherRange& other_range,
+        TKeySelectorA&&    key_selector_a,
+        TKeySelectorB&&    key_selector_b,
+        TTransform&&       transform ) const;
+
+    /// @brief Joins the range with another range, where both ranges are sorted in ascending order by their keys.
+    /// The ranges are traversed in lockstep, without allocating any memory.
+    /// @param other_range The range to join with, sorted by key_selector_b
+    /// @param key_selector_a The key selector for elements of this range, which is sorted by it
+    /// @param key_selector_b The key selector for elements of other_range
+    /// @param transform The function that produces a result for each matching pair: f(a, b) -> y
+    /// @return A new range that combines this range with the join-range
+    template <typename TOtherRange, typename TKeySelectorA, typename TKeySelectorB, typename TTransform>
+    [[nodiscard]]
+    constexpr auto join_sorted(
+        const TOtherRange& other_range,
+        TKeySelectorA&&    key_selector_a,
+        TKeySelectorB&&    key_selector_b,
+        TTransform&&       transform ) const;
+
+#ifndef LINQ_NO_STL_CONTAINERS
+    /// @brief Groups the elements of the range by a key.
+    /// The groups are produced in the order in which their keys are first encountered.
+    /// @tparam TKeySelector The type of the key selector: f(x) -> key
+    /// @param key_selector The key selector
+    /// @return A new range that produces a linq::grouping for each key
+    template <typename TKeySelector>
+    [[nodiscard]]
+    constexpr auto group_by( TKeySelector&& key_selector ) const;
+
+    /// @brief Applies an accumulator function to the elements of each key, without storing the elements.
+    /// @tparam TKeySelector The type of the key selector: f(x) -> key
+    /// @tparam TSeed The type of the initial value of each key's accumulator
+    /// @tparam TAccumFunc The type of the accumulator function: f(acc, x) -> acc
+    /// @return A new range that produces a std::pair of key and accumulated result for each key
+    template <typename TKeySelector, typename TSeed, typename TAccumFunc>
+    [[nodiscard]]
+    constexpr auto aggregate_by( TKeySelector&& key_selector, TSeed seed, TAccumFunc&& func ) const;
+
+    /// @brief Like aggregate_by, but each key's accumulator starts with its first element.
+    /// @tparam TKeySelector The type of the key selector: f(x) -> key
+    /// @tparam TAccumFunc The type of the accumulator function: f(acc, x) -> acc
+    /// @return A new range that produces a std::pair of key and accumulated result for each key
+    template <typename TKeySelector, typename TAccumFunc>
+    [[nodiscard]]
+    constexpr auto reduce_by( TKeySelector&& key_selector, TAccumFunc&& func ) const;
+
+    /// @brief Counts the elements of each key.
+    /// @tparam TKeySelector The type of the key selector: f(x) -> key
+    /// @return A new range that produces a std::pair of key and element count for each key
+    template <typename TKeySelector>
+    [[nodiscard]]
+    constexpr auto count_by( TKeySelector&& key_selector ) const;
+#endif
+
+    template <typename TKeySelector>
+    [[nodiscard]]
+    constexpr auto order_by(
+        TKeySelector&& key_selector,
+        sort_direction sort_dir,
+        sort_stability stability = sort_stability::stable ) const;
+
+    template <typename TKeySelector>
+    [[nodiscard]]
+    constexpr auto order_by_ascending(
+        TKeySelector&& key_selector,
+        sort_stability stability = sort_stability::stable ) const;
+
+    template <typename TKeySelector>
+    [[nodiscard]]
+    constexpr auto order_by_descending(
+        TKeySelector&& key_selector,
+        sort_stability stability = sort_stability::stable ) const;
+
+    template <typename TKeySelector>
+    [[nodiscard]]
+    constexpr auto then_by( TKeySelector&& key_selector, sort_direction sort_dir ) const;
+
+    template <typename TKeySelector>
+    [[nodiscard]]
+    constexpr auto then_by_ascending( TKeySelector&& key_selector ) const;
+
+    template <typename TKeySelector>
+    [[nodiscard]]
+    constexpr auto then_by_descending( TKeySelector&& key_selector ) const;
+
+    /// @brief Invokes a function for every element of the range, in order.
+    /// The elements are pushed through all stages of the range in a single loop instead of
+    /// being pulled through the iterators of every stage.
+    /// @tparam TFunc The type of the function: f(x), or f(x) -> bool to stop early by returning false
+    /// @param func The function
+    template <typename TFunc>
+    constexpr void for_each( TFunc&& func ) const;
+
+    /// @brief Pushes every element of the range into a sink until the sink returns false.
+    /// Ranges that can produce their elements without an iterator override this; the default
+    /// walks the range's iterators.
+    /// @return False if the sink stopped the enumeration, true if the range was exhausted
+    template <typename TSink>
+    constexpr auto push( TSink&& sink ) const -> bool;
+
+#ifndef LINQ_NO_STL_CONTAINERS
+    /// @brief Executes the range in batches: its stages exchange blocks of up to batch_size elements,
+    /// so that predicates and transforms run in tight loops over contiguous memory.
+    /// Enumerating the returned range directly behaves exactly like enumerating this range.
+    /// @param batch_size The maximum number of elements per batch
+    /// @return A new range that executes this range in batches
+    [[nodiscard]]
+    constexpr auto batched( size_t batch_size = LINQ_BATCH_SIZE ) const;
+
+    /// @brief Caches the elements of the range: on first use, the returned range enumerates this range
+    /// once and stores its elements in a contiguous buffer, from which it serves all later enumerations,
+    /// size() and element_at(). Copies of the returned range share the buffer.
+    /// Call invalidate() on the returned range to enumerate this range again, e.g. when its source changed.
+    /// @return A new range that caches the elements of this range
+    [[nodiscard]]
+    auto cache() const;
+
+    /// @brief Executes the operators that follow on multiple threads. The range is split into chunks,
+    /// which requires random access to its elements (e.g. a container or a from_to range).
+    /// @return A parallel range that supports where, select and several terminal operations
+    [[nodiscard]]
+    auto as_parallel() const
+#  ifdef __cpp_lib_concepts
+        requires( partitionable_range<Derived> )
+#  endif
+    ;
+
+#  ifndef LINQ_NO_THREADS
+    /// @brief Like as_parallel(), but executes the operators that follow on the threads of an executor,
+    /// such as a linq::thread_pool, instead of the default executor.
+    template <typename TExecutor>
+    [[nodiscard]]
+    auto as_parallel( TExecutor& executor ) const
+#    ifdef __cpp_lib_concepts
+        requires( partitionable_range<Derived> && task_executor<TExecutor> )
+#    endif
+    ;
+#  endif
+
+    /// @brief Pushes the elements of the range into a sink as linq::element_batch objects,
+    /// until the sink returns false.
+    /// Ranges that can produce batches directly override this; the default collects the
+    /// elements that push() produces into batches.
+    /// @return False if the sink stopped the enumeration, true if the range was exhausted
+    template <typename TSink>
+    auto push_batches( TSink&& sink, size_t batch_size ) const -> bool;
+#endif
+
+    [[nodiscard]]
+    constexpr auto sum() const;
+
+    [[nodiscard]]
+    constexpr auto min() const;
+
+    [[nodiscard]]
+    constexpr auto max() const;
+
+    [[nodiscard]]
+    constexpr auto sum_and_count() const;
+
+    /// @brief Determines the minimum and the maximum of the range in a single pass.
+    /// @return The pair (minimum, maximum), or an empty optional if the range is empty
+    [[nodiscard]]
+    constexpr auto min_max() const;
+
+    /// @brief Computes several aggregates in a single pass over the range.
+    /// @param aggregators The aggregates to compute, e.g. linq::agg::min or linq::agg::variance
+    /// @return A tuple with the result of every aggregator, in the order they were passed
+    template <typename... TAggregators>
+    [[nodiscard]]
+    constexpr auto aggregate_all( TAggregators... aggregators ) const;
+
+    [[nodiscard]]
+    constexpr auto average() const
+#ifdef __cpp_lib_concepts
+        requires( averageable<output_t> )
+#endif
+    ;
+
+#ifdef __cpp_lib_concepts
+    template <typename TSeed, std::invocable<TSeed&&, const TOutput&> TAccumFunc>
+#else
+    template <typename TSeed, typename TAccumFunc>
+#endif
+    [[nodiscard]]
+    constexpr auto aggregate( TSeed seed, TAccumFunc&& func ) const;
+
+#ifdef __cpp_lib_concepts
+    template <std::invocable<TOutput&&, const TOutput&> TAccumFunc>
+#else
+    template <typename TAccumFunc>
+#endif
+    [[nodiscard]]
+    constexpr auto reduce( const TAccumFunc& func ) const;
+
+#ifndef LINQ_NO_STL_CONTAINERS
+    /// @brief Aggregates the range in chunks, which are processed on multiple threads if the range can be
+    /// split in constant time (see as_parallel). Every chunk is aggregated starting from the seed, and the
+    /// partial results are combined pairwise in a fixed tree order, so the result is the same for every run.
+    /// Other ranges are aggregated on the calling thread as a single chunk.
+    /// @param seed The initial value of every chunk, which must be the identity of combine
+    /// @param accumulate The accumulator function: f(acc, x) -> acc
+    /// @param combine The associative function that combines two partial results: f(acc, acc) -> acc
+    template <typename TSeed, typename TAccumFunc, typename TCombineFunc>
+    [[nodiscard]]
+    auto aggregate( TSeed seed, TAccumFunc&& accumulate, TCombineFunc&& combine ) const;
+
+    /// @brief Like reduce( func ), but processes the range in chunks as aggregate( seed, accumulate, combine )
+    /// does. The function must therefore be associative.
+    template <typename TAccumFunc>
+    [[nodiscard]]
+    auto reduce( parallel_tag, const TAccumFunc& func ) const;
+#endif
+
+    [[nodiscard]]
+    constexpr auto first() const -> std::optional<output_t>;
+
+    template <typename TPredicate>
+    [[nodiscard]]
+    constexpr auto first( const TPredicate& predicate ) const -> std::optional<output_t>;
+
+    [[nodiscard]]
+    constexpr auto last() const -> std::optional<output_t>;
+
+    template <typename TPredicate>
+    [[nodiscard]]
+    constexpr auto last( const TPredicate& predicate ) const -> std::optional<output_t>;
+
+    template <typename TPredicate>
+    [[nodiscard]]
+    constexpr auto any( const TPredicate& predicate ) const -> bool;
+
+    template <typename TPredicate>
+    [[nodiscard]]
+    constexpr auto all( const TPredicate& predicate ) const -> bool;
+
+    template <typename TPredicate>
+    [[nodiscard]]
+    constexpr auto none( const TPredicate& predicate ) const -> bool;
+
+    /// Gets what is known about the number of elements of the range, without enumerating it.
+    [[nodiscard]]
+    constexpr auto size_hint() const -> linq::size_hint;
+
+    [[nodiscard]]
+    constexpr auto count() const -> size_t;
+
+    template <typename TPredicate>
+    [[nodiscard]]
+    constexpr auto count( const TPredicate& predicate ) const -> size_t;
+
+    [[nodiscard]]
+    constexpr auto element_at( size_t index ) const -> std::optional<output_t>;
+
+    template <typename U>
+    constexpr auto equals( const range<U, TOutput>& other_range ) const -> bool;
+
+    constexpr auto equals( const std::initializer_list<TOutput>& list ) const -> bool;
+
+#ifndef LINQ_NO_STL_CONTAINERS
+
+    [[nodiscard]]
+    auto to_vector() const -> std::vector<output_t>;
+
+    /// @brief Like to_vector(), but evaluates chunks of the range on multiple threads if the range can be
+    /// split in constant time (see as_parallel). The elements keep their order.
+    [[nodiscard]]
+    auto to_vector( parallel_tag ) const -> std::vector<output_t>;
+
+    [[nodiscard]]
+    auto to_map() const
+#ifdef __cpp_lib_concepts
+        requires( has_first_and_second_type<output_t> )
+#endif
+    ;
+
+    [[nodiscard]]
+    auto to_unordered_map() const
+#ifdef __cpp_lib_concepts
+        requires( has_first_and_second_type<output_t> )
+#endif
+    ;
+
+    /// @brief Like to_unordered_map(), but builds the map on multiple threads if the range can be split in
+    /// constant time (see to_sharded_map). The shards are then merged into a single map on the calling thread.
+    [[nodiscard]]
+    auto to_unordered_map( parallel_tag ) const
+#ifdef __cpp_lib_concepts
+        requires( has_first_and_second_type<output_t> )
+#endif
+    ;
+
+    /// @brief Stores the key/value pairs of the range in a hash map that is split into several
+    /// std::unordered_maps (shards) by the hashes of the keys. If the range can be split in constant time
+    /// (see as_parallel), the pairs are partitioned by hash on multiple threads and every shard is then
+    /// built by a single thread, without locks. Otherwise the map consists of a single shard.
+    /// @return A sharded_map, which supports lookups by key and exposes its shards
+    [[nodiscard]]
+    auto to_sharded_map() const
+#ifdef __cpp_lib_concepts
+        requires( has_first_and_second_type<output_t> )
+#endif
+    ;
+
+    /// @brief Groups the elements of the range by a key and stores them in a linq::lookup.
+    /// @tparam TKeySelector The type of the key selector: f(x) -> key
+    /// @param key_selector The key selector
+    /// @return A lookup that stores all groups in contiguous memory
+    template <typename TKeySelector>
+    [[nodiscard]]
+    auto to_lookup( const TKeySelector& key_selector ) const;
+
+    /// @brief Like to_lookup(), but computes the keys and groups the elements on multiple threads if the
+    /// range can be split in constant time (see as_parallel). The result is the same as that of to_lookup().
+    template <typename TKeySelector>
+    [[nodiscard]]
+    auto to_lookup( parallel_tag, const TKeySelector& key_selector ) const;
+
+#endif // LINQ_NO_STL_CONTAINERS
+
+  private:
+    constexpr auto self_ref() {
+        return static_cast<Derived&>( *this );
+    }
+
+    constexpr auto self_ref() const {
+        return static_cast<const Derived&>( *this );
+    }
+};
+
+// ----------------------------------
+// where
+// ----------------------------------
+
+template <typename TPrevRange, typename TPredicate>
+class where_range final : public range<where_range<TPrevRange, TPredicate>, typename TPrevRange::iterator::output_t> {
+  public:
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+        using output_t    = typename prev_iter_t::output_t;
+
+        constexpr iterator( const where_range* parent, prev_iter_t begin, prev_iter_t end )
+            : m_parent( parent )
+            , m_begin( begin )
+            , m_end( end ) {
+            const auto& pred = m_parent->m_predicate;
+
+            // Seek the first match.
+            while ( m_begin != m_end && !std::invoke( pred, *m_begin ) )
+                ++m_begin;
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_begin == o.m_begin;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_begin != o.m_begin;
+        }
+
+        constexpr iterator& operator++() {
+            const auto& pred = m_parent->m_predicate;
+
+            do {
+                ++m_begin;
+            } while ( m_begin != m_end && !std::invoke( pred, *m_begin ) );
+
+            return *this;
+        }
+
+        constexpr iterator& operator--()
+            requires( bidirectional_range<TPrevRange> )
+        {
+            const auto& pred = m_parent->m_predicate;
+
+            do {
+                --m_begin;
+            } while ( !std::invoke( pred, *m_begin ) );
+
+            return *this;
+        }
+
+        constexpr auto operator*() const -> output_t {
+            return *m_begin;
+        }
+
+        const where_range* m_parent;
+        prev_iter_t        m_begin;
+        prev_iter_t        m_end;
+    };
+
+    constexpr where_range() = default;
+
+    constexpr where_range( const TPrevRange& prev, TPredicate predicate )
+        : m_prev( prev )
+        , m_predicate( std::move( predicate ) ) {
+    }
+
+    constexpr auto begin() const -> iterator {
+        return iterator( this, m_prev.begin(), m_prev.end() );
+    }
+
+    constexpr auto end() const -> iterator {
+        const auto prev_end = m_prev.end();
+        return iterator( this, prev_end, prev_end );
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint().filtered();
+    }
+
+    template <typename TSink>
+    constexpr auto push( TSink&& sink ) const -> bool {
+        return m_prev.push( [&]( auto&& element ) {
+            return !std::invoke( m_predicate, element ) || sink( std::forward<decltype( element )>( element ) );
+        } );
+    }
+
+#ifndef LINQ_NO_STL_CONTAINERS
+    template <typename TSink>
+    auto push_batches( TSink&& sink, size_t batch_size ) const -> bool {
+        auto selection = std::vector<uint32_t>( batch_size );
+
+        return m_prev.push_batches(
+            [&]( const auto& batch ) {
+                const auto* const elements = batch.elements;
+                const auto        size     = batch.count;
+                auto* const       selected = selection.data();
+                size_t            count    = 0;
+
+                // Write every index, but only advance past the selected ones, so that the loop has no branches.
+                if ( batch.selection == nullptr ) {
+                    for ( size_t i = 0; i < size; ++i ) {
+                        selected[count] = static_cast<uint32_t>( i );
+                        count += std::invoke( m_predicate, elements[i] ) ? 1 : 0;
+                    }
+                }
+                else {
+                    for ( size_t i = 0; i < size; ++i ) {
+                        const auto index = batch.selection[i];
+                        selected[count]  = index;
+                        count += std::invoke( m_predicate, elements[index] ) ? 1 : 0;
+                    }
+                }
+
+                using batch_t = std::remove_cvref_t<decltype( batch )>;
+
+                return count == 0 || sink( batch_t{ batch.elements, selected, count } );
+            },
+            batch_size );
+    }
+#endif
+
+  private:
+    TPrevRange m_prev;
+    TPredicate m_predicate;
+};
+
+// ----------------------------------
+// distinct
+// ----------------------------------
+
+template <typename TPrevRange>
+class distinct_range final : public range<distinct_range<TPrevRange>, typename TPrevRange::iterator::output_t> {
+    using prev_iter_t      = typename TPrevRange::iterator;
+    using object_container = std::vector<prev_iter_t>;
+
+  public:
+    struct iterator {
+        using output_t = typename prev_iter_t::output_t;
+
+        constexpr iterator( prev_iter_t begin, prev_iter_t end, object_container* encountered_objects )
+            : m_begin( begin )
+            , m_end( end )
+            , m_encountered_objects( encountered_objects ) {
+            if ( m_begin != m_end ) {
+                encountered_objects->clear();
+                encountered_objects->push_back( m_begin );
+            }
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_begin == o.m_begin;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_begin != o.m_begin;
+        }
+
+        constexpr iterator& operator++() {
+            do {
+                ++m_begin;
+            } while ( m_begin != m_end && contains_object( m_begin ) );
+
+            if ( m_begin != m_end )
+                m_encountered_objects->push_back( m_begin );
+
+            return *this;
+        }
+
+        constexpr bool contains_object( const prev_iter_t& it ) {
+            const auto& it_val = *it;
+
+            const auto&  encountered_objects = *m_encountered_objects;
+            const size_t size                = encountered_objects.size();
+
+            for ( size_t i = 0; i < size; ++i ) {
+                if ( *encountered_objects[i] == it_val )
+                    return true;
+            }
+
+            return false;
+        }
+
+        constexpr const output_t& operator*() const {
+            return *m_begin;
+        }
+
+        prev_iter_t       m_begin;
+        prev_iter_t       m_end;
+        object_container* m_encountered_objects;
+    };
+
+    constexpr distinct_range() = default;
+
+    constexpr explicit distinct_range( const TPrevRange& prev )
+        : m_prev( prev ) {
+    }
+
+    constexpr iterator begin() const {
+        return iterator{ m_prev.begin(), m_prev.end(), std::addressof( m_encountered_objects ) };
+    }
+
+    constexpr iterator end() const {
+        const auto prev_end = m_prev.end();
+        return iterator{ prev_end, prev_end, std::addressof( m_encountered_objects ) };
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint().deduplicated();
+    }
+
+  private:
+    TPrevRange               m_prev;
+    mutable object_container m_encountered_objects;
+};
+
+#ifndef LINQ_NO_STL_CONTAINERS
+
+// Distinct operator that stores copies of encountered elements in a hash set.
+// It yields the copies in the set, so that every element of the previous range is evaluated once.
+template <typename TPrevRange, typename THash, typename TEqual>
+class hash_distinct_range final
+    : public range<
+          hash_distinct_range<TPrevRange, THash, TEqual>,
+          std::decay_t<typename TPrevRange::iterator::output_t>> {
+    using prev_iter_t = typename TPrevRange::iterator;
+    using value_t     = std::decay_t<typename prev_iter_t::output_t>;
+    using object_set  = std::unordered_set<value_t, THash, TEqual>;
+
+  public:
+    struct iterator {
+        using output_t = const value_t&;
+
+        constexpr iterator( prev_iter_t begin, prev_iter_t end, object_set* encountered_objects )
+            : m_begin( begin )
+            , m_end( end )
+            , m_encountered_objects( encountered_objects ) {
+            if ( m_begin != m_end ) {
+                encountered_objects->clear();
+                m_current = std::addressof( *encountered_objects->emplace( *m_begin ).first );
+            }
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_begin == o.m_begin;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_begin != o.m_begin;
+        }
+
+        constexpr iterator& operator++() {
+            while ( ++m_begin != m_end ) {
+                // Nodes of the set keep their addresses when it rehashes.
+                const auto [pos, is_new] = m_encountered_objects->emplace( *m_begin );
+
+                if ( is_new ) {
+                    m_current = std::addressof( *pos );
+                    break;
+                }
+            }
+
+            return *this;
+        }
+
+        constexpr output_t operator*() const {
+            return *m_current;
+        }
+
+        prev_iter_t    m_begin;
+        prev_iter_t    m_end;
+        object_set*    m_encountered_objects;
+        const value_t* m_current{};
+    };
+
+    constexpr hash_distinct_range( const TPrevRange& prev, THash hasher, TEqual equal )
+        : m_prev( prev )
+        , m_encountered_objects( 0, std::move( hasher ), std::move( equal ) ) {
+    }
+
+    constexpr iterator begin() const {
+        m_encountered_objects.reserve( m_prev.size_hint().lower );
+
+        return iterator{ m_prev.begin(), m_prev.end(), std::addressof( m_encountered_objects ) };
+    }
+
+    constexpr iterator end() const {
+        const auto prev_end = m_prev.end();
+        return iterator{ prev_end, prev_end, std::addressof( m_encountered_objects ) };
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint().deduplicated();
+    }
+
+    template <typename TSink>
+    constexpr auto push( TSink&& sink ) const -> bool {
+        m_encountered_objects.clear();
+        m_encountered_objects.reserve( m_prev.size_hint().lower );
+
+        return m_prev.push( [&]( auto&& element ) {
+            const auto [pos, is_new] = m_encountered_objects.emplace( std::forward<decltype( element )>( element ) );
+            return !is_new || sink( *pos );
+        } );
+    }
+
+  private:
+    TPrevRange         m_prev;
+    mutable object_set m_encountered_objects;
+};
+
+#endif // LINQ_NO_STL_CONTAINERS
+
+// ----------------------------------
+// select
+// ----------------------------------
+
+// Resolves the arguments that are passed to a select functor.
+template <typename TPrevRange>
+using select_transform_arg_t = std::add_const_t<std::add_lvalue_reference_t<typename TPrevRange::iterator::output_t>>;
+
+// Resolves the return type of a select functor.
+template <typename TPrevRange, typename TTransform>
+using select_output_t = std::invoke_result_t<TTransform, select_transform_arg_t<TPrevRange>>;
+
+template <typename TPrevRange, typename TTransform>
+class select_range final : public range<select_range<TPrevRange, TTransform>, select_output_t<TPrevRange, TTransform>> {
+  public:
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+        using output_t    = select_output_t<TPrevRange, TTransform>;
+
+        constexpr iterator( const select_range* parent, prev_iter_t begin, prev_iter_t end )
+            : m_parent( parent )
+            , m_begin( begin )
+            , m_end( end ) {
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_begin == o.m_begin;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_begin != o.m_begin;
+        }
+
+        constexpr iterator& operator++() {
+            ++m_begin;
+            return *this;
+        }
+
+        constexpr iterator& operator--()
+            requires( bidirectional_range<TPrevRange> )
+        {
+            --m_begin;
+            return *this;
+        }
+
+        constexpr iterator& operator+=( std::ptrdiff_t count )
+            requires( random_access_range<TPrevRange> )
+        {
+            m_begin += count;
+            return *this;
+        }
+
+        constexpr auto operator-( const iterator& o ) const -> std::ptrdiff_t
+            requires( random_access_range<TPrevRange> )
+        {
+            return m_begin - o.m_begin;
+        }
+
+        constexpr output_t operator*() const {
+            return m_parent->m_transform( *m_begin );
+        }
+
+        const select_range* m_parent;
+        prev_iter_t         m_begin;
+        prev_iter_t         m_end;
+    };
+
+    constexpr select_range( const TPrevRange& prev, TTransform transform )
+        : m_prev( prev )
+        , m_transform( std::move( transform ) ) {
+    }
+
+    constexpr auto begin() const -> iterator {
+        return iterator( this, m_prev.begin(), m_prev.end() );
+    }
+
+    constexpr auto end() const -> iterator {
+        const auto prev_end = m_prev.end();
+        return iterator( this, prev_end, prev_end );
+    }
+
+    constexpr auto size() const -> size_t
+        requires( has_fixed_size<TPrevRange> )
+    {
+        return m_prev.size();
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint();
+    }
+
+    template <typename TSink>
+    constexpr auto push( TSink&& sink ) const -> bool {
+        return m_prev.push( [&]( auto&& element ) {
+            return sink( m_transform( std::forward<decltype( element )>( element ) ) );
+        } );
+    }
+
+#ifndef LINQ_NO_STL_CONTAINERS
+    template <typename TSink>
+    auto push_batches( TSink&& sink, size_t batch_size ) const -> bool {
+        using value_t = std::decay_t<select_output_t<TPrevRange, TTransform>>;
+
+        if constexpr ( std::is_default_constructible_v<value_t> && std::is_move_assignable_v<value_t> ) {
+            // Transform the selected elements into a dense buffer that is reused for every batch.
+            auto buffer = std::vector<value_t>( batch_size );
+
+            return m_prev.push_batches(
+                [&]( const auto& batch ) {
+                    auto* const out = buffer.data();
+
+                    if ( batch.selection == nullptr ) {
+                        for ( size_t i = 0; i < batch.count; ++i )
+                            out[i] = m_transform( batch.elements[i] );
+                    }
+                    else {
+                        for ( size_t i = 0; i < batch.count; ++i )
+                            out[i] = m_transform( batch.elements[batch.selection[i]] );
+                    }
+
+                    return sink( element_batch<value_t>{ out, nullptr, batch.count } );
+                },
+                batch_size );
+        }
+        else {
+            return range<select_range, select_output_t<TPrevRange, TTransform>>::push_batches( sink, batch_size );
+        }
+    }
+#endif
+
+  private:
+    TPrevRange m_prev;
+    TTransform m_transform{};
+};
+
+// ----------------------------------
+// select_to_string
+// ----------------------------------
+
+template <typename TPrevRange, typename StringType>
+class select_to_string_range final : public range<select_to_string_range<TPrevRange, StringType>, StringType> {
+  public:
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+        using output_t    = StringType;
+
+        constexpr iterator( const select_to_string_range* parent, prev_iter_t begin, prev_iter_t end )
+            : m_parent( parent )
+            , m_begin( begin )
+            , m_end( end ) {
+        }
+
+        constexpr auto operator==( const iterator& o ) const -> bool {
+            return m_begin == o.m_begin;
+        }
+
+        constexpr auto operator!=( const iterator& o ) const -> bool {
+            return m_begin != o.m_begin;
+        }
+
+        constexpr auto operator++() -> iterator& {
+            ++m_begin;
+            return *this;
+        }
+
+#if 0
+#ifdef __cpp_lib_constexpr_charconv
+        constexpr
+#endif
+                auto
+                operator*() const -> output_t requires(number<typename TPrevRange::output_t>) {
+                    constexpr auto buffer_size = static_cast<size_t>(32);
+                    char buffer[buffer_size]{};
+
+                    const auto result = [&]() -> std::to_chars_result {
+                        if constexpr (std::is_integral_v<typename TPrevRange::output_t>) {
+                            return std::to_chars(buffer, &buffer[buffer_size], *m_begin, m_parent->m_int_base);
+                        }
+
+                        return std::to_chars(buffer, &buffer[buffer_size], *m_begin, m_parent->m_float_format);
+                    }();
+
+                    if (result.ec == std::errc()) {
+                        const auto char_count = static_cast<size_t>(result.ptr - buffer);
+                        return StringType(buffer, char_count);
+                    }
+
+                    return StringType("?");
+                }
+#endif
+
+        auto operator*() const -> output_t
+            requires( std::is_same_v<typename TPrevRange::output_t, char> )
+        {
+            return StringType( 1, *m_begin );
+        }
+
+        auto operator*() const -> output_t {
+            return LINQ_TO_STRING_FUNC( *m_begin );
+        }
+
+        const select_to_string_range* m_parent{};
+        prev_iter_t                   m_begin;
+        prev_iter_t                   m_end;
+    };
+
+    constexpr explicit select_to_string_range(
+        const TPrevRange&       prev,
+        const int               int_base,
+        const std::chars_format float_format )
+        : m_prev( prev )
+        , m_int_base( int_base )
+        , m_float_format( float_format ) {
+    }
+
+    constexpr auto begin() const -> iterator {
+        return iterator( this, m_prev.begin(), m_prev.end() );
+    }
+
+    constexpr auto end() const -> iterator {
+        const auto prev_end = m_prev.end();
+        return iterator( this, prev_end, prev_end );
+    }
+
+    constexpr auto size() const -> size_t
+        requires( has_fixed_size<TPrevRange> )
+    {
+        return m_prev.size();
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint();
+    }
+
+  private:
+    TPrevRange        m_prev;
+    int               m_int_base;
+    std::chars_format m_float_format;
+};
+
+// ----------------------------------
+// select_many
+// ----------------------------------
+
+template <typename TPrevRange, typename TTransform>
+struct select_many_traits {
+    using returned_range_t = std::invoke_result_t<TTransform, typename TPrevRange::iterator::output_t>;
+
+    // See if the returned type is really a range.
+    static_assert(
+        std::is_base_of_v<range_ident, returned_range_t>,
+        "The transform function of select_many is expected to return a linq range." );
+
+    using output_t = typename returned_range_t::iterator::output_t;
+};
+
+template <typename TPrevRange, typename TTransform>
+class select_many_range final : public range<
+                                    select_many_range<TPrevRange, TTransform>,
+                                    typename select_many_traits<TPrevRange, TTransform>::output_t> {
+  public:
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+
+        using returned_range_t      = typename select_many_traits<TPrevRange, TTransform>::returned_range_t;
+        using returned_range_iter_t = typename returned_range_t::iterator;
+        using output_t              = typename returned_range_iter_t::output_t;
+
+        constexpr iterator( const select_many_range* parent, prev_iter_t pos, prev_iter_t end )
+            : m_parent( parent )
+            , m_pos( std::move( pos ) )
+            , m_end( std::move( end ) ) {
+            if ( m_pos != m_end ) {
+                const auto& transform = m_parent->m_transform;
+                bool        first     = true;
+
+                do {
+                    if ( !first ) {
+                        ++m_pos;
+                    }
+
+                    if ( m_pos == m_end ) {
+                        break;
+                    }
+
+                    m_ret_range = std::invoke( transform, *m_pos );
+                    m_ret_begin = m_ret_range.begin();
+                    m_ret_end   = m_ret_range.end();
+
+                    first = false;
+                } while ( m_ret_begin == m_ret_end );
+            }
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_pos == o.m_pos;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_pos != o.m_pos;
+        }
+
+        constexpr iterator& operator++() {
+            if ( m_ret_begin != m_ret_end ) {
+                // There are values left to be obtained from the returned range.
+                ++m_ret_begin;
+            }
+
+            if ( m_ret_begin == m_ret_end ) {
+                // Move our parent iterator forward to get the next container.
+                ++m_pos;
+
+                if ( m_pos != m_end ) {
+                    m_ret_range = m_parent->m_transform( *m_pos );
+                    m_ret_begin = m_ret_range.begin();
+                    m_ret_end   = m_ret_range.end();
+                }
+            }
+
+            return *this;
+        }
+
+        constexpr const output_t& operator*() const {
+            return *m_ret_begin;
+        }
+
+        const select_many_range* m_parent;
+        prev_iter_t              m_pos;
+        prev_iter_t              m_end;
+
+        returned_range_t      m_ret_range;
+        returned_range_iter_t m_ret_begin;
+        returned_range_iter_t m_ret_end;
+    };
+
+    constexpr select_many_range() = default;
+
+    constexpr select_many_range( const TPrevRange& prev, TTransform transform )
+        : m_prev( prev )
+        , m_transform( std::move( transform ) ) {
+    }
+
+    constexpr iterator begin() const {
+        return iterator{ this, m_prev.begin(), m_prev.end() };
+    }
+
+    constexpr iterator end() const {
+        const auto prev_end = m_prev.end();
+        return iterator{ this, prev_end, prev_end };
+    }
+
+  private:
+    TPrevRange m_prev;
+    TTransform m_transform;
+};
+
+// ----------------------------------
+// reverse
+// ----------------------------------
+
+template <typename TPrevRange>
+class reverse_range final : public range<reverse_range<TPrevRange>, typename TPrevRange::iterator::output_t> {
+  public:
+    using prev_iter_t      = typename TPrevRange::iterator;
+    using object_container = std::vector<prev_iter_t>;
+
+    // Iterates over the previous range's iterators, which have been buffered in begin().
+    struct buffered_iterator {
+        using output_t = typename prev_iter_t::output_t;
+
+        constexpr buffered_iterator( const object_container* prev_iterators, size_t index )
+            : m_prev_iterators( prev_iterators )
+            , m_index( index ) {
+        }
+
+        constexpr bool operator==( const buffered_iterator& o ) const {
+            return m_index == o.m_index;
+        }
+
+        constexpr bool operator!=( const buffered_iterator& o ) const {
+            return m_index != o.m_index;
+        }
+
+        constexpr buffered_iterator& operator++() {
+            --m_index;
+            return *this;
+        }
+
+        constexpr const output_t& operator*() const {
+            return *( *m_prev_iterators )[m_index];
+        }
+
+        const object_container* m_prev_iterators;
+        size_t                  m_index{};
+    };
+
+    // Walks a bidirectional range backwards, from its last element to its first one.
+    struct bidirectional_iterator {
+        using output_t = typename prev_iter_t::output_t;
+
+        constexpr bidirectional_iterator( prev_iter_t first, prev_iter_t pos, bool is_end )
+            : m_first( first )
+            , m_pos( pos )
+            , m_is_end( is_end ) {
+        }
+
+        constexpr bool operator==( const bidirectional_iterator& o ) const {
+            return m_is_end == o.m_is_end && ( m_is_end || m_pos == o.m_pos );
+        }
+
+        constexpr bool operator!=( const bidirectional_iterator& o ) const {
+            return !( *this == o );
+        }
+
+        constexpr bidirectional_iterator& operator++() {
+            if ( m_pos == m_first )
+                m_is_end = true;
+            else
+                --m_pos;
+
+            return *this;
+        }
+
+        // Moves forward, i.e. towards the first element of the previous range.
+        constexpr bidirectional_iterator& operator+=( std::ptrdiff_t count )
+            requires( random_access_range<TPrevRange> )
+        {
+            LINQ_ASSERT( count >= 0 && "reverse iterators can only move forward" );
+
+            if ( count > 0 ) {
+                if ( count > m_pos - m_first ) {
+                    m_pos    = m_first;
+                    m_is_end = true;
+                }
+                else {
+                    m_pos += -count;
+                }
+            }
+
+            return *this;
+        }
+
+        constexpr auto operator-( const bidirectional_iterator& o ) const -> std::ptrdiff_t
+            requires( random_access_range<TPrevRange> )
+        {
+            // The end iterator is one past the first element of the previous range.
+            const auto remaining = []( const bidirectional_iterator& it ) -> std::ptrdiff_t {
+                return it.m_is_end ? 0 : ( it.m_pos - it.m_first ) + 1;
+            };
+
+            return remaining( o ) - remaining( *this );
+        }
+
+        constexpr output_t operator*() const {
+            return *m_pos;
+        }
+
+        prev_iter_t m_first;
+        prev_iter_t m_pos;
+        bool        m_is_end;
+    };
+
+    using iterator = std::conditional_t<bidirectional_range<TPrevRange>, bidirectional_iterator, buffered_iterator>;
+
+    constexpr reverse_range() = default;
+
+    constexpr explicit reverse_range( const TPrevRange& prev )
+        : m_prev( prev ) {
+    }
+
+    constexpr iterator begin() const {
+        if constexpr ( bidirectional_range<TPrevRange> ) {
+            const auto first = m_prev.begin();
+            auto       last  = m_prev.end();
+
+            if ( first == last )
+                return end();
+
+            --last;
+
+            return iterator( first, last, false );
+        }
+        else {
+            m_prev_iterators.clear();
+
+            m_prev_iterators.reserve( m_prev.size_hint().lower );
+
+            for ( auto beg = m_prev.begin(), end = m_prev.end(); beg != end; ++beg ) {
+                m_prev_iterators.push_back( beg );
+            }
+
+            return iterator{ std::addressof( m_prev_iterators ), m_prev_iterators.size() - 1 };
+        }
+    }
+
+    constexpr iterator end() const {
+        if constexpr ( bidirectional_range<TPrevRange> ) {
+            const auto prev_end = m_prev.end();
+            return iterator( prev_end, prev_end, true );
+        }
+        else {
+            return iterator{ nullptr, static_cast<size_t>( -1 ) };
+        }
+    }
+
+    constexpr auto size() const -> size_t
+        requires( has_fixed_size<TPrevRange> )
+    {
+        return m_prev.size();
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint();
+    }
+
+  private:
+    TPrevRange               m_prev;
+    mutable object_container m_prev_iterators;
+};
+
+// ----------------------------------
+// take
+// ----------------------------------
+
+template <typename TPrevRange>
+class take_range final : public range<take_range<TPrevRange>, typename TPrevRange::iterator::output_t> {
+  public:
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+        using output_t    = typename prev_iter_t::output_t;
+
+        constexpr iterator( prev_iter_t begin, size_t count )
+            : m_begin( begin )
+            , m_count( count ) {
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_count == o.m_count || m_begin == o.m_begin;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_count != o.m_count && m_begin != o.m_begin;
+        }
+
+        constexpr iterator& operator++() {
+            ++m_begin;
+            --m_count;
+            return *this;
+        }
+
+        constexpr iterator& operator+=( std::ptrdiff_t count )
+            requires( random_access_range<TPrevRange> )
+        {
+            m_begin += count;
+            m_count -= static_cast<size_t>( count );
+            return *this;
+        }
+
+        // The distance is limited both by the previous range and by the remaining count.
+        constexpr auto operator-( const iterator& o ) const -> std::ptrdiff_t
+            requires( random_access_range<TPrevRange> )
+        {
+            const auto by_position = m_begin - o.m_begin;
+            const auto by_count    = static_cast<std::ptrdiff_t>( o.m_count ) - static_cast<std::ptrdiff_t>( m_count );
+
+            return by_position >= 0 ? std::min( by_position, by_count ) : std::max( by_position, by_count );
+        }
+
+        constexpr output_t operator*() const {
+            return *m_begin;
+        }
+
+        prev_iter_t m_begin;
+        size_t      m_count{};
+    };
+
+    constexpr take_range() = default;
+
+    constexpr take_range( const TPrevRange& prev, size_t count )
+        : m_prev( prev )
+        , m_count( count ) {
+    }
+
+    constexpr iterator begin() const {
+        return iterator( m_prev.begin(), m_count );
+    }
+
+    constexpr iterator end() const {
+        return iterator( m_prev.end(), 0 );
+    }
+
+    constexpr auto size() const -> size_t
+        requires( has_fixed_size<TPrevRange> )
+    {
+        return std::min( m_count, m_prev.size() );
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint().limited( m_count );
+    }
+
+    template <typename TSink>
+    constexpr auto push( TSink&& sink ) const -> bool {
+        if ( m_count == 0 )
+            return true;
+
+        auto remaining    = m_count;
+        auto sink_stopped = false;
+
+        m_prev.push( [&]( auto&& element ) {
+            if ( !sink( std::forward<decltype( element )>( element ) ) ) {
+                sink_stopped = true;
+                return false;
+            }
+
+            return --remaining > 0;
+        } );
+
+        return !sink_stopped;
+    }
+
+#ifndef LINQ_NO_STL_CONTAINERS
+    template <typename TSink>
+    auto push_batches( TSink&& sink, size_t batch_size ) const -> bool {
+        if ( m_count == 0 )
+            return true;
+
+        auto remaining    = m_count;
+        auto sink_stopped = false;
+
+        m_prev.push_batches(
+            [&]( const auto& batch ) {
+                const auto limited = batch.limited( remaining );
+
+                if ( !sink( limited ) ) {
+                    sink_stopped = true;
+                    return false;
+                }
+
+                remaining -= limited.count;
+
+                return remaining > 0;
+            },
+            batch_size );
+
+        return !sink_stopped;
+    }
+#endif
+
+  private:
+    TPrevRange m_prev;
+    size_t     m_count{};
+};
+
+// ----------------------------------
+// take_while
+// ----------------------------------
+
+template <typename TPrevRange, typename TPredicate>
+class take_while_range final
+    : public range<take_while_range<TPrevRange, TPredicate>, typename TPrevRange::iterator::output_t> {
+  public:
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+        using output_t    = typename prev_iter_t::output_t;
+
+        constexpr iterator( const take_while_range* parent, prev_iter_t begin, prev_iter_t end )
+            : m_parent( parent )
+            , m_begin( begin )
+            , m_end( end ) {
+            const auto& pred = m_parent->m_predicate;
+
+            if ( m_begin != m_end && !std::invoke( pred, *m_begin ) )
+                m_begin = m_end;
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_begin == o.m_begin;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_begin != o.m_begin;
+        }
+
+        constexpr iterator& operator++() {
+            ++m_begin;
+
+            const auto& pred = m_parent->m_predicate;
+
+            if ( m_begin != m_end && !std::invoke( pred, *m_begin ) )
+                m_begin = m_end;
+
+            return *this;
+        }
+
+        constexpr output_t operator*() const {
+            return *m_begin;
+        }
+
+        const take_while_range* m_parent;
+        prev_iter_t             m_begin;
+        prev_iter_t             m_end;
+    };
+
+    constexpr take_while_range() = default;
+
+    constexpr take_while_range( const TPrevRange& prev, TPredicate predicate )
+        : m_prev( prev )
+        , m_predicate( std::move( predicate ) ) {
+    }
+
+    constexpr iterator begin() const {
+        return iterator( this, m_prev.begin(), m_prev.end() );
+    }
+
+    constexpr iterator end() const {
+        return iterator( this, m_prev.end(), m_prev.end() );
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint().filtered();
+    }
+
+    template <typename TSink>
+    constexpr auto push( TSink&& sink ) const -> bool {
+        auto sink_stopped = false;
+
+        m_prev.push( [&]( auto&& element ) {
+            if ( !std::invoke( m_predicate, element ) )
+                return false;
+
+            if ( !sink( std::forward<decltype( element )>( element ) ) ) {
+                sink_stopped = true;
+                return false;
+            }
+
+            return true;
+        } );
+
+        return !sink_stopped;
+    }
+
+  private:
+    TPrevRange m_prev;
+    TPredicate m_predicate;
+};
+
+// ----------------------------------
+// skip
+// ----------------------------------
+
+template <typename TPrevRange>
+class skip_range final : public range<skip_range<TPrevRange>, typename TPrevRange::iterator::output_t> {
+  public:
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+        using output_t    = typename prev_iter_t::output_t;
+
+        constexpr iterator( prev_iter_t begin, prev_iter_t end, size_t count )
+            : m_begin( begin ) {
+            if constexpr ( random_access_range<TPrevRange> ) {
+                m_begin += static_cast<std::ptrdiff_t>( std::min( count, static_cast<size_t>( end - begin ) ) );
+            }
+            else {
+                while ( m_begin != end && count > 0 ) {
+                    ++m_begin;
+                    --count;
+                }
+            }
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_begin == o.m_begin;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_begin != o.m_begin;
+        }
+
+        constexpr iterator& operator++() {
+            ++m_begin;
+            return *this;
+        }
+
+        constexpr iterator& operator--()
+            requires( bidirectional_range<TPrevRange> )
+        {
+            --m_begin;
+            return *this;
+        }
+
+        constexpr iterator& operator+=( std::ptrdiff_t count )
+            requires( random_access_range<TPrevRange> )
+        {
+            m_begin += count;
+            return *this;
+        }
+
+        constexpr auto operator-( const iterator& o ) const -> std::ptrdiff_t
+            requires( random_access_range<TPrevRange> )
+        {
+            return m_begin - o.m_begin;
+        }
+
+        constexpr output_t operator*() const {
+            return *m_begin;
+        }
+
+        prev_iter_t m_begin;
+    };
+
+    constexpr skip_range( const TPrevRange& prev, size_t count )
+        : m_prev( prev )
+        , m_count( count ) {
+    }
+
+    constexpr iterator begin() const {
+        return iterator( m_prev.begin(), m_prev.end(), m_count );
+    }
+
+    constexpr iterator end() const {
+        const auto prev_end = m_prev.end();
+        return iterator( prev_end, prev_end, 0 );
+    }
+
+    constexpr auto size() const -> size_t
+        requires( has_fixed_size<TPrevRange> )
+    {
+        const auto prev_size = m_prev.size();
+        return prev_size - std::min( m_count, prev_size );
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint().skipped( m_count );
+    }
+
+    template <typename TSink>
+    constexpr auto push( TSink&& sink ) const -> bool {
+        // Random access ranges skip in constant time.
+        if constexpr ( random_access_range<TPrevRange> ) {
+            return push_elements( begin(), end(), sink );
+        }
+        else {
+            auto remaining = m_count;
+
+            return m_prev.push( [&]( auto&& element ) {
+                if ( remaining > 0 ) {
+                    --remaining;
+                    return true;
+                }
+
+                return sink( std::forward<decltype( element )>( element ) );
+            } );
+        }
+    }
+
+#ifndef LINQ_NO_STL_CONTAINERS
+    template <typename TSink>
+    auto push_batches( TSink&& sink, size_t batch_size ) const -> bool {
+        auto remaining = m_count;
+
+        return m_prev.push_batches(
+            [&]( const auto& batch ) {
+                if ( batch.count <= remaining ) {
+                    remaining -= batch.count;
+                    return true;
+                }
+
+                const auto dropped = batch.dropped( remaining );
+                remaining          = 0;
+
+                return sink( dropped );
+            },
+            batch_size );
+    }
+#endif
+
+  private:
+    TPrevRange m_prev;
+    size_t     m_count{};
+};
+
+// ----------------------------------
+// skip_while
+// ----------------------------------
+
+template <typename TPrevRange, typename TPredicate>
+class skip_while_range final
+    : public range<skip_while_range<TPrevRange, TPredicate>, typename TPrevRange::iterator::output_t> {
+  public:
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+        using output_t    = typename prev_iter_t::output_t;
+
+        constexpr iterator( prev_iter_t begin, prev_iter_t end, const TPredicate& predicate )
+            : m_begin( begin ) {
+            while ( m_begin != end && std::invoke( predicate, *m_begin ) ) {
+                ++m_begin;
+            }
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_begin == o.m_begin;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_begin != o.m_begin;
+        }
+
+        constexpr iterator& operator++() {
+            ++m_begin;
+            return *this;
+        }
+
+        constexpr output_t operator*() const {
+            return *m_begin;
+        }
+
+        prev_iter_t m_begin;
+    };
+
+    constexpr skip_while_range( const TPrevRange& prev, TPredicate predicate )
+        : m_prev( prev )
+        , m_predicate( std::move( predicate ) ) {
+    }
+
+    constexpr iterator begin() const {
+        return iterator( m_prev.begin(), m_prev.end(), m_predicate );
+    }
+
+    constexpr iterator end() const {
+        const auto prev_end = m_prev.end();
+        return iterator( prev_end, prev_end, m_predicate );
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint().filtered();
+    }
+
+    template <typename TSink>
+    constexpr auto push( TSink&& sink ) const -> bool {
+        auto skipping = true;
+
+        return m_prev.push( [&]( auto&& element ) {
+            if ( skipping ) {
+                if ( std::invoke( m_predicate, element ) )
+                    return true;
+
+                skipping = false;
+            }
+
+            return sink( std::forward<decltype( element )>( element ) );
+        } );
+    }
+
+  private:
+    TPrevRange m_prev;
+    TPredicate m_predicate;
+};
+
+// ----------------------------------
+// append
+// ----------------------------------
+
+template <typename TPrevRange, typename TOtherRange>
+class append_range final
+    : public range<append_range<TPrevRange, TOtherRange>, typename TPrevRange::iterator::output_t> {
+  public:
+    using other_range_iter_t = typename TOtherRange::iterator;
+
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+        using output_t    = typename prev_iter_t::output_t;
+
+        constexpr iterator(
+            prev_iter_t        begin,
+            prev_iter_t        end,
+            other_range_iter_t other_begin,
+            other_range_iter_t other_end )
+            : m_my_begin( begin )
+            , m_my_end( end )
+            , m_other_begin( other_begin )
+            , m_other_end( other_end ) {
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_other_begin == o.m_other_begin;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_other_begin != o.m_other_begin;
+        }
+
+        constexpr iterator& operator++() {
+            if ( m_my_begin != m_my_end )
+                ++m_my_begin;
+            else
+                ++m_other_begin;
+
+            return *this;
+        }
+
+        constexpr output_t operator*() const {
+            return m_my_begin != m_my_end ? *m_my_begin : *m_other_begin;
+        }
+
+        prev_iter_t        m_my_begin;
+        prev_iter_t        m_my_end;
+        other_range_iter_t m_other_begin;
+        other_range_iter_t m_other_end;
+    };
+
+    constexpr append_range( const TPrevRange& prev, const TOtherRange& other_range )
+        : m_prev( prev )
+        , m_other_range( other_range ) {
+    }
+
+    constexpr iterator begin() const {
+        return iterator( m_prev.begin(), m_prev.end(), m_other_range.begin(), m_other_range.end() );
+    }
+
+    constexpr iterator end() const {
+        const auto prev_end  = m_prev.end();
+        const auto other_end = m_other_range.end();
+        return iterator( prev_end, prev_end, other_end, other_end );
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint() + m_other_range.size_hint();
+    }
+
+    template <typename TSink>
+    constexpr auto push( TSink&& sink ) const -> bool {
+        return m_prev.push( sink ) && m_other_range.push( sink );
+    }
+
+  private:
+    TPrevRange  m_prev;
+    TOtherRange m_other_range;
+};
+
+// ----------------------------------
+// repeat
+// ----------------------------------
+
+template <typename TPrevRange>
+class repeat_range final : public range<repeat_range<TPrevRange>, typename TPrevRange::iterator::output_t> {
+  public:
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+        using output_t    = typename prev_iter_t::output_t;
+
+        constexpr iterator( TPrevRange* prev_range_ptr, prev_iter_t begin, prev_iter_t end, size_t count )
+            : m_prev_range_ptr( prev_range_ptr )
+            , m_pos( begin )
+            , m_end( end )
+            , m_count( count ) {
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_pos == o.m_pos;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_pos != o.m_pos;
+        }
+
+        constexpr iterator& operator++() {
+            ++m_pos;
+
+            if ( m_pos == m_end && m_count > 0 ) {
+                m_pos = m_prev_range_ptr->begin();
+                --m_count;
+            }
+
+            return *this;
+        }
+
+        constexpr output_t operator*() const {
+            return *m_pos;
+        }
+
+        TPrevRange* m_prev_range_ptr{};
+        prev_iter_t m_pos{};
+        prev_iter_t m_end{};
+        size_t      m_count{};
+    };
+
+    constexpr repeat_range( const TPrevRange& prev, size_t count )
+        : m_prev( prev )
+        , m_count( count ) {
+    }
+
+    constexpr iterator begin() const {
+        return iterator( &m_prev, m_prev.begin(), m_prev.end(), m_count );
+    }
+
+    constexpr iterator end() const {
+        const auto prev_end = m_prev.end();
+        return iterator( &m_prev, prev_end, prev_end, 0 );
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint().repeated( m_count + 1 );
+    }
+
+    template <typename TSink>
+    constexpr auto push( TSink&& sink ) const -> bool {
+        auto any_elements = false;
+
+        const auto first_pass = m_prev.push( [&]( auto&& element ) {
+            any_elements = true;
+            return sink( std::forward<decltype( element )>( element ) );
+        } );
+
+        if ( !first_pass )
+            return false;
+
+        // An empty range stays empty, no matter how often it is repeated.
+        if ( !any_elements )
+            return true;
+
+        for ( size_t i = 0; i < m_count; ++i ) {
+            if ( !m_prev.push( sink ) )
+                return false;
+        }
+
+        return true;
+    }
+
+  private:
+    mutable TPrevRange m_prev;
+    size_t             m_count;
+};
+
+#ifndef LINQ_NO_STL_CONTAINERS
+
+// ----------------------------------
+// batched
+// ----------------------------------
+
+template <typename TPrevRange>
+class batched_range final : public range<batched_range<TPrevRange>, typename TPrevRange::iterator::output_t> {
+  public:
+    using iterator = typename TPrevRange::iterator;
+
+    constexpr batched_range( const TPrevRange& prev, size_t batch_size )
+        : m_prev( prev )
+        , m_batch_size( batch_size ) {
+        LINQ_ASSERT( batch_size > 0 && batch_size <= UINT32_MAX && "invalid batch size" );
+    }
+
+    constexpr auto begin() const -> iterator {
+        return m_prev.begin();
+    }
+
+    constexpr auto end() const -> iterator {
+        return m_prev.end();
+    }
+
+    constexpr auto size() const -> size_t
+        requires( has_fixed_size<TPrevRange> )
+    {
+        return m_prev.size();
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint();
+    }
+
+    template <typename TSink>
+    auto push( TSink&& sink ) const -> bool {
+        return m_prev.push_batches(
+            [&sink]( const auto& batch ) {
+                return batch.for_each_selected( sink );
+            },
+            m_batch_size );
+    }
+
+    template <typename TSink>
+    auto push_batches( TSink&& sink, size_t batch_size ) const -> bool {
+        return m_prev.push_batches( std::forward<TSink>( sink ), batch_size );
+    }
+
+    constexpr auto batch_size() const -> size_t {
+        return m_batch_size;
+    }
+
+  private:
+    TPrevRange m_prev;
+    size_t     m_batch_size{};
+};
+
+// Terminal operations that only need the batches, not each element, consume batched ranges directly.
+template <typename TRange>
+struct is_batched_range : std::false_type {};
+
+template <typename TPrevRange>
+struct is_batched_range<batched_range<TPrevRange>> : std::true_type {};
+
+template <typename TRange>
+static constexpr bool is_batched_range_v = is_batched_range<TRange>::value;
+
+#endif // LINQ_NO_STL_CONTAINERS
+
+// ----------------------------------
+// join
+// ----------------------------------
+
+// Determines the output of a selection in the join range.
+template <typename TRangeA, typename TRangeB, typename TTransform>
+using join_output_t =
+    std::invoke_result_t<TTransform, typename TRangeA::iterator::output_t, typename TRangeB::iterator::output_t>;
+
+// Nested loop inner join operator.
+template <
+    typename TPrevRange,
+    typename TOtherRange,
+    typename TKeySelectorA,
+    typename TKeySelectorB,
+    typename TTransform>
+class join_range final : public range<
+                             join_range<TPrevRange, TOtherRange, TKeySelectorA, TKeySelectorB, TTransform>,
+                             join_output_t<TPrevRange, TOtherRange, TTransform>> {
+    using other_range_iter_t = typename TOtherRange::iterator;
+
+  public:
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+        using output_t    = join_output_t<TPrevRange, TOtherRange, TTransform>;
+
+        constexpr iterator( prev_iter_t begin, prev_iter_t end, const join_range* parent )
+            : m_begin( begin )
+            , m_end( end )
+            , m_pos( begin )
+            , m_other_begin( parent->m_other_range.begin() )
+            , m_other_end( parent->m_other_range.end() )
+            , m_other_pos( parent->m_other_range.begin() )
+            , m_parent( parent ) {
+            // Find the first match without pre-incrementing the
+            // other position, so that we start at the beginning.
+            find_next( false );
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_pos == o.m_pos;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_pos != o.m_pos;
+        }
+
+        constexpr iterator& operator++() {
+            // Find the next match, but pre-increment the other
+            // position, so that we can move forward.
+            find_next( true );
+            return *this;
+        }
+
+        constexpr output_t operator*() const {
+            return m_parent->m_transform( *m_pos, *m_other_pos );
+        }
+
+        prev_iter_t m_begin;
+        prev_iter_t m_end;
+        prev_iter_t m_pos;
+
+        other_range_iter_t m_other_begin;
+        other_range_iter_t m_other_end;
+        other_range_iter_t m_other_pos;
+
+        const join_range* m_parent;
+
+      private:
+        // Finds the next match in both ranges using the key selectors and == comparison.
+        constexpr void find_next( bool pre_increment_other ) {
+            const auto& key_selector_a = m_parent->m_key_selector_a;
+            const auto& key_selector_b = m_parent->m_key_selector_b;
+
+            if ( pre_increment_other ) {
+                ++m_other_pos;
+            }
+
+            while ( m_pos != m_end ) {
+                bool       should_continue = true;
+                const auto key_a           = key_selector_a( *m_pos );
+
+                while ( m_other_pos != m_other_end ) {
+                    const auto key_b = key_selector_b( *m_other_pos );
+
+                    if ( key_a == key_b ) {
+                        should_continue = false;
+                        break;
+                    }
+
+                    ++m_other_pos;
+                }
+
+                // Start over in the other range if it's finished.
+                if ( m_other_pos == m_other_end )
+                    m_other_pos = m_other_begin;
+
+                if ( !should_continue ) {
+                    break;
+                }
+
+                ++m_pos;
+            }
+        }
+    };
+
+    constexpr join_range(
+        const TPrevRange& prev,
+        TOtherRange       other_range,
+        TKeySelectorA     key_selector_a,
+        TKeySelectorB     key_selector_b,
+        TTransform        transform )
+        : m_prev( prev )
+        , m_other_range( other_range )
+        , m_key_selector_a( std::move( key_selector_a ) )
+        , m_key_selector_b( std::move( key_selector_b ) )
+        , m_transform( std::move( transform ) ) {
+    }
+
+    constexpr iterator begin() const {
+        return iterator( m_prev.begin(), m_prev.end(), this );
+    }
+
+    constexpr iterator end() const {
+        const auto prev_end = m_prev.end();
+        return iterator( prev_end, prev_end, this );
+    }
+
+  private:
+    TPrevRange    m_prev;
+    TOtherRange   m_other_range;
+    TKeySelectorA m_key_selector_a;
+    TKeySelectorB m_key_selector_b;
+    TTransform    m_transform;
+};
+
+#ifndef LINQ_NO_STL_CONTAINERS
+
+// Determines the decayed type of a key that is selected from a range's elements.
+template <typename TRange, typename TKeySelector>
+using selected_key_t = std::decay_t<std::invoke_result_t<const TKeySelector&, typename TRange::iterator::output_t>>;
+
+// Hash inner join operator.
+// Builds a hash table over the other range once per enumeration and probes it with the keys of this range.
+// Produces the same output order as join_range.
+template <
+    typename TPrevRange,
+    typename TOtherRange,
+    typename TKeySelectorA,
+    typename TKeySelectorB,
+    typename TTransform>
+class hash_join_range final : public range<
+                                  hash_join_range<TPrevRange, TOtherRange, TKeySelectorA, TKeySelectorB, TTransform>,
+                                  join_output_t<TPrevRange, TOtherRange, TTransform>> {
+    using other_range_iter_t = typename TOtherRange::iterator;
+    using key_t              = selected_key_t<TOtherRange, TKeySelectorB>;
+
+    static constexpr auto no_entry = static_cast<size_t>( -1 );
+
+    // An element of the other range, linked to the next element that has the same key.
+    struct other_entry {
+        other_range_iter_t pos;
+        size_t             next;
+    };
+
+    // Maps a key to the first and last entry of its chain.
+    using hash_table_t = std::unordered_map<key_t, std::pair<size_t, size_t>>;
+
+  public:
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+        using output_t    = join_output_t<TPrevRange, TOtherRange, TTransform>;
+
+        constexpr iterator( prev_iter_t begin, prev_iter_t end, const hash_join_range* parent )
+            : m_pos( begin )
+            , m_end( end )
+            , m_parent( parent ) {
+            seek();
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_pos == o.m_pos;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_pos != o.m_pos;
+        }
+
+        constexpr iterator& operator++() {
+            m_entry = m_parent->m_other_entries[m_entry].next;
+
+            if ( m_entry == no_entry ) {
+                ++m_pos;
+                seek();
+            }
+
+            return *this;
+        }
+
+        constexpr output_t operator*() const {
+            return m_parent->m_transform( *m_pos, *m_parent->m_other_entries[m_entry].pos );
+        }
+
+        prev_iter_t            m_pos;
+        prev_iter_t            m_end;
+        size_t                 m_entry{ no_entry };
+        const hash_join_range* m_parent;
+
+      private:
+        // Moves forward to the next element of this range that has at least one match in the other range.
+        constexpr void seek() {
+            const auto& key_selector_a = m_parent->m_key_selector_a;
+            const auto& hash_table     = m_parent->m_hash_table;
+
+            while ( m_pos != m_end ) {
+                if ( const auto it = hash_table.find( key_selector_a( *m_pos ) ); it != hash_table.end() ) {
+                    m_entry = it->second.first;
+                    break;
+                }
+
+                ++m_pos;
+            }
+        }
+    };
+
+    constexpr hash_join_range(
+        const TPrevRange& prev,
+        TOtherRange       other_range,
+        TKeySelectorA     key_selector_a,
+        TKeySelectorB     key_selector_b,
+        TTransform        transform )
+        : m_prev( prev )
+        , m_other_range( other_range )
+        , m_key_selector_a( std::move( key_selector_a ) )
+        , m_key_selector_b( std::move( key_selector_b ) )
+        , m_transform( std::move( transform ) ) {
+    }
+
+    constexpr iterator begin() const {
+        build_hash_table();
+        return iterator( m_prev.begin(), m_prev.end(), this );
+    }
+
+    constexpr iterator end() const {
+        const auto prev_end = m_prev.end();
+        return iterator( prev_end, prev_end, this );
+    }
+
+  private:
+    // Builds the hash table over the other range, keeping the order of elements within each key.
+    constexpr void build_hash_table() const {
+        m_hash_table.clear();
+        m_other_entries.clear();
+
+        const auto other_count = m_other_range.size_hint().lower;
+
+        m_hash_table.reserve( other_count );
+        m_other_entries.reserve( other_count );
+
+        for ( auto pos = m_other_range.begin(), end = m_other_range.end(); pos != end; ++pos ) {
+            const auto index = m_other_entries.size();
+            m_other_entries.push_back( other_entry{ pos, no_entry } );
+
+            const auto [it, inserted] = m_hash_table.try_emplace( m_key_selector_b( *pos ), index, index );
+
+            if ( !inserted ) {
+                m_other_entries[it->second.second].next = index;
+                it->second.second                       = index;
+            }
+        }
+    }
+
+    TPrevRange    m_prev;
+    TOtherRange   m_other_range;
+    TKeySelectorA m_key_selector_a;
+    TKeySelectorB m_key_selector_b;
+    TTransform    m_transform;
+
+    mutable hash_table_t             m_hash_table;
+    mutable std::vector<other_entry> m_other_entries;
+};
+
+#endif // LINQ_NO_STL_CONTAINERS
+
+// Sort-merge inner join operator.
+// Both ranges must be sorted in ascending order by their keys, which are compared using operator<.
+// For every run of equal keys, each element of this range is paired with every element of the
+// other range's run, in the same order that join_range would produce.
+template <
+    typename TPrevRange,
+    typename TOtherRange,
+    typename TKeySelectorA,
+    typename TKeySelectorB,
+    typename TTransform>
+class merge_join_range final : public range<
+                                   merge_join_range<TPrevRange, TOtherRange, TKeySelectorA, TKeySelectorB, TTransform>,
+                                   join_output_t<TPrevRange, TOtherRange, TTransform>> {
+    using other_range_iter_t = typename TOtherRange::iterator;
+
+    // Position within the other range, tracking the start of the current run of equal keys.
+    struct other_cursor {
+        other_range_iter_t run;
+        other_range_iter_t pos;
+        other_range_iter_t end;
+    };
+
+  public:
+    struct iterator {
+        using prev_iter_t = typename TPrevRange::iterator;
+        using output_t    = join_output_t<TPrevRange, TOtherRange, TTransform>;
+
+        constexpr iterator( prev_iter_t begin, prev_iter_t end, const merge_join_range* parent )
+            : m_pos( begin )
+            , m_end( end )
+            , m_parent( parent ) {
+            auto other_begin = parent->m_other_range.begin();
+            m_other.emplace( other_cursor{ other_begin, other_begin, parent->m_other_range.end() } );
+            seek();
+        }
+
+        // Creates the end iterator, which never touches the other range.
+        constexpr explicit iterator( prev_iter_t end )
+            : m_pos( end )
+            , m_end( end )
+            , m_parent( nullptr ) {
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_pos == o.m_pos;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_pos != o.m_pos;
+        }
+
+        constexpr iterator& operator++() {
+            const auto& key_selector_a = m_parent->m_key_selector_a;
+            const auto& key_selector_b = m_parent->m_key_selector_b;
+
+            auto&       other          = *m_other;
+
+            // Continue within the run of the other range.
+            ++other.pos;
+
+            if ( other.pos != other.end && keys_equal( key_selector_a( *m_pos ), key_selector_b( *other.pos ) ) )
+                return *this;
+
+            // The run is finished; start over in it if the next element has the same key.
+            ++m_pos;
+
+            if ( m_pos != m_end && keys_equal( key_selector_a( *m_pos ), key_selector_b( *other.run ) ) ) {
+                other.pos = other.run;
+                return *this;
+            }
+
+            seek();
+
+            return *this;
+        }
+
+        constexpr output_t operator*() const {
+            return m_parent->m_transform( *m_pos, *m_other->pos );
+        }
+
+        prev_iter_t m_pos;
+        prev_iter_t m_end;
+
+        // Empty for the end iterator.
+        std::optional<other_cursor> m_other;
+
+        const merge_join_range* m_parent;
+
+      private:
+        template <typename TKeyA, typename TKeyB>
+        static constexpr bool keys_equal( const TKeyA& a, const TKeyB& b ) {
+            return !( a < b ) && !( b < a );
+        }
+
+        // Advances both ranges in lockstep until their keys match, which starts a new run.
+        constexpr void seek() {
+            const auto& key_selector_a = m_parent->m_key_selector_a;
+            const auto& key_selector_b = m_parent->m_key_selector_b;
+            auto&       other          = *m_other;
+
+            while ( m_pos != m_end && other.pos != other.end ) {
+                const auto key_a = key_selector_a( *m_pos );
+                const auto key_b = key_selector_b( *other.pos );
+
+                if ( key_a < key_b ) {
+                    ++m_pos;
+                }
+                else if ( key_b < key_a ) {
+                    ++other.pos;
+                }
+                else {
+                    other.run = other.pos;
+                    return;
+                }
+            }
+
+            m_pos = m_end;
+        }
+    };
+
+    constexpr merge_join_range(
+        const TPrevRange& prev,
+        TOtherRange       other_range,
+        TKeySelectorA     key_selector_a,
+        TKeySelectorB     key_selector_b,
+        TTransform        transform )
+        : m_prev( prev )
+        , m_other_range( other_range )
+        , m_key_selector_a( std::move( key_selector_a ) )
+        , m_key_selector_b( std::move( key_selector_b ) )
+        , m_transform( std::move( transform ) ) {
+    }
+
+    constexpr iterator begin() const {
+        return iterator( m_prev.begin(), m_prev.end(), this );
+    }
+
+    constexpr iterator end() const {
+        return iterator( m_prev.end() );
+    }
+
+  private:
+    TPrevRange    m_prev;
+    TOtherRange   m_other_range;
+    TKeySelectorA m_key_selector_a;
+    TKeySelectorB m_key_selector_b;
+    TTransform    m_transform;
+};
+
+#ifndef LINQ_NO_STL_CONTAINERS
+
+// ----------------------------------
+// flat_hash_index
+// ----------------------------------
+
+// Open-addressing hash index that maps keys to their position in an external entry array.
+// An entry is either a key or a std::pair whose first member is the key.
+// All slots are stored in a single array, so that the number of allocations does not grow with the
+// number of keys (apart from amortized growth), unlike the node-based std::unordered_map.
+// Entries must be inserted in the order of their position in the entry array.
+template <typename TKey, typename THash = std::hash<TKey>>
+class flat_hash_index {
+  public:
+    static constexpr auto npos = static_cast<size_t>( -1 );
+
+    flat_hash_index() = default;
+
+    explicit flat_hash_index( THash hasher )
+        : m_hasher( std::move( hasher ) ) {
+    }
+
+    auto hash( const TKey& key ) const -> size_t {
+        return m_hasher( key );
+    }
+
+    // Returns the position of a key in entries, or npos if the key is not contained.
+    template <typename TEntries>
+    auto find( const TEntries& entries, const TKey& key, size_t hash ) const -> size_t {
+        if ( m_slots.empty() )
+            return npos;
+
+        for ( auto slot = slot_of( hash );; slot = ( slot + 1 ) & ( m_slots.size() - 1 ) ) {
+            const auto entry = m_slots[slot];
+
+            if ( entry == 0 )
+                return npos;
+
+            if ( key_of( entries[entry - 1] ) == key )
+                return entry - 1;
+        }
+    }
+
+    // Adds entries[size()] to the index.
+    template <typename TEntries>
+    void insert( const TEntries& entries, size_t hash ) {
+        LINQ_ASSERT( entries.size() > m_count && "entry must be stored before it is inserted" );
+
+        if ( ( m_count + 1 ) * 2 > m_slots.size() ) {
+            rehash( entries, std::max( m_slots.size() * 2, static_cast<size_t>( 16 ) ) );
+        }
+
+        place( m_count, hash );
+        ++m_count;
+    }
+
+    // Ensures that count keys can be inserted without rehashing.
+    template <typename TEntries>
+    void reserve( const TEntries& entries, size_t count ) {
+        auto slot_count = std::max( m_slots.size(), static_cast<size_t>( 16 ) );
+
+        while ( slot_count < count * 2 )
+            slot_count *= 2;
+
+        if ( slot_count != m_slots.size() )
+            rehash( entries, slot_count );
+    }
+
+    void clear() {
+        std::fill( m_slots.begin(), m_slots.end(), static_cast<size_t>( 0 ) );
+        m_count = 0;
+    }
+
+    auto size() const -> size_t {
+        return m_count;
+    }
+
+  private:
+    // Maps a hash to its home slot using Fibonacci hashing, which spreads out poorly distributed
+    // hashes such as the identity hash of integers.
+    auto slot_of( size_t hash ) const -> size_t {
+        return static_cast<size_t>( ( static_cast<uint64_t>( hash ) * 0x9E3779B97F4A7C15ull ) >> m_shift );
+    }
+
+    void place( size_t index, size_t hash ) {
+        auto slot = slot_of( hash );
+
+        while ( m_slots[slot] != 0 )
+            slot = ( slot + 1 ) & ( m_slots.size() - 1 );
+
+        m_slots[slot] = index + 1;
+    }
+
+    static auto key_of( const TKey& key ) -> const TKey& {
+        return key;
+    }
+
+    template <typename TValue>
+    static auto key_of( const std::pair<TKey, TValue>& entry ) -> const TKey& {
+        return entry.first;
+    }
+
+    template <typename TEntries>
+    void rehash( const TEntries& entries, size_t slot_count ) {
+        m_slots.assign( slot_count, 0 );
+        m_shift = 64;
+
+        for ( auto n = slot_count; n > 1; n /= 2 )
+            --m_shift;
+
+        for ( size_t i = 0; i < m_count; ++i )
+            place( i, m_hasher( key_of( entries[i] ) ) );
+    }
+
+    THash m_hasher{};
+
+    // Each slot stores the position of a key plus one, or zero if it is empty.
+    std::vector<size_t> m_slots;
+    size_t              m_count{};
+    unsigned            m_shift{ 64 };
+};
+
+// ----------------------------------
+// grouping
+// ----------------------------------
+
+// A group of elements that share the same key.
+// Refers to a contiguous slice of the elements stored in a lookup.
+// An empty group for a key that is not in the lookup owns a copy of its key instead.
+template <typename TKey, typename TElement>
+class grouping final : public range<grouping<TKey, TElement>, TElement> {
+  public:
+    struct iterator {
+        using output_t = const TElement&;
+
+        constexpr explicit iterator( const TElement* pos )
+            : m_pos( pos ) {
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_pos == o.m_pos;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_pos != o.m_pos;
+        }
+
+        constexpr iterator& operator++() {
+            ++m_pos;
+            return *this;
+        }
+
+        constexpr output_t operator*() const {
+            return *m_pos;
+        }
+
+        const TElement* m_pos;
+    };
+
+    constexpr grouping( const TKey* key, const TElement* begin, const TElement* end )
+        : m_key( key )
+        , m_begin( begin )
+        , m_end( end ) {
+    }
+
+    constexpr explicit grouping( TKey key )
+        : m_missing_key( std::move( key ) ) {
+    }
+
+    /// Gets the key that all elements of the group share.
+    constexpr auto key() const -> const TKey& {
+        return m_key ? *m_key : *m_missing_key;
+    }
+
+    constexpr auto begin() const -> iterator {
+        return iterator( m_begin );
+    }
+
+    constexpr auto end() const -> iterator {
+        return iterator( m_end );
+    }
+
+    constexpr auto size() const -> size_t {
+        return static_cast<size_t>( m_end - m_begin );
+    }
+
+  private:
+    const TKey*         m_key{};
+    const TElement*     m_begin{};
+    const TElement*     m_end{};
+    std::optional<TKey> m_missing_key;
+};
+
+// ----------------------------------
+// lookup
+// ----------------------------------
+
+// Stores elements grouped by key in compressed sparse row (CSR) layout:
+// all elements are stored in a single array, ordered by group, and an offset table
+// marks where each group starts. Groups are ordered by the first occurrence of their key,
+// and elements within a group keep their original order.
+template <typename TKey, typename TElement>
+class lookup final : public range<lookup<TKey, TElement>, grouping<TKey, TElement>> {
+  public:
+    using grouping_t = grouping<TKey, TElement>;
+
+    struct iterator {
+        using output_t = grouping_t;
+
+        constexpr iterator( const lookup* parent, size_t index )
+            : m_parent( parent )
+            , m_index( index ) {
+        }
+
+        constexpr bool operator==( const iterator& o ) const {
+            return m_index == o.m_index;
+        }
+
+        constexpr bool operator!=( const iterator& o ) const {
+            return m_index != o.m_index;
+        }
+
+        constexpr iterator& operator++() {
+            ++m_index;
+            return *this;
+        }
+
+        constexpr output_t operator*() const {
+            return m_parent->group_at( m_index );
+        }
+
+        const lookup* m_parent;
+        size_t        m_index{};
+    };
+
+    lookup() = default;
+
+    auto begin() const -> iterator {
+        return iterator( this, 0 );
+    }
+
+    auto end() const -> iterator {
+        return iterator( this, m_keys.size() );
+    }
+
+    /// Gets the number of groups.
+    auto size() const -> size_t {
+        return m_keys.size();
+    }
+
+    /// Gets whether the lookup contains a group for a key.
+    auto contains( const TKey& key ) const -> bool {
+        return m_index.find( m_keys, key, m_index.hash( key ) ) != m_index.npos;
+    }
+
+    /// Gets the group of a key, or an empty group if there is none.
+    auto operator[]( const TKey& key ) const -> grouping_t {
+        const auto index = m_index.find( m_keys, key, m_index.hash( key ) );
+
+        if ( index == m_index.npos )
+            return grouping_t( key );
+
+        return group_at( index );
+    }
+
+    /// Gets the group at a specific index, in order of first occurrence of the keys.
+    auto group_at( size_t index ) const -> grouping_t {
+        LINQ_ASSERT( index < m_keys.size() && "group index out of range" );
+
+        const auto* elements = m_elements.data();
+
+        return grouping_t(
+            std::addressof( m_keys[index] ),
+            elements + m_offsets[index],
+            elements + m_offsets[index + 1] );
+    }
+
+    // Replaces the contents of the lookup with the elements of a range, grouped by key_selector.
+    template <typename TRange, typename TKeySelector>
+    void assign( const TRange& range, const TKeySelector& key_selector ) {
+        m_keys.clear();
+        m_offsets.clear();
+        m_elements.clear();
+        m_index.clear();
+
+        auto elements  = std::vector<TElement>();
+        auto group_ids = std::vector<size_t>();
+
+        const auto count = range.size_hint().lower;
+
+        elements.reserve( count );
+        group_ids.reserve( count );
+
+        // Pass 1: assign a group to each element and count the elements per group.
+        for ( auto&& element : range ) {
+            auto       key   = static_cast<TKey>( std::invoke( key_selector, element ) );
+            const auto hash  = m_index.hash( key );
+            auto       group = m_index.find( m_keys, key, hash );
+
+            if ( group == m_index.npos ) {
+                group = m_keys.size();
+                m_keys.push_back( std::move( key ) );
+                m_index.insert( m_keys, hash );
+                m_offsets.push_back( 0 );
+            }
+
+            ++m_offsets[group];
+            group_ids.push_back( group );
+            elements.emplace_back( std::forward<decltype( element )>( element ) );
+        }
+
+        // Pass 2: turn the counts into start offsets.
+        auto offset = static_cast<size_t>( 0 );
+
+        for ( auto& group_offset : m_offsets )
+            offset += std::exchange( group_offset, offset );
+
+        m_offsets.push_back( offset );
+
+        // Pass 3: determine the source element of each output position and move the elements there.
+        auto sources = std::vector<size_t>( elements.size() );
+
+        for ( size_t i = 0; i < elements.size(); ++i )
+            sources[m_offsets[group_ids[i]]++] = i;
+
+        // The offsets were advanced to the end of each group; shift them back to the start.
+        if ( !m_keys.empty() ) {
+            std::copy_backward( m_offsets.begin(), m_offsets.end() - 2, m_offsets.end() - 1 );
+            m_offsets.front() = 0;
+        }
+
+        m_elements.reserve( elements.size() );
+
+        for ( const auto source : sources )
+            m_elements.push_back( std::move( elements[source] ) );
+    }
+
+    // Replaces the contents of the lookup with groups that were built elsewhere. The keys must be distinct,
+    // and the elements of the group at index i are stored in elements at [offsets[i], offsets[i + 1]).
+    void assign_groups( std::vector<TKey> keys, std::vector<size_t> offsets, std::vector<TElement> elements ) {
+        LINQ_ASSERT( offsets.size() == keys.size() + 1 && offsets.back() == elements.size() && "invalid groups" );
+
+        m_keys     = std::move( keys );
+        m_offsets  = std::move( offsets );
+        m_elements = std::move( elements );
+
+        m_index.clear();
+        m_index.reserve( m_keys, m_keys.size() );
+
+        for ( const auto& key : m_keys )
+            m_index.insert( m_keys, m_index.hash( key ) );
+    }
+
+  private:
+    std::vector<TKey>     m_keys;
+    std::vector<size_t>   m_offsets;
+    std::vector<TElement> m_elements;
+    flat_hash_index<TKey> m_index;
+};
+
+// Determines the lookup type that groups the elements of a range by a key selector.
+template <typename TRange, typename TKeySelector>
+using lookup_t = lookup<selected_key_t<TRange, TKeySelector>, typename TRange::output_t>;
+
+// ----------------------------------
+// group_by
+// ----------------------------------
+
+template <typename TPrevRange, typename TKeySelector>
+class group_by_range final
+    : public range<group_by_range<TPrevRange, TKeySelector>, typename lookup_t<TPrevRange, TKeySelector>::grouping_t> {
+    using lookup_type = lookup_t<TPrevRange, TKeySelector>;
+
+  public:
+    using iterator = typename lookup_type::iterator;
+
+    constexpr group_by_range( const TPrevRange& prev, TKeySelector key_selector )
+        : m_prev( prev )
+        , m_key_selector( std::move( key_selector ) ) {
+    }
+
+    auto begin() const -> iterator {
+        m_lookup.assign( m_prev, m_key_selector );
+        return m_lookup.begin();
+    }
+
+    auto end() const -> iterator {
+        return m_lookup.end();
+    }
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint().deduplicated();
+    }
+
+  private:
+    TPrevRange          m_prev;
+    TKeySelector        m_key_selector;
+    mutable lookup_type m_lookup;
+};
+
+// ----------------------------------
+// aggregate_by
+// ----------------------------------
+
+// Marks an aggregate_by_range whose accumulators start with the first element of each key.
+struct reduce_seed {
+    // Nothing to define here.
+};
+
+// Determines the accumulator type of an aggregate_by_range.
+template <typename TPrevRange, typename TSeed>
+using aggregate_by_accumulator_t =
+    std::conditional_t<std::is_same_v<TSeed, reduce_seed>, typename TPrevRange::output_t, TSeed>;
+
+// Streaming hash aggregation.
+// Keeps one accumulator per key, so memory scales with the number of distinct keys
+// rather than with the number of elements.
+template <typename TPrevRange, typename TKeySelector, typename TSeed, typename TAccumFunc>
+class aggregate_by_range final
+    : public range<
+          aggregate_by_range<TPrevRange, TKeySelector, TSeed, TAccumFunc>,
+          std::pair<selected_key_t<TPrevRange, TKeySelector>, aggregate_by_accumulator_t<TPrevRange, TSeed>>> {
+    using key_t         = selected_key_t<TPrevRange, TKeySelector>;
+    using accumulator_t = aggregate_by_accumulator_t<TPrevRange, TSeed>;
+    using entry_t       = std::pair<key_t, accumulator_t>;
+    using container_t   = std::vector<entry_t>;
 
-template <typename TPrevRange, typename TTransform>
-class select_range final : public range<select_range<TPrevRange, TTransform>, select_output_t<TPrevRange, TTransform>> {
   public:
     struct iterator {
-        using prev_iter_t = typename TPrevRange::iterator;
-        using output_t    = select_output_t<TPrevRange, TTransform>;
+        using container_iter_t = typename container_t::const_iterator;
+        using output_t         = const entry_t&;
 
-        constexpr iterator( const select_range* parent, prev_iter_t begin, prev_iter_t end )
-            : m_parent( parent )
-            , m_begin( begin )
-            , m_end( end ) {
+        constexpr explicit iterator( container_iter_t pos )
+            : m_pos( pos ) {
         }
 
         constexpr bool operator==( const iterator& o ) const {
-            return m_begin == o.m_begin;
+            return m_pos == o.m_pos;
         }
 
         constexpr bool operator!=( const iterator& o ) const {
-            return m_begin != o.m_begin;
+            return m_pos != o.m_pos;
         }
 
         constexpr iterator& operator++() {
-            ++m_begin;
+            ++m_pos;
             return *this;
         }
 
         constexpr output_t operator*() const {
-            return m_parent->m_transform( *m_begin );
+            return *m_pos;
         }
 
-        const select_range* m_parent;
-        prev_iter_t         m_begin;
-        prev_iter_t         m_end;
+        container_iter_t m_pos;
     };
 
-    constexpr select_range( const TPrevRange& prev, TTransform transform )
+    constexpr aggregate_by_range( const TPrevRange& prev, TKeySelector key_selector, TSeed seed, TAccumFunc func )
         : m_prev( prev )
-        , m_transform( std::move( transform ) ) {
+        , m_key_selector( std::move( key_selector ) )
+        , m_seed( std::move( seed ) )
+        , m_func( std::move( func ) ) {
     }
 
-    constexpr auto begin() const -> iterator {
-        return iterator( this, m_prev.begin(), m_prev.end() );
+    auto begin() const -> iterator {
+        m_entries.clear();
+        m_index.clear();
+
+        for ( auto&& element : m_prev ) {
+            auto       key   = static_cast<key_t>( std::invoke( m_key_selector, element ) );
+            const auto hash  = m_index.hash( key );
+            const auto index = m_index.find( m_entries, key, hash );
+
+            if ( index != m_index.npos ) {
+                auto& accumulator = m_entries[index].second;
+                accumulator       = std::invoke( m_func, std::move( accumulator ), element );
+            }
+            else if constexpr ( std::is_same_v<TSeed, reduce_seed> ) {
+                m_entries.emplace_back( std::move( key ), element );
+                m_index.insert( m_entries, hash );
+            }
+            else {
+                m_entries.emplace_back( std::move( key ), std::invoke( m_func, accumulator_t( m_seed ), element ) );
+                m_index.insert( m_entries, hash );
+            }
+        }
+
+        return iterator( m_entries.cbegin() );
     }
 
-    constexpr auto end() const -> iterator {
-        const auto prev_end = m_prev.end();
-        return iterator( this, prev_end, prev_end );
+    auto end() const -> iterator {
+        return iterator( m_entries.cend() );
     }
 
-    constexpr auto size() const -> size_t {
-        return m_prev.size();
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint().deduplicated();
     }
 
   private:
-    TPrevRange m_prev;
-    TTransform m_transform{};
+    TPrevRange   m_prev;
+    TKeySelector m_key_selector;
+    TSeed        m_seed;
+    TAccumFunc   m_func;
+
+    mutable container_t            m_entries;
+    mutable flat_hash_index<key_t> m_index;
 };
 
+#endif // LINQ_NO_STL_CONTAINERS
+
 // ----------------------------------
-// select_to_string
+// sort_key_cache
 // ----------------------------------
 
-template <typename TPrevRange, typename StringType>
-class select_to_string_range final : public range<select_to_string_range<TPrevRange, StringType>, StringType> {
+// Stores the sort keys of elements, so that each key is computed exactly once per sort
+// instead of twice per comparison. Keys that are returned by reference are referenced, not copied.
+template <typename TElement, typename TKeySelector>
+class sort_key_cache {
+    using result_t = std::invoke_result_t<const TKeySelector&, const TElement&>;
+
   public:
-    struct iterator {
-        using prev_iter_t = typename TPrevRange::iterator;
-        using output_t    = StringType;
+    using key_t = std::decay_t<result_t>;
 
-        constexpr iterator( const select_to_string_range* parent, prev_iter_t begin, prev_iter_t end )
-            : m_parent( parent )
-            , m_begin( begin )
-            , m_end( end ) {
-        }
+    static constexpr bool stores_references = std::is_lvalue_reference_v<result_t>;
 
-        constexpr auto operator==( const iterator& o ) const -> bool {
-            return m_begin == o.m_begin;
-        }
+    void clear() {
+        m_keys.clear();
+    }
 
-        constexpr auto operator!=( const iterator& o ) const -> bool {
-            return m_begin != o.m_begin;
+    void reserve( size_t count ) {
+        m_keys.reserve( count );
+    }
+
+    // Computes the key of an element and stores it at a slot, which is either overwritten or appended.
+    void store( size_t slot, const TElement& element, const TKeySelector& key_selector ) {
+        if constexpr ( stores_references ) {
+            assign( slot, std::addressof( std::invoke( key_selector, element ) ) );
         }
+        else if constexpr ( std::is_same_v<key_t, bool> ) {
+            assign( slot, bool_key{ std::invoke( key_selector, element ) } );
+        }
+        else {
+            assign( slot, std::invoke( key_selector, element ) );
+        }
+    }
 
-        constexpr auto operator++() -> iterator& {
-            ++m_begin;
-            return *this;
+    auto get( size_t slot ) const -> const key_t& {
+        if constexpr ( stores_references ) {
+            return *m_keys[slot];
+        }
+        else if constexpr ( std::is_same_v<key_t, bool> ) {
+            return m_keys[slot].value;
         }
+        else {
+            return m_keys[slot];
+        }
+    }
 
-#if 0
-#ifdef __cpp_lib_constexpr_charconv
-        constexpr
-#endif
-                auto
-                operator*() const -> output_t requires(number<typename TPrevRange::output_t>) {
-                    constexpr auto buffer_size = static_cast<size_t>(32);
-                    char buffer[buffer_size]{};
+  private:
+    // Wraps bool keys, since std::vector<bool> cannot refer to its elements.
+    struct bool_key {
+        bool value;
+    };
 
-                    const auto result = [&]() -> std::to_chars_result {
-                        if constexpr (std::is_integral_v<typename TPrevRange::output_t>) {
-                            return std::to_chars(buffer, &buffer[buffer_size], *m_begin, m_parent->m_int_base);
-                        }
+    using stored_t = std::conditional_t<
+        stores_references,
+        const key_t*,
+        std::conditional_t<std::is_same_v<key_t, bool>, bool_key, key_t>>;
 
-                        return std::to_chars(buffer, &buffer[buffer_size], *m_begin, m_parent->m_float_format);
-                    }();
+    void assign( size_t slot, stored_t key ) {
+        if ( slot == m_keys.size() )
+            m_keys.push_back( std::move( key ) );
+        else
+            m_keys[slot] = std::move( key );
+    }
 
-                    if (result.ec == std::errc()) {
-                        const auto char_count = static_cast<size_t>(result.ptr - buffer);
-                        return StringType(buffer, char_count);
-                    }
+    std::vector<stored_t> m_keys;
+};
 
-                    return StringType("?");
-                }
+// ----------------------------------
+// order_by
+// ----------------------------------
+
+// Compares two sort keys according to a sort direction.
+// Returns a negative value if a is ordered before b, a positive value if b is ordered before a,
+// and zero if both are equivalent.
+template <typename TKey>
+constexpr auto compare_sort_keys( const TKey& a, const TKey& b, sort_direction sort_dir ) -> int {
+    LINQ_ASSERT(
+        ( sort_dir == sort_direction::ascending || sort_dir == sort_direction::descending ) &&
+        "invalid sort direction" );
+
+    auto result = 0;
+
+#ifdef __cpp_lib_three_way_comparison
+    if constexpr ( std::three_way_comparable<TKey> ) {
+        const auto order = a <=> b;
+        result           = order < 0 ? -1 : ( order > 0 ? 1 : 0 );
+    }
+    else
 #endif
+    {
+        result = a < b ? -1 : ( b < a ? 1 : 0 );
+    }
 
-        auto operator*() const -> output_t
-            requires( std::is_same_v<typename TPrevRange::output_t, char> )
-        {
-            return StringType( 1, *m_begin );
+    return sort_dir == sort_direction::ascending ? result : -result;
+}
+
+// Indicates whether sort keys of a type can be sorted by radix sort, i.e. whether they can be
+// mapped to unsigned integers that preserve their order.
+template <typename TKey>
+static constexpr bool is_radix_sort_key_v =
+    ( std::is_integral_v<TKey> || std::is_enum_v<TKey> || std::is_same_v<TKey, float> ||
+      std::is_same_v<TKey, double> ) &&
+    sizeof( TKey ) <= sizeof( std::uint64_t );
+
+// Maps an arithmetic or enum sort key to an unsigned integer with the same order,
+// taking the sort direction into account.
+template <typename TKey>
+auto to_radix_key( TKey key, sort_direction sort_dir ) -> std::uint64_t {
+    auto bits = std::uint64_t();
+
+    if constexpr ( std::is_enum_v<TKey> ) {
+        return to_radix_key( static_cast<std::underlying_type_t<TKey>>( key ), sort_dir );
+    }
+    else if constexpr ( std::is_floating_point_v<TKey> ) {
+        using bits_t = std::conditional_t<sizeof( TKey ) == 4, std::uint32_t, std::uint64_t>;
+
+        constexpr auto sign_bit = bits_t( 1 ) << ( sizeof( TKey ) * 8 - 1 );
+
+        // -0.0 and 0.0 are equivalent.
+        if ( key == TKey( 0 ) )
+            key = TKey( 0 );
+
+        auto float_bits = bits_t();
+        std::memcpy( &float_bits, &key, sizeof( TKey ) );
+
+        // Negative values are ordered in reverse by their magnitude, and before all positive values.
+        bits = ( float_bits & sign_bit ) != 0 ? static_cast<bits_t>( ~float_bits ) : ( float_bits | sign_bit );
+    }
+    else if constexpr ( std::is_signed_v<TKey> ) {
+        using bits_t = std::make_unsigned_t<TKey>;
+
+        constexpr auto sign_bit = static_cast<bits_t>( bits_t( 1 ) << ( sizeof( TKey ) * 8 - 1 ) );
+
+        bits = static_cast<bits_t>( static_cast<bits_t>( key ) ^ sign_bit );
+    }
+    else {
+        bits = static_cast<std::uint64_t>( key );
+    }
+
+    return sort_dir == sort_direction::ascending ? bits : ~bits;
+}
+
+// A slot together with its radix key, which is moved along with it during radix sort
+// so that every pass reads the keys sequentially.
+struct radix_entry {
+    std::uint64_t key;
+    size_t        slot;
+};
+
+// Stably sorts slots by their radix keys.
+// Keys that span a small domain are sorted by a single counting sort pass,
+// all others by an LSD radix sort with digits of up to 12 bits.
+inline void radix_sort_entries( std::vector<radix_entry>& entries, std::vector<radix_entry>& buffer ) {
+    const auto count = entries.size();
+
+    if ( count == 0 )
+        return;
+
+    auto min_key = entries.front().key;
+    auto max_key = min_key;
+
+    for ( const auto& entry : entries ) {
+        min_key = std::min( min_key, entry.key );
+        max_key = std::max( max_key, entry.key );
+    }
+
+    const auto key_range = max_key - min_key;
+
+    if ( key_range == 0 )
+        return;
+
+    const auto is_small_domain = key_range < std::min<std::uint64_t>( std::max<std::uint64_t>( count, 256 ), 1 << 16 );
+
+    auto key_bits = 0u;
+
+    while ( key_bits < 64 && ( key_range >> key_bits ) != 0 )
+        ++key_bits;
+
+    const auto pass_count   = is_small_domain ? 1u : ( key_bits + 11 ) / 12;
+    const auto digit_bits   = ( key_bits + pass_count - 1 ) / pass_count;
+    const auto bucket_count = is_small_domain ? static_cast<size_t>( key_range ) + 1 : size_t( 1 ) << digit_bits;
+    const auto digit_mask   = is_small_domain ? ~std::uint64_t( 0 ) : ( std::uint64_t( 1 ) << digit_bits ) - 1;
+
+    // The histograms of all passes are computed up front, in a single pass over the keys.
+    auto counts = std::vector<size_t>( pass_count * bucket_count );
+
+    for ( auto& entry : entries ) {
+        entry.key -= min_key;
+
+        for ( auto pass = 0u; pass < pass_count; ++pass )
+            ++counts[pass * bucket_count + static_cast<size_t>( ( entry.key >> ( pass * digit_bits ) ) & digit_mask )];
+    }
+
+    buffer.resize( count );
+
+    for ( auto pass = 0u; pass < pass_count; ++pass ) {
+        const auto shift     = pass * digit_bits;
+        const auto histogram = counts.data() + pass * bucket_count;
+
+        // Every entry has the same digit.
+        if ( histogram[static_cast<size_t>( ( entries.front().key >> shift ) & digit_mask )] == count )
+            continue;
+
+        auto offset = size_t( 0 );
+
+        for ( size_t bucket = 0; bucket < bucket_count; ++bucket )
+            offset += std::exchange( histogram[bucket], offset );
+
+        for ( const auto& entry : entries )
+            buffer[histogram[static_cast<size_t>( ( entry.key >> shift ) & digit_mask )]++] = entry;
+
+        entries.swap( buffer );
+    }
+}
+
+// Indicates whether a range yields references to elements that outlive the range's iterators,
+// such as the elements of a container.
+template <typename TRange>
+struct has_stable_references : std::false_type {};
+
+template <typename TContainer>
+struct has_stable_references<container_range<TContainer>>
+    : std::is_reference<typename TContainer::const_reference> {};
+
+template <typename TContainer>
+struct has_stable_references<mutable_container_range<TContainer>>
+    : std::is_reference<typename TContainer::reference> {};
+
+template <typename TPrevRange, typename TPredicate>
+struct has_stable_references<where_range<TPrevRange, TPredicate>> : has_stable_references<TPrevRange> {};
+
+template <typename TPrevRange>
+struct has_stable_references<take_range<TPrevRange>> : has_stable_references<TPrevRange> {};
+
+template <typename TPrevRange>
+struct has_stable_references<cache_range<TPrevRange>> : std::true_type {};
+
+template <typename TPrevRange, typename TPredicate>
+struct has_stable_references<take_while_range<TPrevRange, TPredicate>> : has_stable_references<TPrevRange> {};
+
+template <typename TPrevRange>
+struct has_stable_references<skip_range<TPrevRange>> : has_stable_references<TPrevRange> {};
+
+template <typename TPrevRange, typename TPredicate>
+struct has_stable_references<skip_while_range<TPrevRange, TPredicate>> : has_stable_references<TPrevRange> {};
+
+template <typename TRange>
+static constexpr bool has_stable_references_v = has_stable_references<TRange>::value;
+
+// Describes how a sort chain stores its elements: as pointers into its source if the source
+// has stable references, or as copies otherwise.
+template <typename TSourceRange>
+struct sort_element_storage {
+    using element_t = std::decay_t<typename TSourceRange::iterator::output_t>;
+
+    static constexpr bool stores_pointers = has_stable_references_v<TSourceRange>;
+
+    using stored_t = std::conditional_t<stores_pointers, const element_t*, element_t>;
+
+    static constexpr auto store( const element_t& element ) -> stored_t {
+        if constexpr ( stores_pointers ) {
+            return std::addressof( element );
         }
+        else {
+            return element;
+        }
+    }
 
-        auto operator*() const -> output_t {
-            return LINQ_TO_STRING_FUNC( *m_begin );
+    static constexpr auto get( const stored_t& stored ) -> const element_t& {
+        if constexpr ( stores_pointers ) {
+            return *stored;
+        }
+        else {
+            return stored;
         }
+    }
+};
 
-        const select_to_string_range* m_parent{};
-        prev_iter_t                   m_begin;
-        prev_iter_t                   m_end;
-    };
+// Iterates over sorted elements by following a permutation of their indices.
+template <typename TStorage>
+struct sorted_elements_iterator {
+    using stored_t = typename TStorage::stored_t;
+    using output_t = const typename TStorage::element_t&;
 
-    constexpr explicit select_to_string_range(
-        const TPrevRange&       prev,
-        const int               int_base,
-        const std::chars_format float_format )
-        : m_prev( prev )
-        , m_int_base( int_base )
-        , m_float_format( float_format ) {
+    constexpr sorted_elements_iterator( const std::vector<stored_t>* elements, const size_t* pos )
+        : m_elements( elements )
+        , m_pos( pos ) {
     }
 
-    constexpr auto begin() const -> iterator {
-        return iterator( this, m_prev.begin(), m_prev.end() );
+    constexpr bool operator==( const sorted_elements_iterator& o ) const {
+        return m_pos == o.m_pos;
     }
 
-    constexpr auto end() const -> iterator {
-        const auto prev_end = m_prev.end();
-        return iterator( this, prev_end, prev_end );
+    constexpr bool operator!=( const sorted_elements_iterator& o ) const {
+        return m_pos != o.m_pos;
     }
 
-    constexpr auto size() const -> size_t {
-        return m_prev.size();
+    constexpr sorted_elements_iterator& operator++() {
+        ++m_pos;
+        return *this;
+    }
+
+    constexpr sorted_elements_iterator& operator--() {
+        --m_pos;
+        return *this;
+    }
+
+    constexpr sorted_elements_iterator& operator+=( std::ptrdiff_t count ) {
+        m_pos += count;
+        return *this;
+    }
+
+    constexpr auto operator-( const sorted_elements_iterator& o ) const -> std::ptrdiff_t {
+        return m_pos - o.m_pos;
+    }
+
+    constexpr output_t operator*() const {
+        return TStorage::get( ( *m_elements )[*m_pos] );
+    }
+
+    const std::vector<stored_t>* m_elements;
+    const size_t*                m_pos;
+};
+
+#ifndef LINQ_NO_THREADS
+// Finds how many of the first count elements of the stable merge of [a, a + a_size)
+// and [b, b + b_size) come from a.
+template <typename TIter, typename TCompare>
+auto merge_split( TIter a, size_t a_size, TIter b, size_t b_size, size_t count, const TCompare& is_before ) -> size_t {
+    auto low  = count > b_size ? count - b_size : 0;
+    auto high = std::min( count, a_size );
+
+    while ( low < high ) {
+        const auto i = low + ( high - low ) / 2;
+        const auto j = count - i;
+
+        // Elements of a that are not ordered after b[j - 1] precede it.
+        if ( j > 0 && !is_before( b[j - 1], a[i] ) )
+            low = i + 1;
+        else
+            high = i;
     }
 
-  private:
-    TPrevRange        m_prev;
-    int               m_int_base;
-    std::chars_format m_float_format;
-};
+    return low;
+}
+
+// Sorts a permutation of slots on multiple threads: every thread sorts one run, after which
+// adjacent runs are merged pairwise, with every merge split into independent parts.
+// Merging takes equivalent elements from the left run first, so stable runs stay stable.
+template <typename TCompare>
+void parallel_sort_slots(
+    std::vector<size_t>& order,
+    const TCompare&      is_before,
+    sort_stability       stability,
+    const executor_ref&  executor,
+    size_t               thread_count ) {
+    const auto count = order.size();
+    auto       runs  = std::vector<size_t>( thread_count + 1 );
+
+    for ( size_t run = 0; run <= thread_count; ++run )
+        runs[run] = count * run / thread_count;
+
+    run_tasks( executor, thread_count, thread_count, [&]( size_t run ) {
+        const auto first = order.begin() + static_cast<std::ptrdiff_t>( runs[run] );
+        const auto last  = order.begin() + static_cast<std::ptrdiff_t>( runs[run + 1] );
+
+        if ( stability == sort_stability::stable )
+            std::stable_sort( first, last, is_before );
+        else
+            std::sort( first, last, is_before );
+
+        return true;
+    } );
+
+    auto buffer = std::vector<size_t>( count );
+
+    while ( runs.size() > 2 ) {
+        const auto run_count   = runs.size() - 1;
+        const auto merge_count = ( run_count + 1 ) / 2;
+        const auto part_count  = std::max<size_t>( thread_count / merge_count, 1 );
+
+        run_tasks( executor, merge_count * part_count, thread_count, [&]( size_t task ) {
+            const auto merge = task / part_count;
+            const auto part  = task % part_count;
+
+            const auto a_first = runs[merge * 2];
+            const auto b_first = runs[std::min( merge * 2 + 1, run_count )];
+            const auto b_last  = runs[std::min( merge * 2 + 2, run_count )];
+            const auto a_size  = b_first - a_first;
+            const auto b_size  = b_last - b_first;
+
+            const auto a = order.begin() + static_cast<std::ptrdiff_t>( a_first );
+            const auto b = order.begin() + static_cast<std::ptrdiff_t>( b_first );
+
+            const auto out_first = ( a_size + b_size ) * part / part_count;
+            const auto out_last  = ( a_size + b_size ) * ( part + 1 ) / part_count;
+            const auto i_first   = merge_split( a, a_size, b, b_size, out_first, is_before );
+            const auto i_last    = merge_split( a, a_size, b, b_size, out_last, is_before );
+
+            std::merge(
+                a + static_cast<std::ptrdiff_t>( i_first ),
+                a + static_cast<std::ptrdiff_t>( i_last ),
+                b + static_cast<std::ptrdiff_t>( out_first - i_first ),
+                b + static_cast<std::ptrdiff_t>( out_last - i_last ),
+                buffer.begin() + static_cast<std::ptrdiff_t>( a_first + out_first ),
+                is_before );
+
+            return true;
+        } );
+
+        order.swap( buffer );
 
-// ----------------------------------
-// select_many
-// ----------------------------------
+        auto merged_runs = std::vector<size_t>();
 
-template <typename TPrevRange, typename TTransform>
-struct select_many_traits {
-    using returned_range_t = std::invoke_result_t<TTransform, typename TPrevRange::iterator::output_t>;
+        for ( size_t run = 0; run < run_count; run += 2 )
+            merged_runs.push_back( runs[run] );
 
-    // See if the returned type is really a range.
-    static_assert(
-        std::is_base_of_v<range_ident, returned_range_t>,
-        "The transform function of select_many is expected to return a linq range." );
+        merged_runs.push_back( count );
+        runs.swap( merged_runs );
+    }
+}
+#endif
 
-    using output_t = typename returned_range_t::iterator::output_t;
-};
+// Indicates that all elements of a sort chain are needed.
+static constexpr auto no_sort_limit = static_cast<size_t>( -1 );
+
+// Selects the first limit elements of a sort chain in sorted order, using a bounded max-heap
+// of element slots, which takes O(n log k) time and O(k) memory for k = limit.
+// Returns false if the chain has no more than limit elements, in which case all of them
+// have been materialized but not sorted yet.
+template <typename TSortingRange>
+auto select_top_k(
+    const TSortingRange&                 sorting_range,
+    typename TSortingRange::container_t& elements,
+    std::vector<size_t>&                 order,
+    size_t                               limit ) -> bool {
+    using storage_t = typename TSortingRange::storage_t;
+
+    // The source position of each slot, which makes the selection stable.
+    auto positions = std::vector<size_t>();
+    auto position  = static_cast<size_t>( 0 );
+
+    // The heap holds the slots of the best elements so far, with the worst one on top.
+    // One more slot is kept free for the next candidate.
+    auto& heap      = order;
+    auto  free_slot = limit;
+
+    const auto is_before = [&]( size_t a, size_t b ) {
+        const auto result = sorting_range.compare_cached_keys( a, b );
+        return result < 0 || ( result == 0 && positions[a] < positions[b] );
+    };
 
-template <typename TPrevRange, typename TTransform>
-class select_many_range final : public range<
-                                    select_many_range<TPrevRange, TTransform>,
-                                    typename select_many_traits<TPrevRange, TTransform>::output_t> {
-  public:
-    struct iterator {
-        using prev_iter_t = typename TPrevRange::iterator;
+    const auto offer_free_slot = [&] {
+        if ( is_before( free_slot, heap.front() ) ) {
+            std::pop_heap( heap.begin(), heap.end(), is_before );
+            std::swap( heap.back(), free_slot );
+            std::push_heap( heap.begin(), heap.end(), is_before );
+        }
+    };
 
-        using returned_range_t      = typename select_many_traits<TPrevRange, TTransform>::returned_range_t;
-        using returned_range_iter_t = typename returned_range_t::iterator;
-        using output_t              = typename returned_range_iter_t::output_t;
+    sorting_range.for_each_unsorted( [&]( const typename storage_t::element_t& element ) {
+        if ( elements.size() <= limit ) {
+            // Fill phase: collect limit + 1 elements before caching any keys, so that the keys
+            // may refer to the elements without being invalidated by reallocations.
+            elements.push_back( storage_t::store( element ) );
+            positions.push_back( position );
 
-        constexpr iterator( const select_many_range* parent, prev_iter_t pos, prev_iter_t end )
-            : m_parent( parent )
-            , m_pos( std::move( pos ) )
-            , m_end( std::move( end ) ) {
-            if ( m_pos != m_end ) {
-                const auto& transform = m_parent->m_transform;
-                bool        first     = true;
+            if ( elements.size() == limit + 1 ) {
+                sorting_range.reset_keys( limit + 1 );
 
-                do {
-                    if ( !first ) {
-                        ++m_pos;
-                    }
+                for ( size_t i = 0; i <= limit; ++i )
+                    sorting_range.cache_key( i, storage_t::get( elements[i] ) );
 
-                    if ( m_pos == m_end ) {
-                        break;
-                    }
+                heap.resize( limit );
 
-                    m_ret_range = std::invoke( transform, *m_pos );
-                    m_ret_begin = m_ret_range.begin();
-                    m_ret_end   = m_ret_range.end();
+                for ( size_t i = 0; i < limit; ++i )
+                    heap[i] = i;
 
-                    first = false;
-                } while ( m_ret_begin == m_ret_end );
+                std::make_heap( heap.begin(), heap.end(), is_before );
+                offer_free_slot();
             }
         }
-
-        constexpr bool operator==( const iterator& o ) const {
-            return m_pos == o.m_pos;
+        else {
+            elements[free_slot]  = storage_t::store( element );
+            positions[free_slot] = position;
+            sorting_range.cache_key( free_slot, storage_t::get( elements[free_slot] ) );
+            offer_free_slot();
         }
 
-        constexpr bool operator!=( const iterator& o ) const {
-            return m_pos != o.m_pos;
-        }
+        ++position;
+    } );
 
-        constexpr iterator& operator++() {
-            if ( m_ret_begin != m_ret_end ) {
-                // There are values left to be obtained from the returned range.
-                ++m_ret_begin;
-            }
+    if ( elements.size() <= limit )
+        return false;
 
-            if ( m_ret_begin == m_ret_end ) {
-                // Move our parent iterator forward to get the next container.
-                ++m_pos;
+    std::sort( heap.begin(), heap.end(), is_before );
 
-                if ( m_pos != m_end ) {
-                    m_ret_range = m_parent->m_transform( *m_pos );
-                    m_ret_begin = m_ret_range.begin();
-                    m_ret_end   = m_ret_range.end();
-                }
-            }
+    return true;
+}
 
-            return *this;
-        }
+// Sorts the elements of a sort chain (an order_by range followed by any number of then_by ranges).
+// The elements are materialized once, the keys of all levels are cached once, and a permutation
+// of element indices is sorted once, using a fused lexicographic comparator over all levels.
+// If only the first limit elements are needed, a top-k selection is performed instead.
+template <typename TSortingRange>
+void sort_chain(
+    const TSortingRange&                 sorting_range,
+    typename TSortingRange::container_t& elements,
+    std::vector<size_t>&                 order,
+    size_t                               limit ) {
+    using storage_t = typename TSortingRange::storage_t;
 
-        constexpr const output_t& operator*() const {
-            return *m_ret_begin;
-        }
+    elements.clear();
+    order.clear();
 
-        const select_many_range* m_parent;
-        prev_iter_t              m_pos;
-        prev_iter_t              m_end;
+    if ( limit == 0 )
+        return;
 
-        returned_range_t      m_ret_range;
-        returned_range_iter_t m_ret_begin;
-        returned_range_iter_t m_ret_end;
-    };
+    if ( limit == no_sort_limit )
+        sorting_range.materialize( elements );
+    else if ( select_top_k( sorting_range, elements, order, limit ) )
+        return;
 
-    constexpr select_many_range() = default;
+    const auto count = elements.size();
 
-    constexpr select_many_range( const TPrevRange& prev, TTransform transform )
-        : m_prev( prev )
-        , m_transform( std::move( transform ) ) {
-    }
+    sorting_range.reset_keys( count );
 
-    constexpr iterator begin() const {
-        return iterator{ this, m_prev.begin(), m_prev.end() };
-    }
+    for ( size_t i = 0; i < count; ++i )
+        sorting_range.cache_key( i, storage_t::get( elements[i] ) );
 
-    constexpr iterator end() const {
-        const auto prev_end = m_prev.end();
-        return iterator{ this, prev_end, prev_end };
-    }
+    order.resize( count );
 
-  private:
-    TPrevRange m_prev;
-    TTransform m_transform;
-};
+    if constexpr ( TSortingRange::has_radix_keys ) {
+        if ( count >= LINQ_RADIX_SORT_THRESHOLD ) {
+            auto entries = std::vector<radix_entry>( count );
+            auto buffer  = std::vector<radix_entry>();
 
-// ----------------------------------
-// reverse
-// ----------------------------------
+            for ( size_t i = 0; i < count; ++i )
+                entries[i].slot = i;
 
-template <typename TPrevRange>
-class reverse_range final : public range<reverse_range<TPrevRange>, typename TPrevRange::iterator::output_t> {
-  public:
-    using prev_iter_t      = typename TPrevRange::iterator;
-    using object_container = std::vector<prev_iter_t>;
+            sorting_range.radix_sort( entries, buffer );
 
-    struct iterator {
-        using output_t = typename prev_iter_t::output_t;
+            for ( size_t i = 0; i < count; ++i )
+                order[i] = entries[i].slot;
 
-        constexpr iterator( const object_container* prev_iterators, size_t index )
-            : m_prev_iterators( prev_iterators )
-            , m_index( index ) {
+            return;
         }
+    }
 
-        constexpr bool operator==( const iterator& o ) const {
-            return m_index == o.m_index;
-        }
+    for ( size_t i = 0; i < count; ++i )
+        order[i] = i;
 
-        constexpr bool operator!=( const iterator& o ) const {
-            return m_index != o.m_index;
-        }
+    const auto is_before = [&sorting_range]( size_t a, size_t b ) {
+        return sorting_range.compare_cached_keys( a, b ) < 0;
+    };
 
-        constexpr iterator& operator++() {
-            --m_index;
-            return *this;
-        }
+#ifndef LINQ_NO_THREADS
+    if ( count >= LINQ_PARALLEL_SORT_THRESHOLD ) {
+        // Every thread sorts at least half the threshold.
+        const auto min_run_size = std::max<size_t>( LINQ_PARALLEL_SORT_THRESHOLD / 2, 1 );
+        const auto executor     = executor_ref().resolve();
+        const auto thread_count = std::min( executor.concurrency(), count / min_run_size );
 
-        constexpr const output_t& operator*() const {
-            return *( *m_prev_iterators )[m_index];
+        if ( thread_count > 1 ) {
+            parallel_sort_slots( order, is_before, sorting_range.stability(), executor, thread_count );
+            return;
         }
+    }
+#endif
 
-        const object_container* m_prev_iterators;
-        size_t                  m_index{};
-    };
+    if ( sorting_range.stability() == sort_stability::stable )
+        std::stable_sort( order.begin(), order.end(), is_before );
+    else
+        std::sort( order.begin(), order.end(), is_before );
+}
 
-    constexpr reverse_range() = default;
+// Sorting operator; the first level of a sort chain.
+template <typename TPrevRange, typename TKeySelector>
+class order_by_range final
+    : public range<order_by_range<TPrevRange, TKeySelector>, typename TPrevRange::iterator::output_t>,
+      public sorting_range {
+  public:
+    using storage_t           = sort_element_storage<TPrevRange>;
+    using container_element_t = typename storage_t::element_t;
+    using container_t         = std::vector<typename storage_t::stored_t>;
+    using iterator            = sorted_elements_iterator<storage_t>;
 
-    constexpr explicit reverse_range( const TPrevRange& prev )
-        : m_prev( prev ) {
+    order_by_range(
+        const TPrevRange& prev,
+        TKeySelector      key_selector,
+        sort_direction    sort_dir,
+        sort_stability    stability )
+        : m_prev( prev )
+        , m_key_selector( std::move( key_selector ) )
+        , m_sort_direction( sort_dir )
+        , m_stability( stability ) {
     }
 
     constexpr iterator begin() const {
-        m_prev_iterators.clear();
+        sort_chain( *this, m_sorted_values, m_order, m_limit );
+        return iterator( std::addressof( m_sorted_values ), m_order.data() );
+    }
 
-        for ( auto beg = m_prev.begin(), end = m_prev.end(); beg != end; ++beg ) {
-            m_prev_iterators.push_back( beg );
-        }
+    constexpr iterator end() const {
+        return iterator( std::addressof( m_sorted_values ), m_order.data() + m_order.size() );
+    }
 
-        return iterator{ std::addressof( m_prev_iterators ), m_prev_iterators.size() - 1 };
+    // Returns a copy of the range that only produces its first limit elements.
+    constexpr auto with_limit( size_t limit ) const -> order_by_range {
+        auto copy    = *this;
+        copy.m_limit = limit;
+        return copy;
     }
 
-    constexpr iterator end() const {
-        return iterator{ nullptr, static_cast<size_t>( -1 ) };
+    // The stability of the whole sort chain.
+    constexpr auto stability() const -> sort_stability {
+        return m_stability;
     }
 
-    constexpr auto size() const -> size_t {
-        return m_prev.size();
+    // Stores the elements to be sorted, as copies or as pointers into the source.
+    constexpr void materialize( container_t& elements ) const {
+        elements.reserve( m_prev.size_hint().lower );
+
+        for_each_unsorted( [&elements]( const container_element_t& element ) {
+            elements.push_back( storage_t::store( element ) );
+        } );
+    }
+
+    // Invokes a function for each element to be sorted.
+    template <typename TFunc>
+    constexpr void for_each_unsorted( TFunc&& func ) const {
+        for ( const auto& val : m_prev )
+            func( val );
+    }
+
+    constexpr void reset_keys( size_t capacity ) const {
+        m_keys.clear();
+        m_keys.reserve( capacity );
+    }
+
+    // Computes the key of an element and stores it at a slot.
+    constexpr void cache_key( size_t slot, const container_element_t& element ) const {
+        m_keys.store( slot, element, m_key_selector );
+    }
+
+    // Compares the cached keys of two slots.
+    constexpr auto compare_cached_keys( size_t a, size_t b ) const -> int {
+        return compare_sort_keys( m_keys.get( a ), m_keys.get( b ), m_sort_direction );
+    }
+
+    // Stably sorts slots by their cached keys.
+    void radix_sort( std::vector<radix_entry>& entries, std::vector<radix_entry>& buffer ) const {
+        for ( auto& entry : entries )
+            entry.key = to_radix_key( m_keys.get( entry.slot ), m_sort_direction );
+
+        radix_sort_entries( entries, buffer );
+    }
+
+    static constexpr bool has_radix_keys =
+        is_radix_sort_key_v<typename sort_key_cache<container_element_t, TKeySelector>::key_t>;
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint();
     }
 
   private:
-    TPrevRange               m_prev;
-    mutable object_container m_prev_iterators;
+    TPrevRange     m_prev;
+    TKeySelector   m_key_selector;
+    sort_direction m_sort_direction;
+    sort_stability m_stability;
+    size_t         m_limit{ no_sort_limit };
+
+    mutable container_t                                       m_sorted_values;
+    mutable sort_key_cache<container_element_t, TKeySelector> m_keys;
+    mutable std::vector<size_t>                               m_order;
 };
 
 // ----------------------------------
-// take
+// then_by
 // ----------------------------------
 
-template <typename TPrevRange>
-class take_range final : public range<take_range<TPrevRange>, typename TPrevRange::iterator::output_t> {
+// Subsequent level of a sort chain.
+// Enumerating it does not enumerate the previous levels; it sorts once by the keys of all levels.
+template <typename TPrevRange, typename TKeySelector>
+class then_by_range final
+    : public range<then_by_range<TPrevRange, TKeySelector>, typename TPrevRange::iterator::output_t>,
+      public sorting_range {
+    static_assert(
+        std::is_assignable_v<sorting_range, TPrevRange>,
+        "A then_by operation can only be appended to another then_by or order_by operation." );
+
   public:
-    struct iterator {
-        using prev_iter_t = typename TPrevRange::iterator;
-        using output_t    = typename prev_iter_t::output_t;
+    using storage_t           = typename TPrevRange::storage_t;
+    using container_element_t = typename TPrevRange::container_element_t;
+    using container_t         = typename TPrevRange::container_t;
+    using iterator            = sorted_elements_iterator<storage_t>;
 
-        constexpr iterator( prev_iter_t begin, size_t count )
-            : m_begin( begin )
-            , m_count( count ) {
-        }
+    constexpr then_by_range( const TPrevRange& prev, TKeySelector key_selector, const sort_direction sort_dir )
+        : m_prev( prev )
+        , m_key_selector( std::move( key_selector ) )
+        , m_sort_direction( sort_dir ) {
+    }
 
-        constexpr bool operator==( const iterator& o ) const {
-            return m_count == o.m_count || m_begin == o.m_begin;
-        }
+    constexpr auto begin() const -> iterator {
+        sort_chain( *this, m_sorted_values, m_order, m_limit );
+        return iterator( std::addressof( m_sorted_values ), m_order.data() );
+    }
 
-        constexpr bool operator!=( const iterator& o ) const {
-            return m_count != o.m_count && m_begin != o.m_begin;
-        }
+    constexpr auto end() const -> iterator {
+        return iterator( std::addressof( m_sorted_values ), m_order.data() + m_order.size() );
+    }
 
-        constexpr iterator& operator++() {
-            ++m_begin;
-            --m_count;
-            return *this;
-        }
+    constexpr auto with_limit( size_t limit ) const -> then_by_range {
+        auto copy    = *this;
+        copy.m_limit = limit;
+        return copy;
+    }
 
-        constexpr const output_t& operator*() const {
-            return *m_begin;
-        }
+    constexpr auto stability() const -> sort_stability {
+        return m_prev.stability();
+    }
 
-        prev_iter_t m_begin;
-        size_t      m_count{};
-    };
+    constexpr void materialize( container_t& elements ) const {
+        m_prev.materialize( elements );
+    }
 
-    constexpr take_range() = default;
+    template <typename TFunc>
+    constexpr void for_each_unsorted( TFunc&& func ) const {
+        m_prev.for_each_unsorted( std::forward<TFunc>( func ) );
+    }
 
-    constexpr take_range( const TPrevRange& prev, size_t count )
-        : m_prev( prev )
-        , m_count( count ) {
+    constexpr void reset_keys( size_t capacity ) const {
+        m_prev.reset_keys( capacity );
+
+        m_keys.clear();
+        m_keys.reserve( capacity );
     }
 
-    constexpr iterator begin() const {
-        return iterator( m_prev.begin(), m_count );
+    constexpr void cache_key( size_t slot, const container_element_t& element ) const {
+        m_prev.cache_key( slot, element );
+        m_keys.store( slot, element, m_key_selector );
     }
 
-    constexpr iterator end() const {
-        return iterator( m_prev.end(), 0 );
+    constexpr auto compare_cached_keys( size_t a, size_t b ) const -> int {
+        if ( const auto result = m_prev.compare_cached_keys( a, b ); result != 0 )
+            return result;
+
+        return compare_sort_keys( m_keys.get( a ), m_keys.get( b ), m_sort_direction );
     }
 
-    constexpr auto size() const -> size_t {
-        return m_count;
+    // Sorts by this level first, since the previous levels are more significant.
+    void radix_sort( std::vector<radix_entry>& entries, std::vector<radix_entry>& buffer ) const {
+        for ( auto& entry : entries )
+            entry.key = to_radix_key( m_keys.get( entry.slot ), m_sort_direction );
+
+        radix_sort_entries( entries, buffer );
+        m_prev.radix_sort( entries, buffer );
+    }
+
+    static constexpr bool has_radix_keys =
+        TPrevRange::has_radix_keys &&
+        is_radix_sort_key_v<typename sort_key_cache<container_element_t, TKeySelector>::key_t>;
+
+    constexpr auto size_hint() const -> linq::size_hint {
+        return m_prev.size_hint();
     }
 
   private:
-    TPrevRange m_prev;
-    size_t     m_count{};
+    TPrevRange     m_prev;
+    TKeySelector   m_key_selector;
+    sort_direction m_sort_direction;
+    size_t         m_limit{ no_sort_limit };
+
+    mutable container_t                                       m_sorted_values;
+    mutable sort_key_cache<container_element_t, TKeySelector> m_keys;
+    mutable std::vector<size_t>                               m_order;
 };
 
 // ----------------------------------
-// take_while
+// container_range
 // ----------------------------------
 
-template <typename TPrevRange, typename TPredicate>
-class take_while_range final
-    : public range<take_while_range<TPrevRange, TPredicate>, typename TPrevRange::iterator::output_t> {
+template <typename TContainer>
+class container_range final : public range<container_range<TContainer>, typename TContainer::value_type> {
   public:
     struct iterator {
-        using prev_iter_t = typename TPrevRange::iterator;
-        using output_t    = typename prev_iter_t::output_t;
-
-        constexpr iterator( const take_while_range* parent, prev_iter_t begin, prev_iter_t end )
-            : m_parent( parent )
-            , m_begin( begin )
-            , m_end( end ) {
-            const auto& pred = m_parent->m_predicate;
+        using container_iter_t = typename TContainer::const_iterator;
+        using output_t         = typename TContainer::const_reference;
 
-            if ( m_begin != m_end && !std::invoke( pred, *m_begin ) )
-                m_begin = m_end;
+        constexpr iterator() = default;
+
+        constexpr explicit iterator( container_iter_t pos )
+            : m_pos( pos ) {
         }
 
         constexpr bool operator==( const iterator& o ) const {
-            return m_begin == o.m_begin;
+            return m_pos == o.m_pos;
         }
 
         constexpr bool operator!=( const iterator& o ) const {
-            return m_begin != o.m_begin;
+            return m_pos != o.m_pos;
         }
 
         constexpr iterator& operator++() {
-            ++m_begin;
-
-            const auto& pred = m_parent->m_predicate;
+            ++m_pos;
+            return *this;
+        }
 
-            if ( m_begin != m_end && !std::invoke( pred, *m_begin ) )
-                m_begin = m_end;
+        constexpr iterator& operator--()
+            requires requires( container_iter_t pos ) { --pos; }
+        {
+            --m_pos;
+            return *this;
+        }
 
+        constexpr iterator& operator+=( std::ptrdiff_t count )
+            requires std::random_access_iterator<container_iter_t>
+        {
+            m_pos += count;
             return *this;
         }
 
-        constexpr const output_t& operator*() const {
-            return *m_begin;
+        constexpr auto operator-( const iterator& o ) const -> std::ptrdiff_t
+            requires std::random_access_iterator<container_iter_t>
+        {
+            return m_pos - o.m_pos;
         }
 
-        const take_while_range* m_parent;
-        prev_iter_t             m_begin;
-        prev_iter_t             m_end;
+        constexpr output_t operator*() const {
+            return *m_pos;
+        }
+
+        container_iter_t m_pos{};
     };
 
-    constexpr take_while_range() = default;
+    constexpr container_range() = default;
 
-    constexpr take_while_range( const TPrevRange& prev, TPredicate predicate )
-        : m_prev( prev )
-        , m_predicate( std::move( predicate ) ) {
+    constexpr explicit container_range( const TContainer* container )
+        : m_container( container ) {
+        LINQ_ASSERT( container != nullptr && "null container given to range" );
     }
 
-    constexpr iterator begin() const {
-        return iterator( this, m_prev.begin(), m_prev.end() );
+    constexpr auto begin() const -> iterator {
+        return iterator( m_container->cbegin() );
     }
 
-    constexpr iterator end() const {
-        return iterator( this, m_prev.end(), m_prev.end() );
+    constexpr auto end() const -> iterator {
+        return iterator( m_container->cend() );
+    }
+
+    constexpr auto size() const -> size_t {
+        return m_container->size();
+    }
+
+    constexpr auto data() const -> const typename TContainer::value_type*
+        requires std::contiguous_iterator<typename TContainer::const_iterator>
+    {
+        return std::to_address( m_container->cbegin() );
     }
 
+#ifndef LINQ_NO_STL_CONTAINERS
+    template <typename TSink>
+    auto push_batches( TSink&& sink, size_t batch_size ) const -> bool {
+        if constexpr ( std::contiguous_iterator<typename TContainer::const_iterator> ) {
+            // Batches point directly into the container.
+            return push_contiguous_batches( data(), size(), sink, batch_size );
+        }
+        else {
+            return range<container_range, typename TContainer::value_type>::push_batches( sink, batch_size );
+        }
+    }
+#endif
+
   private:
-    TPrevRange m_prev;
-    TPredicate m_predicate;
+    const TContainer* m_container{};
 };
 
 // ----------------------------------
-// skip
+// mutable_container_range
 // ----------------------------------
 
-template <typename TPrevRange>
-class skip_range final : public range<skip_range<TPrevRange>, typename TPrevRange::iterator::output_t> {
+template <typename TContainer>
+class mutable_container_range final
+    : public range<mutable_container_range<TContainer>, typename TContainer::value_type> {
   public:
     struct iterator {
-        using prev_iter_t = typename TPrevRange::iterator;
-        using output_t    = typename prev_iter_t::output_t;
+        using container_iter_t = typename TContainer::iterator;
+        using output_t         = typename TContainer::reference;
 
-        constexpr iterator( prev_iter_t begin, prev_iter_t end, size_t count )
-            : m_begin( begin ) {
-            while ( m_begin != end && count > 0 ) {
-                ++m_begin;
-                --count;
-            }
+        constexpr explicit iterator( container_iter_t pos )
+            : m_pos( pos ) {
         }
 
-        constexpr bool operator==( const iterator& o ) const {
-            return m_begin == o.m_begin;
+        constexpr auto operator==( const iterator& o ) const -> bool {
+            return m_pos == o.m_pos;
         }
 
-        constexpr bool operator!=( const iterator& o ) const {
-            return m_begin != o.m_begin;
+        constexpr auto operator!=( const iterator& o ) const -> bool {
+            return m_pos != o.m_pos;
         }
 
-        constexpr iterator& operator++() {
-            ++m_begin;
+        constexpr auto operator++() -> iterator& {
+            ++m_pos;
             return *this;
         }
 
-        constexpr const output_t& operator*() const {
-            return *m_begin;
+        constexpr auto operator--() -> iterator&
+            requires requires( container_iter_t pos ) { --pos; }
+        {
+            --m_pos;
+            return *this;
         }
 
-        prev_iter_t m_begin;
+        constexpr auto operator+=( std::ptrdiff_t count ) -> iterator&
+            requires std::random_access_iterator<container_iter_t>
+        {
+            m_pos += count;
+            return *this;
+        }
+
+        constexpr auto operator-( const iterator& o ) const -> std::ptrdiff_t
+            requires std::random_access_iterator<container_iter_t>
+        {
+            return m_pos - o.m_pos;
+        }
+
+        constexpr auto operator*() const -> output_t& {
+            return *m_pos;
+        }
+
+        container_iter_t m_pos;
     };
 
-    constexpr skip_range( const TPrevRange& prev, size_t count )
-        : m_prev( prev )
-        , m_count( count ) {
+    constexpr explicit mutable_container_range( TContainer* container )
+        : m_container( container ) {
+        LINQ_ASSERT( container != nullptr && "null container given to range" );
     }
 
-    constexpr iterator begin() const {
-        return iterator( m_prev.begin(), m_prev.end(), m_count );
+    constexpr auto begin() const -> iterator {
+        return iterator( m_container->begin() );
     }
 
-    constexpr iterator end() const {
-        const auto prev_end = m_prev.end();
-        return iterator( prev_end, prev_end, 0 );
+    constexpr auto end() const -> iterator {
+        return iterator( m_container->end() );
+    }
+
+    constexpr auto size() const -> size_t {
+        return m_container->size();
+    }
+
+    constexpr auto data() const -> const typename TContainer::value_type*
+        requires std::contiguous_iterator<typename TContainer::const_iterator>
+    {
+        return std::to_address( m_container->cbegin() );
+    }
+
+#ifndef LINQ_NO_STL_CONTAINERS
+    template <typename TSink>
+    auto push_batches( TSink&& sink, size_t batch_size ) const -> bool {
+        if constexpr ( std::contiguous_iterator<typename TContainer::const_iterator> ) {
+            return push_contiguous_batches( data(), size(), sink, batch_size );
+        }
+        else {
+            return range<mutable_container_range, typename TContainer::value_type>::push_batches( sink, batch_size );
+        }
     }
+#endif
 
   private:
-    TPrevRange m_prev;
-    size_t     m_count{};
+    TContainer* m_container{};
 };
 
 // ----------------------------------
-// skip_while
+// container_copy_range
 // ----------------------------------
 
-template <typename TPrevRange, typename TPredicate>
-class skip_while_range final
-    : public range<skip_while_range<TPrevRange, TPredicate>, typename TPrevRange::iterator::output_t> {
+template <typename TContainer>
+class container_copy_range final : public range<container_copy_range<TContainer>, typename TContainer::value_type> {
   public:
     struct iterator {
-        using prev_iter_t = typename TPrevRange::iterator;
-        using output_t    = typename prev_iter_t::output_t;
+        using container_iter_t = typename TContainer::iterator;
+        using output_t         = typename TContainer::reference;
 
-        constexpr iterator( prev_iter_t begin, prev_iter_t end, const TPredicate& predicate )
-            : m_begin( begin ) {
-            while ( m_begin != end && std::invoke( predicate, *m_begin ) ) {
-                ++m_begin;
-            }
+        constexpr explicit iterator( container_iter_t pos )
+            : m_pos( pos ) {
         }
 
-        constexpr bool operator==( const iterator& o ) const {
-            return m_begin == o.m_begin;
+        constexpr auto operator==( const iterator& o ) const -> bool {
+            return m_pos == o.m_pos;
         }
 
-        constexpr bool operator!=( const iterator& o ) const {
-            return m_begin != o.m_begin;
+        constexpr auto operator!=( const iterator& o ) const -> bool {
+            return m_pos != o.m_pos;
         }
 
-        constexpr iterator& operator++() {
-            ++m_begin;
+        constexpr auto operator++() -> iterator& {
+            ++m_pos;
             return *this;
         }
 
-        constexpr const output_t& operator*() const {
-            return *m_begin;
+        constexpr auto operator*() const -> output_t& {
+            return *m_pos;
         }
 
-        prev_iter_t m_begin;
+        container_iter_t m_pos;
     };
 
-    constexpr skip_while_range( const TPrevRange& prev, const TPredicate& predicate )
-        : m_prev( prev )
-        , m_predicate( &predicate ) {
+    constexpr explicit container_copy_range( const TContainer& container )
+        : m_container( container ) {
     }
 
     constexpr iterator begin() const {
-        return iterator( m_prev.begin(), m_prev.end(), *m_predicate );
+        return iterator{ m_container.begin() };
     }
 
     constexpr iterator end() const {
-        const auto prev_end = m_prev.end();
-        return iterator( prev_end, prev_end, *m_predicate );
+        return iterator{ m_container.end() };
+    }
+
+    constexpr auto size() const {
+        return m_container->size();
     }
 
   private:
-    TPrevRange        m_prev;
-    const TPredicate* m_predicate{};
+    TContainer m_container{};
 };
 
 // ----------------------------------
-// append
+// from_initializer_list
 // ----------------------------------
 
-template <typename TPrevRange, typename TOtherRange>
-class append_range final
-    : public range<append_range<TPrevRange, TOtherRange>, typename TPrevRange::iterator::output_t> {
+template <typename T, typename TContainer = std::vector<T>>
+class initializer_list_range final : public range<initializer_list_range<T>, typename TContainer::const_iterator> {
   public:
-    using other_range_iter_t = typename TOtherRange::iterator;
-
     struct iterator {
-        using prev_iter_t = typename TPrevRange::iterator;
-        using output_t    = typename prev_iter_t::output_t;
+        using container_iter_t = typename TContainer::const_iterator;
+        using output_t         = typename TContainer::const_reference;
 
-        constexpr iterator(
-            prev_iter_t        begin,
-            prev_iter_t        end,
-            other_range_iter_t other_begin,
-            other_range_iter_t other_end )
-            : m_my_begin( begin )
-            , m_my_end( end )
-            , m_other_begin( other_begin )
-            , m_other_end( other_end ) {
+        constexpr explicit iterator( container_iter_t pos )
+            : m_pos( pos ) {
         }
 
         constexpr bool operator==( const iterator& o ) const {
-            return m_other_begin == o.m_other_begin;
+            return m_pos == o.m_pos;
         }
 
         constexpr bool operator!=( const iterator& o ) const {
-            return m_other_begin != o.m_other_begin;
+            return m_pos != o.m_pos;
         }
 
         constexpr iterator& operator++() {
-            if ( m_my_begin != m_my_end )
-                ++m_my_begin;
-            else
-                ++m_other_begin;
-
+            ++m_pos;
             return *this;
         }
 
         constexpr const output_t& operator*() const {
-            return m_my_begin != m_my_end ? *m_my_begin : *m_other_begin;
+            return *m_pos;
         }
 
-        prev_iter_t        m_my_begin;
-        prev_iter_t        m_my_end;
-        other_range_iter_t m_other_begin;
-        other_range_iter_t m_other_end;
+        container_iter_t m_pos;
     };
 
-    constexpr append_range( const TPrevRange& prev, const TOtherRange& other_range )
-        : m_prev( prev )
-        , m_other_range( other_range ) {
+    constexpr explicit initializer_list_range( std::initializer_list<T> list ) // NOLINT(*-explicit-constructor)
+        : m_list( list.begin(), list.end() ) {
     }
 
     constexpr iterator begin() const {
-        return iterator( m_prev.begin(), m_prev.end(), m_other_range.begin(), m_other_range.end() );
+        return iterator( m_list.begin() );
     }
 
     constexpr iterator end() const {
-        const auto prev_end  = m_prev.end();
-        const auto other_end = m_other_range.end();
-        return iterator( prev_end, prev_end, other_end, other_end );
+        return iterator( m_list.end() );
+    }
+
+    constexpr auto size() const -> size_t {
+        return m_list.size();
     }
 
   private:
-    TPrevRange  m_prev;
-    TOtherRange m_other_range;
+    std::vector<T> m_list{};
 };
 
 // ----------------------------------
-// repeat
+// from_to_range
 // ----------------------------------
 
-template <typename TPrevRange>
-class repeat_range final : public range<repeat_range<TPrevRange>, typename TPrevRange::iterator::output_t> {
+template <typename T>
+class from_to_range final : public range<from_to_range<T>, T> {
   public:
     struct iterator {
-        using prev_iter_t = typename TPrevRange::iterator;
-        using output_t    = typename prev_iter_t::output_t;
+        using output_t = T;
 
-        constexpr iterator( TPrevRange* prev_range_ptr, prev_iter_t begin, prev_iter_t end, size_t count )
-            : m_prev_range_ptr( prev_range_ptr )
-            , m_pos( begin )
-            , m_end( end )
-            , m_count( count ) {
+        constexpr iterator( output_t value, const output_t* step )
+            : m_value( std::move( value ) )
+            , m_step( step ) {
         }
 
         constexpr bool operator==( const iterator& o ) const {
-            return m_pos == o.m_pos;
+            return o.m_value < m_value;
         }
 
         constexpr bool operator!=( const iterator& o ) const {
-            return m_pos != o.m_pos;
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "Simplify"
+#endif
+            return !( *this == o );
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
         }
 
         constexpr iterator& operator++() {
-            ++m_pos;
-
-            if ( m_pos == m_end && m_count > 0 ) {
-                m_pos = m_prev_range_ptr->begin();
-                --m_count;
-            }
-
+            m_value += *m_step;
             return *this;
         }
 
         constexpr const output_t& operator*() const {
-            return *m_pos;
+            return m_value;
         }
 
-        TPrevRange* m_prev_range_ptr{};
-        prev_iter_t m_pos{};
-        prev_iter_t m_end{};
-        size_t      m_count{};
+        output_t        m_value;
+        const output_t* m_step;
     };
 
-    constexpr repeat_range( const TPrevRange& prev, size_t count )
-        : m_prev( prev )
-        , m_count( count ) {
+    constexpr from_to_range( T&& start, T&& end, T&& step )
+        : m_start( std::forward<T>( start ) )
+        , m_end( std::forward<T>( end ) )
+        , m_step( std::forward<T>( step ) ) {
+        LINQ_ASSERT( !( m_end < m_start ) );
     }
 
     constexpr iterator begin() const {
-        return iterator( &m_prev, m_prev.begin(), m_prev.end(), m_count );
+        return iterator( m_start, std::addressof( m_step ) );
     }
 
     constexpr iterator end() const {
-        const auto prev_end = m_prev.end();
-        return iterator( &m_prev, prev_end, prev_end, 0 );
+        return iterator( m_end, std::addressof( m_step ) );
+    }
+
+    constexpr auto size() const -> size_t
+#ifdef __cpp_lib_concepts
+        requires( std::integral<T> )
+#endif
+    {
+#ifndef __cpp_lib_concepts
+        static_assert( std::is_integral_v<T>, "from_to ranges only support .size() for integral elements" );
+#endif
+
+        return static_cast<size_t>( ( ( m_end - m_start ) / m_step ) + 1 );
+    }
+
+    /// Gets the elements [first, first + count) of the range as a new range, in constant time.
+    constexpr auto slice( size_t first, size_t count ) const -> from_to_range
+#ifdef __cpp_lib_concepts
+        requires( std::integral<T> )
+#endif
+    {
+        LINQ_ASSERT( count > 0 && first + count <= size() );
+
+        return from_to_range(
+            static_cast<T>( m_start + static_cast<T>( first ) * m_step ),
+            static_cast<T>( m_start + static_cast<T>( first + count - 1 ) * m_step ),
+            T( m_step ) );
     }
 
   private:
-    mutable TPrevRange m_prev;
-    size_t             m_count;
+    T m_start;
+    T m_end;
+    T m_step;
 };
 
 // ----------------------------------
-// join
+// generate_range
 // ----------------------------------
 
-// Determines the output of a selection in the join range.
-template <typename TRangeA, typename TRangeB, typename TTransform>
-using join_output_t =
-    std::invoke_result_t<TTransform, typename TRangeA::iterator::output_t, typename TRangeB::iterator::output_t>;
+struct generator_return_value_ident {
+    /* Nothing to define here. */
+};
 
-// Nested loop inner join operator.
-template <
-    typename TPrevRange,
-    typename TOtherRange,
-    typename TKeySelectorA,
-    typename TKeySelectorB,
-    typename TTransform>
-class join_range final : public range<
-                             join_range<TPrevRange, TOtherRange, TKeySelectorA, TKeySelectorB, TTransform>,
-                             join_output_t<TPrevRange, TOtherRange, TTransform>> {
-    using other_range_iter_t = typename TOtherRange::iterator;
+template <typename T>
+struct generator_return_value final : generator_return_value_ident {
+    using value_type = T;
+
+    constexpr generator_return_value() = default;
+
+    constexpr explicit generator_return_value( T value )
+        : m_value( std::move( value ) )
+        , m_is_empty( false ) {
+    }
+
+    constexpr bool operator==( const generator_return_value& o ) const {
+        // We only care about whether two generator_return_values are empty or not.
+        // If the iterator has an empty one, it will match the one from the last
+        // iterator, which indicates the end of iteration.
+        return m_is_empty == o.m_is_empty;
+    }
+
+    constexpr bool operator!=( const generator_return_value& o ) const {
+        // Same as in operator==.
+        return m_is_empty != o.m_is_empty;
+    }
+
+    T    m_value{};
+    bool m_is_empty{ true };
+};
+
+template <typename TGenerator>
+struct generate_range_traits final {
+    using generator_return_type = std::invoke_result_t<TGenerator, size_t>;
+
+    // Ensure that whatever the generator returned is indeed of type generator_return_type.
+    static_assert(
+        std::is_base_of_v<generator_return_value_ident, generator_return_type>,
+        "The generator function is expected to return a result of linq::generate_return() or "
+        "linq::generate_finish()." );
+
+    // The type that is wrapped by the returned generator_return_type.
+    using value_type = typename generator_return_type::value_type;
+};
 
+template <typename TGenerator>
+class generator_range final
+    : public range<generator_range<TGenerator>, typename generate_range_traits<TGenerator>::value_type> {
   public:
     struct iterator {
-        using prev_iter_t = typename TPrevRange::iterator;
-        using output_t    = join_output_t<TPrevRange, TOtherRange, TTransform>;
+        using generator_return_type = typename generate_range_traits<TGenerator>::generator_return_type;
+        using output_t              = typename generate_range_traits<TGenerator>::value_type;
 
-        constexpr iterator( prev_iter_t begin, prev_iter_t end, const join_range* parent )
-            : m_begin( begin )
-            , m_end( end )
-            , m_pos( begin )
-            , m_other_begin( parent->m_other_range.begin() )
-            , m_other_end( parent->m_other_range.end() )
-            , m_other_pos( parent->m_other_range.begin() )
-            , m_parent( parent ) {
-            // Find the first match without pre-incrementing the
-            // other position, so that we start at the beginning.
-            find_next( false );
+        constexpr iterator( const generator_range* parent, bool is_end )
+            : m_parent( parent ) {
+            if ( is_end ) {
+                m_last_result = generator_return_type();
+            }
+            else {
+                // First iteration
+                m_last_result = m_parent->m_generator( m_iteration );
+            }
         }
 
         constexpr bool operator==( const iterator& o ) const {
-            return m_pos == o.m_pos;
+            return m_last_result == o.m_last_result;
         }
 
         constexpr bool operator!=( const iterator& o ) const {
-            return m_pos != o.m_pos;
+            return m_last_result != o.m_last_result;
         }
 
         constexpr iterator& operator++() {
-            // Find the next match, but pre-increment the other
-            // position, so that we can move forward.
-            find_next( true );
+            ++m_iteration;
+            m_last_result = m_parent->m_generator( m_iteration );
             return *this;
         }
 
-        constexpr output_t operator*() const {
-            return m_parent->m_transform( *m_pos, *m_other_pos );
+        constexpr const output_t& operator*() const {
+            return m_last_result.m_value;
         }
 
-        prev_iter_t m_begin;
-        prev_iter_t m_end;
-        prev_iter_t m_pos;
+        const generator_range* m_parent;
+        size_t                 m_iteration{};
+        generator_return_type  m_last_result;
+    };
 
-        other_range_iter_t m_other_begin;
-        other_range_iter_t m_other_end;
-        other_range_iter_t m_other_pos;
+    constexpr explicit generator_range( TGenerator generator )
+        : m_generator( std::move( generator ) ) {
+    }
 
-        const join_range* m_parent;
+    constexpr iterator begin() const {
+        return iterator( this, false );
+    }
 
-      private:
-        // Finds the next match in both ranges using the key selectors and == comparison.
-        constexpr void find_next( bool pre_increment_other ) {
-            const auto& key_selector_a = m_parent->m_key_selector_a;
-            const auto& key_selector_b = m_parent->m_key_selector_b;
+    constexpr iterator end() const {
+        return iterator( this, true );
+    }
 
-            if ( pre_increment_other ) {
-                ++m_other_pos;
-            }
+  private:
+    TGenerator m_generator;
+};
 
-            while ( m_pos != m_end ) {
-                bool       should_continue = true;
-                const auto key_a           = key_selector_a( *m_pos );
+#ifndef LINQ_NO_STL_CONTAINERS
 
-                while ( m_other_pos != m_other_end ) {
-                    const auto key_b = key_selector_b( *m_other_pos );
+// ----------------------------------
+// cache
+// ----------------------------------
 
-                    if ( key_a == key_b ) {
-                        should_continue = false;
-                        break;
-                    }
+template <typename TPrevRange>
+class cache_range final
+    : public range<
+          cache_range<TPrevRange>,
+          std::remove_cv_t<std::remove_reference_t<typename TPrevRange::iterator::output_t>>> {
+  public:
+    using element_t   = std::remove_cv_t<std::remove_reference_t<typename TPrevRange::iterator::output_t>>;
+    using container_t = std::vector<element_t>;
+    using iterator    = typename container_range<container_t>::iterator;
 
-                    ++m_other_pos;
-                }
+    explicit cache_range( const TPrevRange& prev )
+        : m_prev( prev )
+        , m_cache( std::make_shared<cache_state>() ) {
+    }
 
-                // Start over in the other range if it's finished.
-                if ( m_other_pos == m_other_end )
-                    m_other_pos = m_other_begin;
+    auto begin() const -> iterator {
+        return iterator( elements().cbegin() );
+    }
 
-                if ( !should_continue ) {
-                    break;
-                }
+    auto end() const -> iterator {
+        return iterator( elements().cend() );
+    }
 
-                ++m_pos;
-            }
-        }
-    };
+    auto size() const -> size_t {
+        return elements().size();
+    }
 
-    constexpr join_range(
-        const TPrevRange& prev,
-        TOtherRange       other_range,
-        TKeySelectorA     key_selector_a,
-        TKeySelectorB     key_selector_b,
-        TTransform        transform )
-        : m_prev( prev )
-        , m_other_range( other_range )
-        , m_key_selector_a( std::move( key_selector_a ) )
-        , m_key_selector_b( std::move( key_selector_b ) )
-        , m_transform( std::move( transform ) ) {
+    auto data() const -> const element_t*
+        requires std::contiguous_iterator<typename container_t::const_iterator>
+    {
+        return elements().data();
+    }
+
+    auto size_hint() const -> linq::size_hint {
+        if ( m_cache->is_filled )
+            return linq::size_hint::exact( m_cache->elements.size() );
+
+        return m_prev.size_hint();
+    }
+
+    template <typename TSink>
+    auto push_batches( TSink&& sink, size_t batch_size ) const -> bool {
+        if constexpr ( std::contiguous_iterator<typename container_t::const_iterator> ) {
+            return push_contiguous_batches( data(), size(), sink, batch_size );
+        }
+        else {
+            return range<cache_range, element_t>::push_batches( sink, batch_size );
+        }
     }
 
-    constexpr iterator begin() const {
-        return iterator( m_prev.begin(), m_prev.end(), this );
+    // Discards the cached elements, so that the next use enumerates the previous range again.
+    void invalidate() const {
+        m_cache->elements.clear();
+        m_cache->is_filled = false;
     }
 
-    constexpr iterator end() const {
-        const auto prev_end = m_prev.end();
-        return iterator( prev_end, prev_end, this );
+  private:
+    // Shared by all copies of the range, including the copies that subsequent operators store.
+    struct cache_state {
+        container_t elements;
+        bool        is_filled{};
+    };
+
+    // Gets the cached elements, enumerating the previous range on first use.
+    auto elements() const -> const container_t& {
+        auto& state = *m_cache;
+
+        if ( !state.is_filled ) {
+            state.elements.clear();
+
+            state.elements.reserve( m_prev.size_hint().lower );
+
+            m_prev.for_each( [&state]( auto&& element ) {
+                state.elements.emplace_back( std::forward<decltype( element )>( element ) );
+            } );
+
+            state.is_filled = true;
+        }
+
+        return state.elements;
     }
 
-  private:
-    TPrevRange    m_prev;
-    TOtherRange   m_other_range;
-    TKeySelectorA m_key_selector_a;
-    TKeySelectorB m_key_selector_b;
-    TTransform    m_transform;
+    TPrevRange                   m_prev;
+    std::shared_ptr<cache_state> m_cache;
 };
 
 // ----------------------------------
-// order_by
+// parallel
 // ----------------------------------
 
-template <typename TPrevRange, typename TKeySelector>
-class order_by_range final
-    : public range<order_by_range<TPrevRange, TKeySelector>, typename TPrevRange::iterator::output_t>,
-      public sorting_range {
-  public:
-    using container_element_t = std::decay_t<typename TPrevRange::iterator::output_t>;
-    using container_t         = std::vector<container_element_t>;
-    using container_iter_t    = typename container_t::const_iterator;
-
-    struct iterator {
-        using output_t = typename container_iter_t::reference;
+// Gets the elements [first, first + count) of a range, which is constant time for ranges with random access.
+template <typename TRange>
+constexpr auto partition_of( const TRange& range, size_t first, size_t count ) {
+    return range.skip( first ).take( count );
+}
 
-        constexpr explicit iterator( container_iter_t pos )
-            : m_pos( pos ) {
-        }
+template <typename T>
+constexpr auto partition_of( const from_to_range<T>& range, size_t first, size_t count ) {
+    return range.slice( first, count );
+}
 
-        constexpr bool operator==( const iterator& o ) const {
-            return m_pos == o.m_pos;
-        }
+// The query of a parallel range to which no operator was applied yet: the partition itself.
+struct partition_query {
+    template <typename TPartition>
+    constexpr auto operator()( const TPartition& partition ) const -> TPartition {
+        return partition;
+    }
+};
 
-        constexpr bool operator!=( const iterator& o ) const {
-            return m_pos != o.m_pos;
-        }
+// The number of chunks per thread, so that threads that finish early can take over work.
+static constexpr size_t parallel_chunks_per_thread = 4;
 
-        constexpr iterator& operator++() {
-            ++m_pos;
-            return *this;
-        }
+// The size of the chunks of ordered parallel ranges, which does not depend on the number of threads,
+// so that their results are the same for any number of threads.
+static constexpr size_t parallel_ordered_chunk_size =
+    std::max<size_t>( LINQ_PARALLEL_THRESHOLD / parallel_chunks_per_thread, 1 );
 
-        constexpr output_t operator*() const {
-            return *m_pos;
-        }
+// Combines partial results pairwise in a balanced tree whose shape only depends on their number,
+// so that the result is reproducible for operations that are associative but not exactly so
+// (such as floating-point addition).
+template <typename T, typename TCombineFunc>
+auto combine_in_tree( std::vector<T>& partials, const TCombineFunc& combine ) -> T {
+    LINQ_ASSERT( !partials.empty() );
 
-        container_iter_t m_pos;
-    };
+    for ( auto count = partials.size(); count > 1; count = ( count + 1 ) / 2 ) {
+        for ( size_t i = 0; i < count / 2; ++i )
+            partials[i] = combine( std::move( partials[2 * i] ), std::move( partials[2 * i + 1] ) );
 
-    order_by_range( const TPrevRange& prev, TKeySelector key_selector, sort_direction sort_dir )
-        : m_prev( prev )
-        , m_key_selector( std::move( key_selector ) )
-        , m_sort_direction( sort_dir ) {
+        if ( count % 2 == 1 )
+            partials[count / 2] = std::move( partials[count - 1] );
     }
 
-    constexpr iterator begin() const {
-        m_sorted_values.clear();
+    return std::move( partials.front() );
+}
 
-        for ( const auto& val : m_prev )
-            m_sorted_values.push_back( val );
+// Determines how many threads of an executor a parallel range uses for a source of the given size.
+inline auto parallel_thread_count( const executor_ref& executor, size_t size ) -> size_t {
+    const auto elements_per_thread = std::max<size_t>( LINQ_PARALLEL_THRESHOLD, 1 );
+    return std::clamp( size / elements_per_thread, size_t( 1 ), std::max<size_t>( executor.concurrency(), 1 ) );
+}
 
-        std::stable_sort(
-            m_sorted_values.begin(),
-            m_sorted_values.end(),
-            [this]( const container_element_t& a, const container_element_t& b ) {
-                return compare_keys( a, b );
-            } );
+// Maps a hash to one of 2^shard_bits shards by its highest bits after Fibonacci hashing, which
+// keeps the shards balanced for poorly distributed hashes such as the identity hash of integers.
+inline auto shard_of_hash( size_t hash, unsigned shard_bits ) -> size_t {
+    if ( shard_bits == 0 )
+        return 0;
 
-        return iterator( m_sorted_values.begin() );
-    }
+    return static_cast<size_t>( ( static_cast<uint64_t>( hash ) * 0x9E3779B97F4A7C15ull ) >> ( 64 - shard_bits ) );
+}
 
-    constexpr iterator end() const {
-        return iterator( m_sorted_values.end() );
-    }
+// Determines the number of bits of a shard index, so that there are enough shards for threads
+// that finish early to take over work.
+inline auto shard_bits_for( size_t thread_count ) -> unsigned {
+    auto shard_bits = 0u;
+
+    while ( ( size_t( 1 ) << shard_bits ) < thread_count * parallel_chunks_per_thread )
+        ++shard_bits;
 
-    constexpr bool compare_keys( const container_element_t& a, const container_element_t& b ) const {
-        const auto a_val = m_key_selector( a );
-        const auto b_val = m_key_selector( b );
+    return shard_bits;
+}
 
-        return m_sort_direction == sort_direction::ascending ? /*ascending:*/ a_val < b_val
-                                                             : /*descending:*/ b_val < a_val;
+// Hashes the keys of a single shard for a flat_hash_index. All keys of a shard share the highest bits
+// after Fibonacci hashing, which flat_hash_index uses to find their slots, so these bits are shifted out.
+template <typename TKey>
+struct shard_key_hash {
+    auto operator()( const TKey& key ) const -> size_t {
+        const auto hash = static_cast<uint64_t>( std::hash<TKey>()( key ) );
+        return static_cast<size_t>( ( hash * 0x9E3779B97F4A7C15ull ) << shard_bits );
     }
 
-  private:
-    TPrevRange          m_prev;
-    TKeySelector        m_key_selector;
-    sort_direction      m_sort_direction;
-    mutable container_t m_sorted_values;
+    unsigned shard_bits;
 };
+} // namespace details
 
-// ----------------------------------
-// then_by
-// ----------------------------------
-
-template <typename TPrevRange, typename TKeySelector>
-class then_by_range final
-    : public range<then_by_range<TPrevRange, TKeySelector>, typename TPrevRange::iterator::output_t>,
-      public sorting_range {
-    static_assert(
-        std::is_assignable_v<sorting_range, TPrevRange>,
-        "A then_by operation can only be appended to another then_by or order_by operation." );
-
+/// @brief A hash map that is split into several std::unordered_maps (shards) by the hash of its keys.
+/// Every key is stored in exactly one shard, so that the shards can be built concurrently without locks.
+template <typename TKey, typename TValue>
+class sharded_map final {
   public:
-    using container_element_t = std::decay_t<typename TPrevRange::iterator::output_t>;
-    using container_t         = std::vector<container_element_t>;
-    using container_iter_t    = typename container_t::const_iterator;
-
-    struct iterator {
-        using output_t = typename container_iter_t::reference;
+    using map_t = std::unordered_map<TKey, TValue>;
 
-        constexpr explicit iterator( container_iter_t pos )
-            : m_pos( pos ) {
-        }
+    sharded_map( std::vector<map_t> shards, unsigned shard_bits )
+        : m_shards( std::move( shards ) )
+        , m_shard_bits( shard_bits ) {
+        LINQ_ASSERT( m_shards.size() == size_t( 1 ) << shard_bits );
+    }
 
-        constexpr auto operator==( const iterator& o ) const -> bool {
-            return m_pos == o.m_pos;
-        }
+    // Creates a sharded map of a single shard.
+    explicit sharded_map( map_t map ) {
+        m_shards.push_back( std::move( map ) );
+    }
 
-        constexpr auto operator!=( const iterator& o ) const -> bool {
-            return m_pos != o.m_pos;
-        }
+    /// Gets the index of the shard that stores a key.
+    [[nodiscard]]
+    auto shard_of( const TKey& key ) const -> size_t {
+        return details::shard_of_hash( std::hash<TKey>()( key ), m_shard_bits );
+    }
 
-        constexpr auto operator++() -> iterator& {
-            ++m_pos;
-            return *this;
-        }
+    [[nodiscard]]
+    auto shards() const -> const std::vector<map_t>& {
+        return m_shards;
+    }
 
-        constexpr auto operator*() const -> output_t {
-            return *m_pos;
-        }
+    /// Gets the number of keys.
+    [[nodiscard]]
+    auto size() const -> size_t {
+        auto size = size_t( 0 );
 
-        container_iter_t m_pos;
-    };
+        for ( const auto& shard : m_shards )
+            size += shard.size();
 
-    constexpr then_by_range( const TPrevRange& prev, TKeySelector key_selector, const sort_direction sort_dir )
-        : m_prev( prev )
-        , m_key_selector( std::move( key_selector ) )
-        , m_sort_direction( sort_dir ) {
+        return size;
     }
 
-    constexpr auto begin() const -> iterator {
-        m_sorted_values.clear();
+    [[nodiscard]]
+    auto empty() const -> bool {
+        return size() == 0;
+    }
 
-        for ( const auto& val : m_prev )
-            m_sorted_values.emplace_back( val );
+    [[nodiscard]]
+    auto contains( const TKey& key ) const -> bool {
+        return find( key ) != nullptr;
+    }
 
-        std::stable_sort(
-            m_sorted_values.begin(),
-            m_sorted_values.end(),
-            [this]( const container_element_t& a, const container_element_t& b ) {
-                return this->compare_keys( a, b );
-            } );
+    /// Gets the value of a key, or null if the map does not contain the key.
+    [[nodiscard]]
+    auto find( const TKey& key ) const -> const TValue* {
+        const auto& shard = m_shards[shard_of( key )];
+        const auto  it    = shard.find( key );
 
-        return iterator( m_sorted_values.begin() );
+        return it != shard.end() ? std::addressof( it->second ) : nullptr;
     }
 
-    constexpr auto end() const -> iterator {
-        return iterator( m_sorted_values.end() );
+    /// Gets the value of a key, and throws std::out_of_range if the map does not contain the key.
+    [[nodiscard]]
+    auto at( const TKey& key ) const -> const TValue& {
+        return m_shards[shard_of( key )].at( key );
     }
 
-    constexpr auto compare_keys( const container_element_t& a, const container_element_t& b ) const -> bool {
-        if ( m_prev.compare_keys( a, b ) )
-            return true;
+    /// Merges the shards into a single std::unordered_map, by moving their nodes.
+    [[nodiscard]]
+    auto to_unordered_map() && -> map_t {
+        if ( m_shards.size() == 1 )
+            return std::move( m_shards.front() );
 
-        if ( m_prev.compare_keys( b, a ) )
-            return false;
+        auto map = map_t();
+        map.reserve( size() );
 
-        const auto a_value = m_key_selector( a );
-        const auto b_value = m_key_selector( b );
+        for ( auto& shard : m_shards )
+            map.merge( shard );
 
-        LINQ_ASSERT(
-            ( m_sort_direction == sort_direction::ascending || m_sort_direction == sort_direction::descending ) &&
-            "invalid sort direction" );
+        return map;
+    }
 
-        return m_sort_direction == sort_direction::ascending ? a_value < b_value : b_value < a_value;
+    /// Merges copies of the shards into a single std::unordered_map.
+    [[nodiscard]]
+    auto to_unordered_map() const& -> map_t {
+        return sharded_map( *this ).to_unordered_map();
     }
 
   private:
-    TPrevRange          m_prev;
-    TKeySelector        m_key_selector;
-    sort_direction      m_sort_direction;
-    mutable container_t m_sorted_values;
+    std::vector<map_t> m_shards;
+    unsigned           m_shard_bits{};
 };
 
-// ----------------------------------
-// container_range
-// ----------------------------------
-
-template <typename TContainer>
-class container_range final : public range<container_range<TContainer>, typename TContainer::value_type> {
+namespace details {
+// A range whose operators are executed on multiple threads.
+// The source is split into chunks, on each of which the query is executed; the query is composed of the
+// ordinary range operators, and operators that are applied to the parallel range extend it. The chunks are
+// handed to the threads of an executor by splitting them in halves recursively (see run_tasks).
+template <typename TSource, typename TQuery>
+class parallel_range final {
   public:
-    struct iterator {
-        using container_iter_t = typename TContainer::const_iterator;
-        using output_t         = typename TContainer::const_reference;
+    using partition_t = decltype( partition_of( std::declval<const TSource&>(), 0, 0 ) );
+    using query_t     = std::invoke_result_t<const TQuery&, const partition_t&>;
+    using output_t    = typename query_t::output_t;
+
+    parallel_range( const TSource& source, TQuery query, executor_ref executor, bool is_ordered )
+        : m_source( source )
+        , m_query( std::move( query ) )
+        , m_executor( executor )
+        , m_is_ordered( is_ordered ) {
+    }
 
-        constexpr iterator() = default;
+    /// @brief Makes the results of the following operations independent of the number of threads.
+    /// The source is then split into chunks of a fixed size instead of a number of chunks per thread.
+    [[nodiscard]]
+    auto as_ordered() const -> parallel_range {
+        return parallel_range( m_source, m_query, m_executor, true );
+    }
 
-        constexpr explicit iterator( container_iter_t pos )
-            : m_pos( pos ) {
-        }
+    [[nodiscard]]
+    auto is_ordered() const -> bool {
+        return m_is_ordered;
+    }
 
-        constexpr bool operator==( const iterator& o ) const {
-            return m_pos == o.m_pos;
-        }
+    /// Gets the query as an ordinary range, which executes on the calling thread.
+    [[nodiscard]]
+    auto as_sequential() const {
+        return m_query( m_source );
+    }
 
-        constexpr bool operator!=( const iterator& o ) const {
-            return m_pos != o.m_pos;
-        }
+    template <typename TPredicate>
+    [[nodiscard]]
+    auto where( TPredicate&& predicate ) const {
+        return with_query( [query = m_query, predicate = std::forward<TPredicate>( predicate )]( const auto& partition ) {
+            return query( partition ).where( std::decay_t<TPredicate>( predicate ) );
+        } );
+    }
 
-        constexpr iterator& operator++() {
-            ++m_pos;
-            return *this;
-        }
+    template <typename TTransform>
+    [[nodiscard]]
+    auto select( TTransform&& transform ) const {
+        return with_query( [query = m_query, transform = std::forward<TTransform>( transform )]( const auto& partition ) {
+            return query( partition ).select( std::decay_t<TTransform>( transform ) );
+        } );
+    }
 
-        constexpr output_t operator*() const {
-            return *m_pos;
-        }
+    [[nodiscard]]
+    auto count() const -> size_t {
+        const auto counts = fold_chunks( size_t( 0 ), []( size_t& count, const auto& query ) {
+            count += query.count();
+            return true;
+        } );
 
-        container_iter_t m_pos{};
-    };
+        auto result = size_t( 0 );
 
-    constexpr container_range() = default;
+        for ( const auto count : counts )
+            result += count;
 
-    constexpr explicit container_range( const TContainer* container )
-        : m_container( container ) {
-        LINQ_ASSERT( container != nullptr && "null container given to range" );
+        return result;
     }
 
-    constexpr auto begin() const -> iterator {
-        return iterator( m_container->cbegin() );
+    template <typename TPredicate>
+    [[nodiscard]]
+    auto count( TPredicate&& predicate ) const -> size_t {
+        return where( std::forward<TPredicate>( predicate ) ).count();
     }
 
-    constexpr auto end() const -> iterator {
-        return iterator( m_container->cend() );
+    template <typename TPredicate>
+    [[nodiscard]]
+    auto any( const TPredicate& predicate ) const -> bool {
+        // Finding an element in one chunk stops all threads from taking further chunks.
+        const auto matches = fold_chunks( size_t( 0 ), [&predicate]( size_t& matches, const auto& query ) {
+            matches += query.any( predicate ) ? 1 : 0;
+            return matches == 0;
+        } );
+
+        return std::any_of( matches.begin(), matches.end(), []( size_t count ) {
+            return count > 0;
+        } );
     }
 
-    constexpr auto size() const -> size_t {
-        return m_container->size();
+    [[nodiscard]]
+    auto sum() const -> std::optional<output_t> {
+        const auto add = []( std::optional<output_t>& sum, std::optional<output_t>&& partial ) {
+            if ( !partial )
+                return;
+
+            if ( sum )
+                *sum += *partial;
+            else
+                sum = std::move( partial );
+        };
+
+        auto sums = fold_chunks( std::optional<output_t>(), [&add]( std::optional<output_t>& sum, const auto& query ) {
+            add( sum, query.sum() );
+            return true;
+        } );
+
+        auto result = std::optional<output_t>();
+
+        for ( auto& partial : sums )
+            add( result, std::move( partial ) );
+
+        return result;
     }
 
-  private:
-    const TContainer* m_container{};
-};
+    /// @brief Aggregates every chunk starting from the seed, and combines the partial results in a fixed
+    /// tree order. The combine function must therefore be associative and have the seed as its identity.
+    template <typename TSeed, typename TAccumFunc, typename TCombineFunc>
+    [[nodiscard]]
+    auto aggregate( TSeed seed, TAccumFunc&& accumulate, TCombineFunc&& combine ) const -> TSeed {
+        auto partials = as_ordered().fold_chunks( seed, [&accumulate]( TSeed& partial, const auto& query ) {
+            partial = query.aggregate( std::move( partial ), accumulate );
+            return true;
+        } );
 
-// ----------------------------------
-// mutable_container_range
-// ----------------------------------
+        return combine_in_tree( partials, [&combine]( TSeed&& a, TSeed&& b ) -> TSeed {
+            return std::invoke( combine, std::move( a ), std::move( b ) );
+        } );
+    }
 
-template <typename TContainer>
-class mutable_container_range final
-    : public range<mutable_container_range<TContainer>, typename TContainer::value_type> {
-  public:
-    struct iterator {
-        using container_iter_t = typename TContainer::iterator;
-        using output_t         = typename TContainer::reference;
+    /// @brief Like aggregate( seed, func, func ).
+    template <typename TSeed, typename TAccumFunc>
+    [[nodiscard]]
+    auto aggregate( TSeed seed, TAccumFunc&& func ) const -> TSeed {
+        static_assert(
+            std::is_invocable_r_v<TSeed, TAccumFunc&, TSeed&&, TSeed&&>,
+            "aggregate() on a parallel range combines partial results with the accumulator function, "
+            "which must therefore accept two accumulated values. Use aggregate( seed, func, combine ) otherwise." );
 
-        constexpr explicit iterator( container_iter_t pos )
-            : m_pos( pos ) {
-        }
+        return aggregate( std::move( seed ), func, func );
+    }
 
-        constexpr auto operator==( const iterator& o ) const -> bool {
-            return m_pos == o.m_pos;
-        }
+    /// @brief Reduces every chunk, and combines the partial results with the same function in a fixed
+    /// tree order. The function must therefore be associative.
+    template <typename TAccumFunc>
+    [[nodiscard]]
+    auto reduce( const TAccumFunc& func ) const -> output_t {
+        struct partial_t {
+            output_t value{};
+            bool     has_value{};
+        };
+
+        auto partials = as_ordered().fold_chunks( partial_t(), [&func]( partial_t& partial, const auto& query ) {
+            auto first  = true;
+            auto result = output_t();
+
+            query.for_each( [&]( auto&& element ) {
+                if ( first ) {
+                    result = std::forward<decltype( element )>( element );
+                    first  = false;
+                }
+                else {
+                    result = func( std::move( result ), element );
+                }
+            } );
 
-        constexpr auto operator!=( const iterator& o ) const -> bool {
-            return m_pos != o.m_pos;
-        }
+            if ( !first )
+                partial = partial_t{ std::move( result ), true };
 
-        constexpr auto operator++() -> iterator& {
-            ++m_pos;
-            return *this;
-        }
+            return true;
+        } );
 
-        constexpr auto operator*() const -> output_t& {
-            return *m_pos;
-        }
+        // Chunks without elements are skipped.
+        auto result = combine_in_tree( partials, [&func]( partial_t&& a, partial_t&& b ) -> partial_t {
+            if ( !a.has_value )
+                return std::move( b );
 
-        container_iter_t m_pos;
-    };
+            if ( !b.has_value )
+                return std::move( a );
 
-    constexpr explicit mutable_container_range( TContainer* container )
-        : m_container( container ) {
-        LINQ_ASSERT( container != nullptr && "null container given to range" );
-    }
+            return partial_t{ func( std::move( a.value ), b.value ), true };
+        } );
 
-    constexpr auto begin() const -> iterator {
-        return iterator( m_container->begin() );
+        return std::move( result.value );
     }
 
-    constexpr auto end() const -> iterator {
-        return iterator( m_container->end() );
-    }
+    /// Stores the elements in a vector, in source order.
+    [[nodiscard]]
+    auto to_vector() const -> std::vector<output_t> {
+        // If the number of elements of every chunk is known, threads store them in place.
+        if constexpr ( has_fixed_size<query_t> && std::is_default_constructible_v<output_t> &&
+                       std::is_move_assignable_v<output_t> && !std::is_same_v<output_t, bool> ) {
+            const auto chunks = make_chunking();
 
-    constexpr auto size() const -> size_t {
-        return m_container->size();
-    }
+            auto offsets = std::vector<size_t>( chunks.chunk_count + 1 );
 
-  private:
-    TContainer* m_container{};
-};
+            for ( size_t chunk = 0; chunk < chunks.chunk_count; ++chunk )
+                offsets[chunk + 1] = offsets[chunk] + chunk_query( chunks, chunk ).size();
+
+            auto result = std::vector<output_t>( offsets.back() );
 
-// ----------------------------------
-// container_copy_range
-// ----------------------------------
+            run_chunks( chunks, [&]( size_t chunk, const query_t& query ) {
+                auto* destination = result.data() + offsets[chunk];
 
-template <typename TContainer>
-class container_copy_range final : public range<container_copy_range<TContainer>, typename TContainer::value_type> {
-  public:
-    struct iterator {
-        using container_iter_t = typename TContainer::iterator;
-        using output_t         = typename TContainer::reference;
+                query.for_each( [&destination]( auto&& element ) {
+                    *destination++ = std::forward<decltype( element )>( element );
+                } );
 
-        constexpr explicit iterator( container_iter_t pos )
-            : m_pos( pos ) {
-        }
+                return true;
+            } );
 
-        constexpr auto operator==( const iterator& o ) const -> bool {
-            return m_pos == o.m_pos;
+            return result;
         }
+        else {
+            auto parts = fold_chunks( std::vector<output_t>(), []( std::vector<output_t>& part, const auto& query ) {
+                query.for_each( [&part]( auto&& element ) {
+                    part.emplace_back( std::forward<decltype( element )>( element ) );
+                } );
 
-        constexpr auto operator!=( const iterator& o ) const -> bool {
-            return m_pos != o.m_pos;
-        }
+                return true;
+            } );
 
-        constexpr auto operator++() -> iterator& {
-            ++m_pos;
-            return *this;
-        }
+            auto result = std::move( parts.front() );
+            auto size   = size_t( 0 );
 
-        constexpr auto operator*() const -> output_t& {
-            return *m_pos;
-        }
+            for ( const auto& part : parts )
+                size += part.size();
 
-        container_iter_t m_pos;
-    };
+            result.reserve( size );
 
-    constexpr explicit container_copy_range( const TContainer& container )
-        : m_container( container ) {
-    }
+            for ( size_t i = 1; i < parts.size(); ++i ) {
+                result.insert(
+                    result.end(),
+                    std::make_move_iterator( parts[i].begin() ),
+                    std::make_move_iterator( parts[i].end() ) );
+            }
 
-    constexpr iterator begin() const {
-        return iterator{ m_container.begin() };
+            return result;
+        }
     }
 
-    constexpr iterator end() const {
-        return iterator{ m_container.end() };
-    }
+    /// @brief Stores the key/value pairs in a sharded_map. Every thread distributes the pairs of its chunks
+    /// to the shards by the hashes of their keys, after which every shard is built by one thread.
+    /// Like to_unordered_map(), the first pair of a key wins.
+    [[nodiscard]]
+    auto to_sharded_map() const {
+        using key_t   = typename output_t::first_type;
+        using value_t = typename output_t::second_type;
+        using map_t   = typename sharded_map<key_t, value_t>::map_t;
+        using entry_t = std::pair<key_t, value_t>;
 
-    constexpr auto size() const {
-        return m_container->size();
-    }
+        // Chunks of a fixed size keep the order of the pairs of a key.
+        const auto ordered = as_ordered();
+        const auto chunks  = ordered.make_chunking();
 
-  private:
-    TContainer m_container{};
-};
+        if ( chunks.thread_count == 1 )
+            return sharded_map<key_t, value_t>( as_sequential().to_unordered_map() );
 
-// ----------------------------------
-// from_initializer_list
-// ----------------------------------
+        const auto shard_bits  = shard_bits_for( chunks.thread_count );
+        const auto shard_count = size_t( 1 ) << shard_bits;
 
-template <typename T, typename TContainer = std::vector<T>>
-class initializer_list_range final : public range<initializer_list_range<T>, typename TContainer::const_iterator> {
-  public:
-    struct iterator {
-        using container_iter_t = typename TContainer::const_iterator;
-        using output_t         = typename TContainer::const_reference;
+        const auto to_entry = []( auto&& element, size_t ) {
+            using element_t = decltype( element );
+            return entry_t( std::forward<element_t>( element ).first, std::forward<element_t>( element ).second );
+        };
 
-        constexpr explicit iterator( container_iter_t pos )
-            : m_pos( pos ) {
-        }
+        auto partitions = ordered.template scatter_to_shards<entry_t>( chunks, shard_bits, to_entry );
 
-        constexpr bool operator==( const iterator& o ) const {
-            return m_pos == o.m_pos;
-        }
+        auto maps = std::vector<map_t>( shard_count );
 
-        constexpr bool operator!=( const iterator& o ) const {
-            return m_pos != o.m_pos;
-        }
+        run_tasks( chunks.executor, shard_count, chunks.thread_count, [&]( size_t shard ) {
+            auto& map  = maps[shard];
+            auto  size = size_t( 0 );
 
-        constexpr iterator& operator++() {
-            ++m_pos;
-            return *this;
-        }
+            for ( size_t chunk = 0; chunk < chunks.chunk_count; ++chunk )
+                size += partitions[chunk * shard_count + shard].size();
 
-        constexpr const output_t& operator*() const {
-            return *m_pos;
-        }
+            map.reserve( size );
 
-        container_iter_t m_pos;
-    };
+            for ( size_t chunk = 0; chunk < chunks.chunk_count; ++chunk ) {
+                auto& entries = partitions[chunk * shard_count + shard];
 
-    constexpr explicit initializer_list_range( std::initializer_list<T> list ) // NOLINT(*-explicit-constructor)
-        : m_list( list.begin(), list.end() ) {
-    }
+                for ( auto& entry : entries )
+                    map.emplace( std::move( entry.first ), std::move( entry.second ) );
 
-    constexpr iterator begin() const {
-        return iterator( m_list.begin() );
-    }
+                entries = std::vector<entry_t>();
+            }
 
-    constexpr iterator end() const {
-        return iterator( m_list.end() );
+            return true;
+        } );
+
+        return sharded_map<key_t, value_t>( std::move( maps ), shard_bits );
     }
 
-    constexpr auto size() const -> size_t {
-        return m_list.size();
+    /// @brief Like to_sharded_map(), but merges the shards into a single std::unordered_map.
+    [[nodiscard]]
+    auto to_unordered_map() const {
+        return to_sharded_map().to_unordered_map();
     }
 
-  private:
-    std::vector<T> m_list{};
-};
+    /// @brief Groups the elements by a key and stores them in a linq::lookup, which equals the one that
+    /// to_lookup() builds on the calling thread. Like to_sharded_map(), every thread computes the keys of its
+    /// chunks and distributes the elements to shards by the hashes of the keys, after which every shard is
+    /// grouped by one thread. The groups are then ordered by the first occurrence of their keys.
+    template <typename TKeySelector>
+    [[nodiscard]]
+    auto to_lookup( const TKeySelector& key_selector ) const {
+        using lookup_type = lookup_t<query_t, TKeySelector>;
+        using key_t       = selected_key_t<query_t, TKeySelector>;
+        using entry_t     = std::pair<key_t, std::pair<size_t, output_t>>;
+
+        // Chunks of a fixed size keep the order of the elements of a key.
+        const auto ordered = as_ordered();
+        const auto chunks  = ordered.make_chunking();
+
+        auto result = lookup_type();
+
+        if constexpr ( std::is_default_constructible_v<output_t> && std::is_move_assignable_v<output_t> &&
+                       !std::is_same_v<output_t, bool> ) {
+            if ( chunks.thread_count > 1 ) {
+                const auto shard_bits  = shard_bits_for( chunks.thread_count );
+                const auto shard_count = size_t( 1 ) << shard_bits;
+
+                // Every entry stores its key and its index within its chunk, which orders the groups.
+                auto partitions = ordered.template scatter_to_shards<entry_t>(
+                    chunks,
+                    shard_bits,
+                    [&key_selector]( auto&& element, size_t index ) {
+                        auto key = static_cast<key_t>( std::invoke( key_selector, element ) );
+                        return entry_t(
+                            std::move( key ),
+                            std::pair<size_t, output_t>( index, std::forward<decltype( element )>( element ) ) );
+                    } );
+
+                // The groups of a shard, in the order of the first occurrence of their keys.
+                struct shard_groups {
+                    std::vector<key_t>                     keys;
+                    std::vector<size_t>                    counts;    // Later the output position of the next element
+                    std::vector<std::pair<size_t, size_t>> firsts;    // The chunk and index of the first element
+                    std::vector<size_t>                    group_ids; // The group of every entry, in source order
+                };
+
+                auto shards = std::vector<shard_groups>( shard_count );
+
+                run_tasks( chunks.executor, shard_count, chunks.thread_count, [&]( size_t shard ) {
+                    auto& groups = shards[shard];
+                    auto  index  = flat_hash_index<key_t, shard_key_hash<key_t>>( shard_key_hash<key_t>{ shard_bits } );
+
+                    for ( size_t chunk = 0; chunk < chunks.chunk_count; ++chunk ) {
+                        for ( auto& entry : partitions[chunk * shard_count + shard] ) {
+                            const auto hash  = index.hash( entry.first );
+                            auto       group = index.find( groups.keys, entry.first, hash );
+
+                            if ( group == index.npos ) {
+                                group = groups.keys.size();
+                                groups.keys.push_back( std::move( entry.first ) );
+                                index.insert( groups.keys, hash );
+                                groups.counts.push_back( 0 );
+                                groups.firsts.emplace_back( chunk, entry.second.first );
+                            }
+
+                            ++groups.counts[group];
+                            groups.group_ids.push_back( group );
+                        }
+                    }
 
-// ----------------------------------
-// from_to_range
-// ----------------------------------
+                    return true;
+                } );
 
-template <typename T>
-class from_to_range final : public range<from_to_range<T>, T> {
-  public:
-    struct iterator {
-        using output_t = T;
+                // Order the groups of all shards by the first occurrence of their keys.
+                auto order = std::vector<std::tuple<size_t, size_t, size_t, size_t>>();
 
-        constexpr iterator( output_t value, const output_t* step )
-            : m_value( std::move( value ) )
-            , m_step( step ) {
-        }
+                for ( size_t shard = 0; shard < shard_count; ++shard ) {
+                    const auto& firsts = shards[shard].firsts;
 
-        constexpr bool operator==( const iterator& o ) const {
-            return o.m_value < m_value;
-        }
+                    for ( size_t group = 0; group < firsts.size(); ++group )
+                        order.emplace_back( firsts[group].first, firsts[group].second, shard, group );
+                }
 
-        constexpr bool operator!=( const iterator& o ) const {
-#ifdef __clang__
-#pragma clang diagnostic push
-#pragma ide diagnostic ignored "Simplify"
-#endif
-            return !( *this == o );
-#ifdef __clang__
-#pragma clang diagnostic pop
-#endif
-        }
+                std::sort( order.begin(), order.end() );
 
-        constexpr iterator& operator++() {
-            m_value += *m_step;
-            return *this;
-        }
+                auto keys    = std::vector<key_t>();
+                auto offsets = std::vector<size_t>( 1, 0 );
 
-        constexpr const output_t& operator*() const {
-            return m_value;
-        }
+                keys.reserve( order.size() );
+                offsets.reserve( order.size() + 1 );
 
-        output_t        m_value;
-        const output_t* m_step;
-    };
+                for ( const auto& [chunk, first, shard, group] : order ) {
+                    auto& groups = shards[shard];
 
-    constexpr from_to_range( T&& start, T&& end, T&& step )
-        : m_start( std::forward<T>( start ) )
-        , m_end( std::forward<T>( end ) )
-        , m_step( std::forward<T>( step ) ) {
-        LINQ_ASSERT( m_start < m_end );
-    }
+                    keys.push_back( std::move( groups.keys[group] ) );
+                    offsets.push_back( offsets.back() + std::exchange( groups.counts[group], offsets.back() ) );
+                }
 
-    constexpr iterator begin() const {
-        return iterator( m_start, std::addressof( m_step ) );
-    }
+                // Every shard moves its elements to the positions of their groups.
+                auto elements = std::vector<output_t>( offsets.back() );
 
-    constexpr iterator end() const {
-        return iterator( m_end, std::addressof( m_step ) );
-    }
+                run_tasks( chunks.executor, shard_count, chunks.thread_count, [&]( size_t shard ) {
+                    auto& groups   = shards[shard];
+                    auto  group_id = groups.group_ids.begin();
 
-    constexpr auto size() const -> size_t
-#ifdef __cpp_lib_concepts
-        requires( std::integral<T> )
-#endif
-    {
-#ifndef __cpp_lib_concepts
-        static_assert( std::is_integral_v<T>, "from_to ranges only support .size() for integral elements" );
-#endif
+                    for ( size_t chunk = 0; chunk < chunks.chunk_count; ++chunk ) {
+                        auto& entries = partitions[chunk * shard_count + shard];
 
-        return static_cast<size_t>( ( ( m_end - m_start ) / m_step ) + 1 );
-    }
+                        for ( auto& entry : entries )
+                            elements[groups.counts[*group_id++]++] = std::move( entry.second.second );
 
-  private:
-    T m_start;
-    T m_end;
-    T m_step;
-};
+                        entries = std::vector<entry_t>();
+                    }
 
-// ----------------------------------
-// generate_range
-// ----------------------------------
+                    return true;
+                } );
 
-struct generator_return_value_ident {
-    /* Nothing to define here. */
-};
+                result.assign_groups( std::move( keys ), std::move( offsets ), std::move( elements ) );
 
-template <typename T>
-struct generator_return_value final : generator_return_value_ident {
-    using value_type = T;
+                return result;
+            }
+        }
 
-    constexpr generator_return_value() = default;
+        result.assign( as_sequential(), key_selector );
 
-    constexpr explicit generator_return_value( T value )
-        : m_value( std::move( value ) )
-        , m_is_empty( false ) {
+        return result;
     }
 
-    constexpr bool operator==( const generator_return_value& o ) const {
-        // We only care about whether two generator_return_values are empty or not.
-        // If the iterator has an empty one, it will match the one from the last
-        // iterator, which indicates the end of iteration.
-        return m_is_empty == o.m_is_empty;
+  private:
+    template <typename TNewQuery>
+    auto with_query( TNewQuery query ) const -> parallel_range<TSource, TNewQuery> {
+        return parallel_range<TSource, TNewQuery>( m_source, std::move( query ), m_executor, m_is_ordered );
     }
 
-    constexpr bool operator!=( const generator_return_value& o ) const {
-        // Same as in operator==.
-        return m_is_empty != o.m_is_empty;
+    // How the source is split into chunks. Ordered ranges are split into chunks of a fixed size,
+    // so that their results do not depend on the number of threads.
+    struct chunking {
+        executor_ref executor;
+        size_t       size;
+        size_t       thread_count;
+        size_t       chunk_count;
+    };
+
+    auto make_chunking() const -> chunking {
+        const auto executor     = m_executor.resolve();
+        const auto size         = m_source.size();
+        const auto thread_count = parallel_thread_count( executor, size );
+        auto       chunk_count  = size_t( 1 );
+
+        if ( m_is_ordered )
+            chunk_count = std::max<size_t>( ( size + parallel_ordered_chunk_size - 1 ) / parallel_ordered_chunk_size, 1 );
+        else if ( thread_count > 1 )
+            chunk_count = std::min( size, thread_count * parallel_chunks_per_thread );
+
+        return chunking{ executor, size, thread_count, chunk_count };
     }
 
-    T    m_value{};
-    bool m_is_empty{ true };
-};
+    auto chunk_query( const chunking& chunks, size_t chunk ) const -> query_t {
+        const auto first = chunks.size * chunk / chunks.chunk_count;
+        const auto last  = chunks.size * ( chunk + 1 ) / chunks.chunk_count;
 
-template <typename TGenerator>
-struct generate_range_traits final {
-    using generator_return_type = std::invoke_result_t<TGenerator, size_t>;
+        return m_query( partition_of( m_source, first, last - first ) );
+    }
 
-    // Ensure that whatever the generator returned is indeed of type generator_return_type.
-    static_assert(
-        std::is_base_of_v<generator_return_value_ident, generator_return_type>,
-        "The generator function is expected to return a result of linq::generate_return() or "
-        "linq::generate_finish()." );
+    // Executes func( chunk, query ) for every chunk of the source, until func returns false.
+    template <typename TFunc>
+    void run_chunks( const chunking& chunks, const TFunc& func ) const {
+        run_tasks( chunks.executor, chunks.chunk_count, chunks.thread_count, [&]( size_t chunk ) {
+            return func( chunk, chunk_query( chunks, chunk ) );
+        } );
+    }
 
-    // The type that is wrapped by the returned generator_return_type.
-    using value_type = typename generator_return_type::value_type;
-};
+    // Executes the query on every chunk of the source and folds the results into a state per chunk,
+    // via fold( state, query ), which returns false to stop. The states are in source order.
+    template <typename TState, typename TFold>
+    auto fold_chunks( const TState& initial, const TFold& fold ) const -> std::vector<TState> {
+        const auto chunks = make_chunking();
 
-template <typename TGenerator>
-class generator_range final
-    : public range<generator_range<TGenerator>, typename generate_range_traits<TGenerator>::value_type> {
-  public:
-    struct iterator {
-        using generator_return_type = typename generate_range_traits<TGenerator>::generator_return_type;
-        using output_t              = typename generate_range_traits<TGenerator>::value_type;
+        auto states = std::vector<TState>( chunks.chunk_count, initial );
 
-        constexpr iterator( const generator_range* parent, bool is_end )
-            : m_parent( parent ) {
-            if ( is_end ) {
-                m_last_result = generator_return_type();
-            }
-            else {
-                // First iteration
-                m_last_result = m_parent->m_generator( m_iteration );
-            }
-        }
+        run_chunks( chunks, [&]( size_t chunk, const query_t& query ) {
+            return fold( states[chunk], query );
+        } );
 
-        constexpr bool operator==( const iterator& o ) const {
-            return m_last_result == o.m_last_result;
-        }
+        return states;
+    }
 
-        constexpr bool operator!=( const iterator& o ) const {
-            return m_last_result != o.m_last_result;
-        }
+    // Distributes the elements of every chunk to 2^shard_bits shards by the hashes of their keys.
+    // make_entry( element, index ) converts the element at an index of its chunk to a std::pair whose first
+    // member is the key. The entries of a chunk and shard are stored at [chunk * shard_count + shard],
+    // in source order.
+    template <typename TEntry, typename TMakeEntry>
+    auto scatter_to_shards( const chunking& chunks, unsigned shard_bits, const TMakeEntry& make_entry ) const
+        -> std::vector<std::vector<TEntry>> {
+        using key_t = typename TEntry::first_type;
 
-        constexpr iterator& operator++() {
-            ++m_iteration;
-            m_last_result = m_parent->m_generator( m_iteration );
-            return *this;
-        }
+        const auto shard_count = size_t( 1 ) << shard_bits;
 
-        constexpr const output_t& operator*() const {
-            return m_last_result.m_value;
-        }
+        auto partitions = std::vector<std::vector<TEntry>>( chunks.chunk_count * shard_count );
 
-        const generator_range* m_parent;
-        size_t                 m_iteration{};
-        generator_return_type  m_last_result;
-    };
+        run_chunks( chunks, [&]( size_t chunk, const query_t& query ) {
+            auto* const shards = partitions.data() + chunk * shard_count;
+            auto        index  = size_t( 0 );
 
-    constexpr explicit generator_range( TGenerator generator )
-        : m_generator( std::move( generator ) ) {
-    }
+            query.for_each( [&]( auto&& element ) {
+                auto       entry = make_entry( std::forward<decltype( element )>( element ), index++ );
+                const auto shard = shard_of_hash( std::hash<key_t>()( entry.first ), shard_bits );
 
-    constexpr iterator begin() const {
-        return iterator( this, false );
-    }
+                shards[shard].push_back( std::move( entry ) );
+            } );
 
-    constexpr iterator end() const {
-        return iterator( this, true );
+            return true;
+        } );
+
+        return partitions;
     }
 
-  private:
-    TGenerator m_generator;
+    TSource      m_source;
+    TQuery       m_query;
+    executor_ref m_executor;
+    bool         m_is_ordered{};
 };
 
+// Makes a parallel range of a range, executed by an executor.
+template <typename TRange>
+auto parallel_range_of( const TRange& range, executor_ref executor ) {
+    return parallel_range<TRange, partition_query>( range, partition_query(), executor, false );
+}
+
+#endif // LINQ_NO_STL_CONTAINERS
+
 // ----------------------------------
 // base_range method definitions
 // ----------------------------------
@@ -2046,8 +6511,24 @@ constexpr auto range<Derived, TOutput>::where( TPredicate&& predicate ) const {
 
 template <typename Derived, typename TOutput>
 constexpr auto range<Derived, TOutput>::distinct() const {
-    return distinct_range<Derived>( self_ref() );
+#ifndef LINQ_NO_STL_CONTAINERS
+    if constexpr ( is_hashable_v<output_t> ) {
+        return distinct( std::hash<output_t>(), std::equal_to<output_t>() );
+    }
+    else
+#endif
+    {
+        return distinct_range<Derived>( self_ref() );
+    }
+}
+
+#ifndef LINQ_NO_STL_CONTAINERS
+template <typename Derived, typename TOutput>
+template <typename THash, typename TEqual>
+constexpr auto range<Derived, TOutput>::distinct( THash hasher, TEqual equal ) const {
+    return hash_distinct_range<Derived, THash, TEqual>( self_ref(), std::move( hasher ), std::move( equal ) );
 }
+#endif
 
 template <typename Derived, typename TOutput>
 template <typename TTransform>
@@ -2081,7 +6562,13 @@ constexpr auto range<Derived, TOutput>::reverse() const {
 
 template <typename Derived, typename TOutput>
 constexpr auto range<Derived, TOutput>::take( size_t count ) const {
-    return take_range<Derived>( self_ref(), count );
+    if constexpr ( std::is_base_of_v<sorting_range, Derived> ) {
+        // Only the first elements of a sort chain are needed, so it may perform a top-k selection.
+        return take_range<Derived>( self_ref().with_limit( count ), count );
+    }
+    else {
+        return take_range<Derived>( self_ref(), count );
+    }
 }
 
 template <typename Derived, typename TOutput>
@@ -2119,7 +6606,39 @@ constexpr auto range<Derived, TOutput>::join(
     TKeySelectorA&&    key_selector_a,
     TKeySelectorB&&    key_selector_b,
     TTransform&&       transform ) const {
-    return join_range<Derived, TOtherRange, TKeySelectorA, TKeySelectorB, TTransform>(
+#ifndef LINQ_NO_STL_CONTAINERS
+    using key_a_t = selected_key_t<Derived, TKeySelectorA>;
+    using key_b_t = selected_key_t<TOtherRange, TKeySelectorB>;
+
+    // Keys that can be hashed are joined using a hash table instead of a nested loop.
+    if constexpr ( std::is_same_v<key_a_t, key_b_t> && is_hashable_v<key_b_t> ) {
+        return hash_join_range<Derived, TOtherRange, TKeySelectorA, TKeySelectorB, TTransform>(
+            self_ref(),
+            other_range,
+            std::forward<TKeySelectorA>( key_selector_a ),
+            std::forward<TKeySelectorB>( key_selector_b ),
+            std::forward<TTransform>( transform ) );
+    }
+    else
+#endif
+    {
+        return join_range<Derived, TOtherRange, TKeySelectorA, TKeySelectorB, TTransform>(
+            self_ref(),
+            other_range,
+            std::forward<TKeySelectorA>( key_selector_a ),
+            std::forward<TKeySelectorB>( key_selector_b ),
+            std::forward<TTransform>( transform ) );
+    }
+}
+
+template <typename Derived, typename TOutput>
+template <typename TOtherRange, typename TKeySelectorA, typename TKeySelectorB, typename TTransform>
+constexpr auto range<Derived, TOutput>::join_sorted(
+    const TOtherRange& other_range,
+    TKeySelectorA&&    key_selector_a,
+    TKeySelectorB&&    key_selector_b,
+    TTransform&&       transform ) const {
+    return merge_join_range<Derived, TOtherRange, TKeySelectorA, TKeySelectorB, TTransform>(
         self_ref(),
         other_range,
         std::forward<TKeySelectorA>( key_selector_a ),
@@ -2127,16 +6646,65 @@ constexpr auto range<Derived, TOutput>::join(
         std::forward<TTransform>( transform ) );
 }
 
+#ifndef LINQ_NO_STL_CONTAINERS
+template <typename Derived, typename TOutput>
+template <typename TKeySelector>
+constexpr auto range<Derived, TOutput>::group_by( TKeySelector&& key_selector ) const {
+    return group_by_range<Derived, TKeySelector>( self_ref(), std::forward<TKeySelector>( key_selector ) );
+}
+
+template <typename Derived, typename TOutput>
+template <typename TKeySelector, typename TSeed, typename TAccumFunc>
+constexpr auto
+range<Derived, TOutput>::aggregate_by( TKeySelector&& key_selector, TSeed seed, TAccumFunc&& func ) const {
+    return aggregate_by_range<Derived, TKeySelector, TSeed, TAccumFunc>(
+        self_ref(),
+        std::forward<TKeySelector>( key_selector ),
+        std::move( seed ),
+        std::forward<TAccumFunc>( func ) );
+}
+
+template <typename Derived, typename TOutput>
+template <typename TKeySelector, typename TAccumFunc>
+constexpr auto range<Derived, TOutput>::reduce_by( TKeySelector&& key_selector, TAccumFunc&& func ) const {
+    return aggregate_by_range<Derived, TKeySelector, reduce_seed, TAccumFunc>(
+        self_ref(),
+        std::forward<TKeySelector>( key_selector ),
+        reduce_seed(),
+        std::forward<TAccumFunc>( func ) );
+}
+
+template <typename Derived, typename TOutput>
+template <typename TKeySelector>
+constexpr auto range<Derived, TOutput>::count_by( TKeySelector&& key_selector ) const {
+    return aggregate_by(
+        std::forward<TKeySelector>( key_selector ),
+        static_cast<size_t>( 0 ),
+        []( size_t count, const auto& ) {
+            return count + 1;
+        } );
+}
+#endif
+
 template <typename Derived, typename TOutput>
 template <typename TKeySelector>
-constexpr auto range<Derived, TOutput>::order_by( TKeySelector&& key_selector, sort_direction sort_dir ) const {
-    return order_by_range<Derived, TKeySelector>( self_ref(), std::forward<TKeySelector>( key_selector ), sort_dir );
+constexpr auto range<Derived, TOutput>::order_by(
+    TKeySelector&& key_selector,
+    sort_direction sort_dir,
+    sort_stability stability ) const {
+    return order_by_range<Derived, TKeySelector>(
+        self_ref(),
+        std::forward<TKeySelector>( key_selector ),
+        sort_dir,
+        stability );
 }
 
 template <typename Derived, typename TOutput>
 template <typename TKeySelector>
-constexpr auto range<Derived, TOutput>::order_by_descending( TKeySelector&& key_selector ) const {
-    return order_by<TKeySelector>( std::forward<TKeySelector>( key_selector ), sort_direction::descending );
+constexpr auto range<Derived, TOutput>::order_by_descending(
+    TKeySelector&& key_selector,
+    sort_stability stability ) const {
+    return order_by<TKeySelector>( std::forward<TKeySelector>( key_selector ), sort_direction::descending, stability );
 }
 
 template <typename Derived, typename TOutput>
@@ -2147,8 +6715,10 @@ constexpr auto range<Derived, TOutput>::then_by( TKeySelector&& key_selector, so
 
 template <typename Derived, typename TOutput>
 template <typename TKeySelector>
-constexpr auto range<Derived, TOutput>::order_by_ascending( TKeySelector&& key_selector ) const {
-    return order_by<TKeySelector>( std::forward<TKeySelector>( key_selector ), sort_direction::ascending );
+constexpr auto range<Derived, TOutput>::order_by_ascending(
+    TKeySelector&& key_selector,
+    sort_stability stability ) const {
+    return order_by<TKeySelector>( std::forward<TKeySelector>( key_selector ), sort_direction::ascending, stability );
 }
 
 template <typename Derived, typename TOutput>
@@ -2169,40 +6739,146 @@ constexpr auto range<Derived, TOutput>::sum() const {
         std::is_default_constructible_v<output_t>,
         "sum() requires the range's output type to be default-constructible." );
 
+#ifdef LINQ_SIMD_KERNELS
+    if constexpr ( contiguous_range<Derived> && has_simd_kernels_v<output_t> ) {
+        if ( !std::is_constant_evaluated() ) {
+            const auto& self  = static_cast<const Derived&>( *this );
+            const auto  count = self.size();
+
+            if ( count == 0 )
+                return std::optional<output_t>();
+
+            return std::optional<output_t>( simd_sum( self.data(), count ) );
+        }
+    }
+#endif
+
     auto first  = true;
     auto result = output_t();
 
-    for ( auto&& p : self_ref() ) {
+    for_each( [&]( auto&& element ) {
         if ( first ) {
-            result = p;
+            result = std::forward<decltype( element )>( element );
             first  = false;
         }
         else {
-            result += p;
+            result += element;
         }
-    }
+    } );
 
     return first ? std::optional<output_t>() : std::optional<output_t>( std::move( result ) );
 }
 
+template <typename Derived, typename TOutput>
+template <typename TFunc>
+constexpr void range<Derived, TOutput>::for_each( TFunc&& func ) const {
+    static_cast<const Derived&>( *this ).push( [&func]( auto&& element ) {
+        using result_t = decltype( std::invoke( func, std::forward<decltype( element )>( element ) ) );
+
+        if constexpr ( std::is_same_v<result_t, bool> ) {
+            return std::invoke( func, std::forward<decltype( element )>( element ) );
+        }
+        else {
+            std::invoke( func, std::forward<decltype( element )>( element ) );
+            return true;
+        }
+    } );
+}
+
+template <typename Derived, typename TOutput>
+template <typename TSink>
+constexpr auto range<Derived, TOutput>::push( TSink&& sink ) const -> bool {
+    const auto& self  = static_cast<const Derived&>( *this );
+    const auto  first = self.begin();
+
+    return push_elements( first, self.end(), sink );
+}
+
+#ifndef LINQ_NO_STL_CONTAINERS
+template <typename Derived, typename TOutput>
+constexpr auto range<Derived, TOutput>::batched( size_t batch_size ) const {
+    return batched_range<Derived>( self_ref(), batch_size );
+}
+
+template <typename Derived, typename TOutput>
+auto range<Derived, TOutput>::cache() const {
+    return cache_range<Derived>( self_ref() );
+}
+
+template <typename Derived, typename TOutput>
+auto range<Derived, TOutput>::as_parallel() const
+#  ifdef __cpp_lib_concepts
+    requires( partitionable_range<Derived> )
+#  endif
+{
+    return parallel_range_of( static_cast<const Derived&>( *this ), executor_ref() );
+}
+
+#  ifndef LINQ_NO_THREADS
+template <typename Derived, typename TOutput>
+template <typename TExecutor>
+auto range<Derived, TOutput>::as_parallel( TExecutor& executor ) const
+#    ifdef __cpp_lib_concepts
+    requires( partitionable_range<Derived> && task_executor<TExecutor> )
+#    endif
+{
+    return parallel_range_of( static_cast<const Derived&>( *this ), executor_ref( executor ) );
+}
+#  endif
+
+template <typename Derived, typename TOutput>
+template <typename TSink>
+auto range<Derived, TOutput>::push_batches( TSink&& sink, size_t batch_size ) const -> bool {
+    auto buffer = std::vector<output_t>();
+    buffer.reserve( batch_size );
+
+    const auto flush = [&]() {
+        const auto keep_going = sink( element_batch<output_t>{ buffer.data(), nullptr, buffer.size() } );
+        buffer.clear();
+        return keep_going;
+    };
+
+    const auto completed = static_cast<const Derived&>( *this ).push( [&]( auto&& element ) {
+        buffer.emplace_back( std::forward<decltype( element )>( element ) );
+        return buffer.size() < batch_size || flush();
+    } );
+
+    return completed && ( buffer.empty() || flush() );
+}
+#endif
+
 template <typename Derived, typename TOutput>
 constexpr auto range<Derived, TOutput>::min() const {
     static_assert(
         std::is_default_constructible_v<output_t>,
         "min() requires the range's output type to be default-constructible." );
 
+#ifdef LINQ_SIMD_KERNELS
+    if constexpr ( contiguous_range<Derived> && has_simd_kernels_v<output_t> ) {
+        if ( !std::is_constant_evaluated() ) {
+            const auto& self  = static_cast<const Derived&>( *this );
+            const auto  count = self.size();
+
+            if ( count == 0 )
+                return std::optional<output_t>();
+
+            return std::optional<output_t>( simd_extremum( self.data(), count, is_less() ) );
+        }
+    }
+#endif
+
     auto first  = true;
     auto result = output_t();
 
-    for ( auto&& p : self_ref() ) {
+    for_each( [&]( auto&& element ) {
         if ( first ) {
-            result = std::move( p );
+            result = std::forward<decltype( element )>( element );
             first  = false;
         }
-        else if ( p < result ) {
-            result = p;
+        else if ( element < result ) {
+            result = std::forward<decltype( element )>( element );
         }
-    }
+    } );
 
     return first ? std::optional<output_t>{} : std::optional<output_t>{ result };
 }
@@ -2213,18 +6889,32 @@ constexpr auto range<Derived, TOutput>::max() const {
         std::is_default_constructible_v<output_t>,
         "max() requires the range's output type to be default-constructible." );
 
+#ifdef LINQ_SIMD_KERNELS
+    if constexpr ( contiguous_range<Derived> && has_simd_kernels_v<output_t> ) {
+        if ( !std::is_constant_evaluated() ) {
+            const auto& self  = static_cast<const Derived&>( *this );
+            const auto  count = self.size();
+
+            if ( count == 0 )
+                return std::optional<output_t>();
+
+            return std::optional<output_t>( simd_extremum( self.data(), count, is_greater() ) );
+        }
+    }
+#endif
+
     auto first  = true;
     auto result = output_t();
 
-    for ( auto&& p : self_ref() ) {
+    for_each( [&]( auto&& element ) {
         if ( first ) {
-            result = std::move( p );
+            result = std::forward<decltype( element )>( element );
             first  = false;
         }
-        else if ( result < p ) {
-            result = p;
+        else if ( result < element ) {
+            result = std::forward<decltype( element )>( element );
         }
-    }
+    } );
 
     return first ? std::optional<output_t>{} : std::optional<output_t>{ result };
 }
@@ -2235,25 +6925,95 @@ constexpr auto range<Derived, TOutput>::sum_and_count() const {
         std::is_default_constructible_v<output_t>,
         "sum_and_count() requires the range's output type to be default-constructible." );
 
+#ifdef LINQ_SIMD_KERNELS
+    if constexpr ( contiguous_range<Derived> && has_simd_kernels_v<output_t> ) {
+        if ( !std::is_constant_evaluated() ) {
+            const auto& self  = static_cast<const Derived&>( *this );
+            const auto  count = self.size();
+
+            if ( count == 0 )
+                return std::optional<std::pair<output_t, size_t>>();
+
+            return std::optional<std::pair<output_t, size_t>>( std::make_pair( simd_sum( self.data(), count ), count ) );
+        }
+    }
+#endif
+
     auto first  = true;
     auto result = output_t();
     auto count  = static_cast<size_t>( 0 );
 
-    for ( auto&& p : self_ref() ) {
+    for_each( [&]( auto&& element ) {
         if ( first ) {
-            result = std::move( p );
+            result = std::forward<decltype( element )>( element );
             first  = false;
         }
         else {
-            result += p;
+            result += element;
         }
         ++count;
-    }
+    } );
 
     return first ? std::optional<std::pair<output_t, size_t>>()
                  : std::optional<std::pair<output_t, size_t>>( std::make_pair( std::move( result ), count ) );
 }
 
+template <typename Derived, typename TOutput>
+constexpr auto range<Derived, TOutput>::min_max() const {
+    static_assert(
+        std::is_default_constructible_v<output_t>,
+        "min_max() requires the range's output type to be default-constructible." );
+
+#ifdef LINQ_SIMD_KERNELS
+    if constexpr ( contiguous_range<Derived> && has_simd_kernels_v<output_t> ) {
+        if ( !std::is_constant_evaluated() ) {
+            const auto& self  = static_cast<const Derived&>( *this );
+            const auto  count = self.size();
+
+            if ( count == 0 )
+                return std::optional<std::pair<output_t, output_t>>();
+
+            return std::optional<std::pair<output_t, output_t>>( simd_min_max( self.data(), count ) );
+        }
+    }
+#endif
+
+    auto first = true;
+    auto low   = output_t();
+    auto high  = output_t();
+
+    for_each( [&]( auto&& element ) {
+        if ( first ) {
+            low   = element;
+            high  = std::forward<decltype( element )>( element );
+            first = false;
+        }
+        else if ( element < low ) {
+            low = std::forward<decltype( element )>( element );
+        }
+        else if ( high < element ) {
+            high = std::forward<decltype( element )>( element );
+        }
+    } );
+
+    return first ? std::optional<std::pair<output_t, output_t>>()
+                 : std::optional<std::pair<output_t, output_t>>( std::make_pair( std::move( low ), std::move( high ) ) );
+}
+
+template <typename Derived, typename TOutput>
+template <typename... TAggregators>
+constexpr auto range<Derived, TOutput>::aggregate_all( TAggregators... ) const {
+    static_assert( sizeof...( TAggregators ) > 0, "aggregate_all() requires at least one aggregator." );
+
+    auto states = std::tuple<typename TAggregators::template state<output_t>...>();
+
+    for_each( [&states]( const auto& element ) {
+        std::apply( [&element]( auto&... state ) { ( state.add( element ), ... ); }, states );
+    } );
+
+    return std::apply( []( const auto&... state ) { return std::make_tuple( state.result()... ); }, states );
+}
+
 template <typename Derived, typename TOutput>
 constexpr auto range<Derived, TOutput>::average() const
 #ifdef __cpp_lib_concepts
@@ -2274,9 +7034,9 @@ constexpr auto range<Derived, TOutput>::aggregate( TSeed seed, TAccumFunc&& func
 
     auto result = std::move( seed );
 
-    for ( auto&& p : self_ref() ) {
-        result = std::invoke( func, std::move( result ), p );
-    }
+    for_each( [&]( auto&& element ) {
+        result = std::invoke( func, std::move( result ), element );
+    } );
 
     return result;
 }
@@ -2298,48 +7058,97 @@ constexpr auto range<Derived, TOutput>::reduce( const TAccumFunc& func ) const {
         "reduce() requires the range's output type to be move-constructible." );
 
     auto result = output_t();
+    auto first  = true;
 
-    for ( auto first = true; auto&& p : self_ref() ) {
+    for_each( [&]( auto&& element ) {
         if ( first ) {
-            result = std::move( p );
+            result = std::forward<decltype( element )>( element );
             first  = false;
         }
         else {
-            result = func( std::move( result ), p );
+            result = func( std::move( result ), element );
         }
-    }
+    } );
 
     return result;
 }
 
+#ifndef LINQ_NO_STL_CONTAINERS
+template <typename Derived, typename TOutput>
+template <typename TSeed, typename TAccumFunc, typename TCombineFunc>
+auto range<Derived, TOutput>::aggregate( TSeed seed, TAccumFunc&& accumulate, TCombineFunc&& combine ) const {
+    if constexpr ( partitionable_range<Derived> ) {
+        return as_parallel().aggregate( std::move( seed ), accumulate, combine );
+    }
+    else {
+        static_cast<void>( combine );
+        return aggregate( std::move( seed ), accumulate );
+    }
+}
+
+template <typename Derived, typename TOutput>
+template <typename TAccumFunc>
+auto range<Derived, TOutput>::reduce( parallel_tag tag, const TAccumFunc& func ) const {
+    if constexpr ( partitionable_range<Derived> ) {
+        return parallel_range_of( static_cast<const Derived&>( *this ), tag.executor ).reduce( func );
+    }
+    else {
+        return reduce( func );
+    }
+}
+#endif
+
 template <typename Derived, typename TOutput>
 constexpr auto range<Derived, TOutput>::first() const -> std::optional<output_t> {
-    for ( auto&& p : self_ref() )
-        return std::optional( std::move( p ) );
+    auto result = std::optional<output_t>();
 
-    return {};
+    for_each( [&]( auto&& element ) {
+        result.emplace( std::forward<decltype( element )>( element ) );
+        return false;
+    } );
+
+    return result;
 }
 
 template <typename Derived, typename TOutput>
 template <typename TPredicate>
 constexpr auto range<Derived, TOutput>::first( const TPredicate& predicate ) const -> std::optional<output_t> {
-    for ( auto&& p : self_ref() ) {
-        if ( std::invoke( predicate, p ) )
-            return std::optional( std::move( p ) );
-    }
+    auto result = std::optional<output_t>();
 
-    return {};
+    for_each( [&]( auto&& element ) {
+        if ( !std::invoke( predicate, element ) )
+            return true;
+
+        result.emplace( std::forward<decltype( element )>( element ) );
+        return false;
+    } );
+
+    return result;
 }
 
 template <typename Derived, typename TOutput>
 constexpr auto range<Derived, TOutput>::last() const -> std::optional<output_t> {
+    if constexpr ( bidirectional_range<Derived> ) {
+        // Step back from the end instead of enumerating the whole range.
+        const auto self  = self_ref();
+        const auto first = self.begin();
+        auto       pos   = self.end();
+
+        if ( first == pos )
+            return std::optional<output_t>();
+
+        --pos;
+
+        return std::optional<output_t>( *pos );
+    }
+
     auto have_any = false;
     auto result   = output_t();
 
-    for ( auto&& p : self_ref() ) {
-        result   = std::move( p );
+    for_each( [&]( auto&& element ) {
+        result   = std::forward<decltype( element )>( element );
         have_any = true;
-    }
+    } );
 
     return have_any ? std::optional( std::move( result ) ) : std::optional<output_t>();
 }
@@ -2347,15 +7156,29 @@ constexpr auto range<Derived, TOutput>::last() const -> std::optional<output_t>
 template <typename Derived, typename TOutput>
 template <typename TPredicate>
 constexpr auto range<Derived, TOutput>::last( const TPredicate& predicate ) const -> std::optional<output_t> {
+    if constexpr ( bidirectional_range<Derived> ) {
+        const auto self  = self_ref();
+        const auto first = self.begin();
+
+        for ( auto pos = self.end(); pos != first; ) {
+            --pos;
+
+            if ( std::invoke( predicate, *pos ) )
+                return std::optional<output_t>( *pos );
+        }
+
+        return std::optional<output_t>();
+    }
+
     bool     have_any = false;
     output_t ret{};
 
-    for ( const auto& p : static_cast<const Derived&>( *this ) ) {
-        if ( std::invoke( predicate, p ) ) {
-            ret      = p;
+    for_each( [&]( auto&& element ) {
+        if ( std::invoke( predicate, element ) ) {
+            ret      = std::forward<decltype( element )>( element );
             have_any = true;
         }
-    }
+    } );
 
     return have_any ? std::optional{ ret } : std::optional<output_t>{};
 }
@@ -2363,23 +7186,27 @@ constexpr auto range<Derived, TOutput>::last( const TPredicate& predicate ) cons
 template <typename Derived, typename TOutput>
 template <typename TPredicate>
 constexpr auto range<Derived, TOutput>::any( const TPredicate& predicate ) const -> bool {
-    for ( const auto& p : static_cast<const Derived&>( *this ) ) {
-        if ( std::invoke( predicate, p ) )
-            return true;
-    }
+    auto found = false;
 
-    return false;
+    for_each( [&]( const auto& element ) {
+        found = std::invoke( predicate, element );
+        return !found;
+    } );
+
+    return found;
 }
 
 template <typename Derived, typename TOutput>
 template <typename TPredicate>
 constexpr auto range<Derived, TOutput>::all( const TPredicate& predicate ) const -> bool {
-    for ( const auto& p : static_cast<const Derived&>( *this ) ) {
-        if ( !std::invoke( predicate, p ) )
-            return false;
-    }
+    auto all_match = true;
 
-    return true;
+    for_each( [&]( const auto& element ) {
+        all_match = std::invoke( predicate, element );
+        return all_match;
+    } );
+
+    return all_match;
 }
 
 template <typename Derived, typename TOutput>
@@ -2388,26 +7215,57 @@ constexpr bool range<Derived, TOutput>::none( const TPredicate& predicate ) cons
     bool any_elements = false;
     bool any_none     = false;
 
-    for ( const auto& p : static_cast<const Derived&>( *this ) ) {
+    for_each( [&]( const auto& element ) {
         any_elements = true;
-
-        if ( !std::invoke( predicate, p ) ) {
-            any_none = true;
-            break;
-        }
-    }
+        any_none     = !std::invoke( predicate, element );
+        return !any_none;
+    } );
 
     return !any_elements || any_none;
 }
 
+template <typename Derived, typename TOutput>
+constexpr auto range<Derived, TOutput>::size_hint() const -> linq::size_hint {
+    if constexpr ( has_fixed_size<Derived> ) {
+        return linq::size_hint::exact( static_cast<const Derived&>( *this ).size() );
+    }
+    else {
+        return linq::size_hint::unknown();
+    }
+}
+
 template <typename Derived, typename TOutput>
 constexpr auto range<Derived, TOutput>::count() const -> size_t {
+    const auto& self = static_cast<const Derived&>( *this );
+
+    if ( const auto hint = self.size_hint(); hint.is_exact() )
+        return hint.lower;
+
+    if constexpr ( random_access_range<Derived> ) {
+        const auto first = self.begin();
+        const auto last  = self.end();
+
+        return static_cast<size_t>( last - first );
+    }
+
     size_t ret{ 0 };
 
-    for ( const auto& p : static_cast<const Derived&>( *this ) ) {
-        std::ignore = p;
-        ++ret;
+#ifndef LINQ_NO_STL_CONTAINERS
+    if constexpr ( is_batched_range_v<Derived> ) {
+        self.push_batches(
+            [&ret]( const auto& batch ) {
+                ret += batch.count;
+                return true;
+            },
+            self.batch_size() );
+
+        return ret;
     }
+#endif
+
+    for_each( [&ret]( const auto& ) {
+        ++ret;
+    } );
 
     return ret;
 }
@@ -2417,10 +7275,10 @@ template <typename TPredicate>
 constexpr auto range<Derived, TOutput>::count( const TPredicate& predicate ) const -> size_t {
     size_t ret{ 0 };
 
-    for ( const auto& p : static_cast<const Derived&>( *this ) ) {
-        if ( std::invoke( predicate, p ) )
+    for_each( [&]( const auto& element ) {
+        if ( std::invoke( predicate, element ) )
             ++ret;
-    }
+    } );
 
     return ret;
 }
@@ -2428,17 +7286,31 @@ constexpr auto range<Derived, TOutput>::count( const TPredicate& predicate ) con
 template <typename Derived, typename TOutput>
 constexpr std::optional<typename range<Derived, TOutput>::output_t>
 range<Derived, TOutput>::element_at( size_t index ) const {
-    size_t i{ 0 };
+    if constexpr ( random_access_range<Derived> ) {
+        const auto& self = static_cast<const Derived&>( *this );
+        auto        pos  = self.begin();
+        const auto  last = self.end();
 
-    for ( const auto& p : static_cast<const Derived&>( *this ) ) {
-        if ( i >= index ) {
-            return std::optional{ p };
-        }
+        if ( index >= static_cast<size_t>( last - pos ) )
+            return {};
+
+        pos += static_cast<std::ptrdiff_t>( index );
 
-        ++i;
+        return std::optional<output_t>( *pos );
     }
 
-    return {};
+    auto   result = std::optional<output_t>();
+    size_t i{ 0 };
+
+    for_each( [&]( auto&& element ) {
+        if ( i++ < index )
+            return true;
+
+        result.emplace( std::forward<decltype( element )>( element ) );
+        return false;
+    } );
+
+    return result;
 }
 
 template <typename Derived, typename TOutput>
@@ -2478,15 +7350,42 @@ auto range<Derived, TOutput>::to_vector() const -> std::vector<output_t> {
 
     auto vec = std::vector<output_t>();
 
-    if constexpr ( has_fixed_size<Derived> )
-        vec.reserve( me.size() );
+    vec.reserve( me.size_hint().lower );
 
-    for ( auto&& p : static_cast<const Derived&>( *this ) )
-        vec.emplace_back( std::move( p ) );
+    if constexpr ( is_batched_range_v<Derived> ) {
+        me.push_batches(
+            [&vec]( const auto& batch ) {
+                if ( batch.selection == nullptr ) {
+                    vec.insert( vec.end(), batch.elements, batch.elements + batch.count );
+                }
+                else {
+                    for ( size_t i = 0; i < batch.count; ++i )
+                        vec.push_back( batch.elements[batch.selection[i]] );
+                }
+
+                return true;
+            },
+            me.batch_size() );
+    }
+    else {
+        for_each( [&vec]( auto&& element ) {
+            vec.emplace_back( std::forward<decltype( element )>( element ) );
+        } );
+    }
 
     return vec;
 }
 
+template <typename Derived, typename TOutput>
+auto range<Derived, TOutput>::to_vector( parallel_tag tag ) const -> std::vector<output_t> {
+    if constexpr ( partitionable_range<Derived> ) {
+        return parallel_range_of( static_cast<const Derived&>( *this ), tag.executor ).as_ordered().to_vector();
+    }
+    else {
+        return to_vector();
+    }
+}
+
 template <typename Derived, typename TOutput>
 auto range<Derived, TOutput>::to_map() const
 #ifdef __cpp_lib_concepts
@@ -2498,8 +7397,10 @@ auto range<Derived, TOutput>::to_map() const
 
     auto map = std::map<FirstType, SecondType>();
 
-    for ( auto&& [first, second] : static_cast<const Derived&>( *this ) )
-        map.emplace( std::move( first ), std::move( second ) );
+    for_each( [&map]( auto&& element ) {
+        using element_t = decltype( element );
+        map.emplace( std::forward<element_t>( element ).first, std::forward<element_t>( element ).second );
+    } );
 
     return map;
 }
@@ -2515,12 +7416,63 @@ auto range<Derived, TOutput>::to_unordered_map() const
 
     auto map = std::unordered_map<FirstType, SecondType>();
 
-    for ( auto&& [first, second] : static_cast<const Derived&>( *this ) )
-        map.emplace( std::move( first ), std::move( second ) );
+    map.reserve( static_cast<const Derived&>( *this ).size_hint().lower );
+
+    for_each( [&map]( auto&& element ) {
+        using element_t = decltype( element );
+        map.emplace( std::forward<element_t>( element ).first, std::forward<element_t>( element ).second );
+    } );
 
     return map;
 }
 
+template <typename Derived, typename TOutput>
+auto range<Derived, TOutput>::to_unordered_map( parallel_tag tag ) const
+#ifdef __cpp_lib_concepts
+    requires( has_first_and_second_type<output_t> )
+#endif
+{
+    if constexpr ( partitionable_range<Derived> ) {
+        return parallel_range_of( static_cast<const Derived&>( *this ), tag.executor ).to_unordered_map();
+    }
+    else {
+        return to_unordered_map();
+    }
+}
+
+template <typename Derived, typename TOutput>
+auto range<Derived, TOutput>::to_sharded_map() const
+#ifdef __cpp_lib_concepts
+    requires( has_first_and_second_type<output_t> )
+#endif
+{
+    if constexpr ( partitionable_range<Derived> ) {
+        return as_parallel().to_sharded_map();
+    }
+    else {
+        return sharded_map<typename output_t::first_type, typename output_t::second_type>( to_unordered_map() );
+    }
+}
+
+template <typename Derived, typename TOutput>
+template <typename TKeySelector>
+auto range<Derived, TOutput>::to_lookup( const TKeySelector& key_selector ) const {
+    auto result = lookup_t<Derived, TKeySelector>();
+    result.assign( self_ref(), key_selector );
+    return result;
+}
+
+template <typename Derived, typename TOutput>
+template <typename TKeySelector>
+auto range<Derived, TOutput>::to_lookup( parallel_tag tag, const TKeySelector& key_selector ) const {
+    if constexpr ( partitionable_range<Derived> ) {
+        return parallel_range_of( static_cast<const Derived&>( *this ), tag.executor ).to_lookup( key_selector );
+    }
+    else {
+        return to_lookup( key_selector );
+    }
+}
+
 #endif // LINQ_NO_STL_CONTAINERS
 } // end namespace details
 
@@ -2672,6 +7624,29 @@ static constexpr auto size = []( const auto& value ) {
 static constexpr auto self = []( auto&& value ) {
     return std::forward<decltype( value )>( value );
 };
+
+#ifndef LINQ_NO_STL_CONTAINERS
+/// Selects the parallel overload of an operation, e.g. range.reduce( linq::parallel, func ).
+static constexpr details::parallel_tag parallel{};
+#endif
+
+/// Aggregators for range::aggregate_all().
+namespace agg {
+/// The number of elements
+static constexpr details::count_aggregator count{};
+/// The sum of the elements, empty for an empty range
+static constexpr details::sum_aggregator sum{};
+/// The minimum element, empty for an empty range
+static constexpr details::min_aggregator min{};
+/// The maximum element, empty for an empty range
+static constexpr details::max_aggregator max{};
+/// The arithmetic mean as a long double, empty for an empty range
+static constexpr details::mean_aggregator mean{};
+/// The population variance as a long double, empty for an empty range
+static constexpr details::variance_aggregator variance{};
+/// The population standard deviation as a long double, empty for an empty range
+static constexpr details::stddev_aggregator stddev{};
+} // namespace agg
 } // end namespace linq
 
 #endif
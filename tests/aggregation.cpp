@@ -1,4 +1,6 @@
 #include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <limits>
 #include <linq.hpp>
 
 using namespace std::string_literals;
@@ -256,3 +258,196 @@ TEST_CASE( "sum" ) {
     const auto sum     = linq::from( &numbers ).sum();
     REQUIRE( sum.value() == 10 );
 }
+
+TEST_CASE( "sum/min/max of contiguous ranges" ) {
+    // where() hides the contiguous source and makes the range reduce element by element.
+    const auto scalar = []( const auto& container ) {
+        return linq::from( &container ).where( []( const auto& ) {
+            return true;
+        } );
+    };
+
+    const auto check = [&]( const auto& container ) {
+        const auto query = linq::from( &container );
+
+        REQUIRE( query.sum() == scalar( container ).sum() );
+        REQUIRE( query.min() == scalar( container ).min() );
+        REQUIRE( query.max() == scalar( container ).max() );
+        REQUIRE( query.sum_and_count() == scalar( container ).sum_and_count() );
+        REQUIRE( query.min_max() == scalar( container ).min_max() );
+        REQUIRE( query.min_max() == std::make_pair( query.min().value(), query.max().value() ) );
+    };
+
+    for ( const size_t size : { 1, 2, 31, 32, 33, 100, 1000 } ) {
+        auto ints    = std::vector<int>( size );
+        auto int64s  = std::vector<int64_t>( size );
+        auto uint16s = std::vector<uint16_t>( size );
+        auto floats  = std::vector<float>( size );
+        auto doubles = std::vector<double>( size );
+
+        for ( size_t i = 0; i < size; ++i ) {
+            const auto value = static_cast<int>( ( i * 7919 ) % 1000 ) - 500;
+
+            ints[i]    = value;
+            int64s[i]  = int64_t( value ) << 32;
+            uint16s[i] = static_cast<uint16_t>( value );
+            floats[i]  = static_cast<float>( value ) / 4;
+            doubles[i] = static_cast<double>( value ) / 8;
+        }
+
+        check( ints );
+        check( int64s );
+        check( uint16s );
+        check( floats );
+        check( doubles );
+    }
+
+    SECTION( "empty" ) {
+        const auto empty = std::vector<double>();
+
+        REQUIRE( !linq::from( &empty ).sum().has_value() );
+        REQUIRE( !linq::from( &empty ).min().has_value() );
+        REQUIRE( !linq::from( &empty ).sum_and_count().has_value() );
+        REQUIRE( !linq::from( &empty ).min_max().has_value() );
+    }
+
+    SECTION( "integer sums wrap around like the element type" ) {
+        const auto bytes = std::vector<int8_t>( 1000, 100 );
+
+        REQUIRE( linq::from( &bytes ).sum() == static_cast<int8_t>( 100'000 ) );
+        REQUIRE( linq::from( &bytes ).sum() == scalar( bytes ).sum() );
+    }
+
+    SECTION( "NaN" ) {
+        const auto nan = std::numeric_limits<float>::quiet_NaN();
+
+        auto values = std::vector<float>( 100 );
+
+        for ( size_t i = 0; i < values.size(); ++i )
+            values[i] = static_cast<float>( i );
+
+        values[70] = nan;
+
+        // NaNs after the first element are ignored.
+        REQUIRE( linq::from( &values ).min() == 0.0f );
+        REQUIRE( linq::from( &values ).max() == 99.0f );
+
+        // A leading NaN is the result.
+        values[0] = nan;
+
+        REQUIRE( std::isnan( linq::from( &values ).min().value() ) );
+        REQUIRE( std::isnan( linq::from( &values ).max().value() ) );
+        REQUIRE( std::isnan( scalar( values ).max().value() ) );
+    }
+}
+
+TEST_CASE( "min_max" ) {
+    SECTION( "constexpr" ) {
+        constexpr auto numbers = std::array{ 3, 1, 4, 1, 5, 9, 2, 6 };
+        constexpr auto result  = linq::from( &numbers ).min_max();
+
+        STATIC_REQUIRE( result.has_value() );
+        STATIC_REQUIRE( result->first == 1 );
+        STATIC_REQUIRE( result->second == 9 );
+    }
+
+    SECTION( "single element" ) {
+        const auto numbers = std::vector{ 42 };
+        REQUIRE( linq::from( &numbers ).min_max() == std::make_pair( 42, 42 ) );
+    }
+
+    SECTION( "strings" ) {
+        const auto words  = std::vector{ "pear"s, "apple"s, "zucchini"s, "melon"s };
+        const auto result = linq::from( &words ).min_max();
+
+        REQUIRE( result == std::make_pair( "apple"s, "zucchini"s ) );
+    }
+
+    SECTION( "single pass" ) {
+        const auto numbers = std::vector{ 5, 3, 8, 1 };
+        auto       calls   = 0;
+
+        const auto result = linq::from( &numbers )
+                                .select( [&calls]( int i ) {
+                                    ++calls;
+                                    return i;
+                                } )
+                                .min_max();
+
+        REQUIRE( result == std::make_pair( 1, 8 ) );
+        REQUIRE( calls == 4 );
+    }
+}
+
+TEST_CASE( "aggregate_all" ) {
+    SECTION( "matches the separate aggregates" ) {
+        const auto numbers = std::vector{ 2, 4, 4, 4, 5, 5, 7, 9 };
+
+        const auto [count, sum, min, max, mean, variance, stddev] = linq::from( &numbers ).aggregate_all(
+            linq::agg::count,
+            linq::agg::sum,
+            linq::agg::min,
+            linq::agg::max,
+            linq::agg::mean,
+            linq::agg::variance,
+            linq::agg::stddev );
+
+        STATIC_REQUIRE( std::is_same_v<std::remove_cvref_t<decltype( count )>, size_t> );
+        STATIC_REQUIRE( std::is_same_v<std::remove_cvref_t<decltype( min )>, std::optional<int>> );
+        STATIC_REQUIRE( std::is_same_v<std::remove_cvref_t<decltype( mean )>, std::optional<long double>> );
+
+        REQUIRE( count == linq::from( &numbers ).count() );
+        REQUIRE( sum == linq::from( &numbers ).sum() );
+        REQUIRE( min == linq::from( &numbers ).min() );
+        REQUIRE( max == linq::from( &numbers ).max() );
+        REQUIRE( mean == 5.0L );
+        REQUIRE( variance == 4.0L );
+        REQUIRE( stddev == 2.0L );
+    }
+
+    SECTION( "constexpr" ) {
+        constexpr auto numbers = std::array{ 1.0, 2.0, 3.0 };
+        constexpr auto result  = linq::from( &numbers ).aggregate_all( linq::agg::min, linq::agg::mean );
+
+        STATIC_REQUIRE( std::get<0>( result ) == 1.0 );
+        STATIC_REQUIRE( std::get<1>( result ) == 2.0L );
+    }
+
+    SECTION( "empty" ) {
+        const auto empty = std::vector<int>();
+
+        const auto [count, min, mean, variance] = linq::from( &empty ).aggregate_all(
+            linq::agg::count, linq::agg::min, linq::agg::mean, linq::agg::variance );
+
+        REQUIRE( count == 0 );
+        REQUIRE( !min.has_value() );
+        REQUIRE( !mean.has_value() );
+        REQUIRE( !variance.has_value() );
+    }
+
+    SECTION( "single pass" ) {
+        const auto numbers = std::vector{ 1, 2, 3, 4, 5 };
+        auto       calls   = 0;
+
+        const auto query = linq::from( &numbers ).select( [&calls]( int i ) {
+            ++calls;
+            return i * 10;
+        } );
+
+        const auto [min, max, mean] = query.aggregate_all( linq::agg::min, linq::agg::max, linq::agg::mean );
+
+        REQUIRE( min == 10 );
+        REQUIRE( max == 50 );
+        REQUIRE( mean == 30.0L );
+        REQUIRE( calls == 5 );
+    }
+
+    SECTION( "variance is stable for large offsets" ) {
+        const auto numbers = std::vector{ 1e9 + 4, 1e9 + 7, 1e9 + 13, 1e9 + 16 };
+
+        const auto [mean, variance] = linq::from( &numbers ).aggregate_all( linq::agg::mean, linq::agg::variance );
+
+        REQUIRE( std::fabs( static_cast<double>( *mean ) - ( 1e9 + 10 ) ) < 1e-6 );
+        REQUIRE( std::fabs( static_cast<double>( *variance ) - 22.5 ) < 1e-6 );
+    }
+}
@@ -1,5 +1,6 @@
 #include "datatypes.hpp"
 #include <catch2/catch_test_macros.hpp>
+#include <limits>
 #include <linq.hpp>
 
 static const auto general_people = std::vector<person>{
@@ -198,3 +199,319 @@ TEST_CASE( "from(initializer_list)" ) {
     REQUIRE( lines.at( 1 ) == "2" );
     REQUIRE( lines.at( 2 ) == "3" );
 }
+
+TEST_CASE( "size_hint" ) {
+    const auto numbers = std::vector{ 1, 2, 3, 4, 5, 6, 7, 8 };
+    const auto others  = std::list{ 9, 10 };
+    const auto is_odd  = []( int i ) {
+        return i % 2 == 1;
+    };
+
+    const auto hint_of = []( const auto& range ) {
+        const auto hint = range.size_hint();
+        return std::pair( hint.lower, hint.upper );
+    };
+
+    const auto exact = []( size_t count ) {
+        return std::pair( count, std::optional<size_t>( count ) );
+    };
+
+    const auto at_most = []( size_t count ) {
+        return std::pair( size_t( 0 ), std::optional<size_t>( count ) );
+    };
+
+    const auto query = linq::from( &numbers );
+
+    REQUIRE( hint_of( query ) == exact( 8 ) );
+    REQUIRE( hint_of( query.where( is_odd ) ) == at_most( 8 ) );
+    REQUIRE( hint_of( query.where( is_odd ).select( linq::self ) ) == at_most( 8 ) );
+    REQUIRE( hint_of( query.take( 3 ) ) == exact( 3 ) );
+    REQUIRE( hint_of( query.take( 30 ) ) == exact( 8 ) );
+    REQUIRE( hint_of( query.skip( 3 ) ) == exact( 5 ) );
+    REQUIRE( hint_of( query.skip( 30 ) ) == exact( 0 ) );
+    REQUIRE( hint_of( query.where( is_odd ).take( 3 ) ) == at_most( 3 ) );
+    REQUIRE( hint_of( query.append( linq::from( &others ) ) ) == exact( 10 ) );
+    REQUIRE( hint_of( query.repeat( 2 ) ) == exact( 24 ) );
+    REQUIRE( hint_of( query.reverse() ) == exact( 8 ) );
+    REQUIRE( hint_of( query.order_by_ascending( linq::self ) ) == exact( 8 ) );
+    REQUIRE( hint_of( query.distinct() ) == std::pair( size_t( 1 ), std::optional<size_t>( 8 ) ) );
+
+    const auto generated = linq::generate( []( const size_t iteration ) {
+        if ( iteration < 3 ) {
+            return linq::generate_return( iteration * 2 );
+        }
+
+        return linq::generate_finish<size_t>();
+    } );
+
+    REQUIRE( hint_of( generated ) == std::pair( size_t( 0 ), std::optional<size_t>() ) );
+    REQUIRE( hint_of( generated.take( 2 ) ) == std::pair( size_t( 0 ), std::optional<size_t>() ) );
+
+    SECTION( "take().size() is limited by the source" ) {
+        REQUIRE( query.take( 30 ).size() == 8 );
+        REQUIRE( query.take( 30 ).count() == 8 );
+    }
+
+    SECTION( "to_vector() reserves the lower bound" ) {
+        REQUIRE( query.select( linq::self ).to_vector().capacity() == 8 );
+
+        // The upper bound of a filtered, repeated range is far larger than the number of matches.
+        const auto eights = query.repeat( 9'999 ).where( []( int i ) {
+            return i == 8;
+        } );
+
+        REQUIRE( hint_of( eights ) == at_most( 80'000 ) );
+
+        const auto matches = eights.to_vector();
+
+        REQUIRE( matches.size() == 10'000 );
+        REQUIRE( matches.capacity() < 80'000 );
+    }
+
+    SECTION( "overflowing counts are unbounded" ) {
+        const auto huge      = query.repeat( std::numeric_limits<size_t>::max() / 4 );
+        const auto unbounded = std::pair( std::numeric_limits<size_t>::max(), std::optional<size_t>() );
+
+        REQUIRE( hint_of( huge ) == unbounded );
+        REQUIRE( hint_of( huge.append( query ) ) == unbounded );
+        REQUIRE( !huge.size_hint().is_exact() );
+        REQUIRE( huge.take( 5 ).count() == 5 );
+    }
+}
+
+TEST_CASE( "for_each" ) {
+    const auto numbers = std::vector{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    const auto others  = std::list{ 11, 12 };
+
+    // Collects the elements of a range by pulling them through its iterators.
+    const auto pulled = []( const auto& range ) {
+        auto result = std::vector<int>();
+
+        for ( const auto& element : range )
+            result.push_back( element );
+
+        return result;
+    };
+
+    // Collects the elements of a range by pushing them through its stages.
+    const auto pushed = []( const auto& range ) {
+        auto result = std::vector<int>();
+
+        range.for_each( [&result]( int element ) {
+            result.push_back( element );
+        } );
+
+        return result;
+    };
+
+    const auto is_even = []( int i ) {
+        return i % 2 == 0;
+    };
+
+    const auto below_five = []( int i ) {
+        return i < 5;
+    };
+
+    const auto query = linq::from( &numbers );
+
+    SECTION( "matches iteration" ) {
+        const auto chain = query.where( is_even )
+                               .select( []( int i ) {
+                                   return i * 3;
+                               } )
+                               .skip( 1 )
+                               .take( 3 )
+                               .append( linq::from( &others ) );
+
+        REQUIRE( pushed( chain ) == std::vector{ 12, 18, 24, 11, 12 } );
+        REQUIRE( pushed( chain ) == pulled( chain ) );
+
+        REQUIRE( pushed( query.take( 0 ) ).empty() );
+        REQUIRE( pushed( query.take( 20 ) ) == pulled( query.take( 20 ) ) );
+        REQUIRE( pushed( query.skip( 20 ) ).empty() );
+        REQUIRE( pushed( query.take_while( below_five ) ) == pulled( query.take_while( below_five ) ) );
+        REQUIRE( pushed( query.skip_while( below_five ) ) == pulled( query.skip_while( below_five ) ) );
+        REQUIRE( pushed( query.take( 2 ).repeat( 2 ) ) == std::vector{ 1, 2, 1, 2, 1, 2 } );
+        REQUIRE( pushed( query.where( []( int i ) { return i > 10; } ).repeat( 3 ) ).empty() );
+        REQUIRE( pushed( linq::from( &others ).skip( 1 ) ) == std::vector{ 12 } );
+    }
+
+    SECTION( "stopping early" ) {
+        auto visited = std::vector<int>();
+
+        query.append( linq::from( &others ) ).repeat( 2 ).for_each( [&visited]( int element ) {
+            visited.push_back( element );
+            return element < 4;
+        } );
+
+        REQUIRE( visited == std::vector{ 1, 2, 3, 4 } );
+
+        // take() stops an endless source once it has produced enough elements.
+        const auto endless = linq::generate( []( const size_t iteration ) {
+            return linq::generate_return( iteration * 2 );
+        } );
+
+        REQUIRE( endless.take( 3 ).to_vector() == std::vector<size_t>{ 0, 2, 4 } );
+        REQUIRE( endless.skip( 2 ).first() == size_t( 4 ) );
+        REQUIRE( endless.any( []( size_t i ) { return i == 100; } ) );
+    }
+
+    SECTION( "mutable elements" ) {
+        auto values = std::vector{ 1, 2, 3 };
+
+        linq::from_mutable( &values ).for_each( []( int& element ) {
+            element *= 10;
+        } );
+
+        REQUIRE( values == std::vector{ 10, 20, 30 } );
+
+        // Materializing copies elements of mutable containers instead of moving them out.
+        auto names = std::vector<std::string>{ "a", "b" };
+
+        REQUIRE( linq::from_mutable( &names ).to_vector() == names );
+        REQUIRE( names == std::vector<std::string>{ "a", "b" } );
+    }
+}
+
+TEST_CASE( "batched" ) {
+    auto numbers = std::vector<int>( 100 );
+
+    for ( size_t i = 0; i < numbers.size(); ++i )
+        numbers[i] = static_cast<int>( i );
+
+    const auto is_odd = []( int i ) {
+        return i % 2 == 1;
+    };
+
+    const auto square = []( int i ) {
+        return i * i;
+    };
+
+    const auto query = linq::from( &numbers ).where( is_odd ).select( square ).skip( 4 ).take( 20 );
+
+    SECTION( "matches unbatched execution" ) {
+        for ( const size_t batch_size : { 1, 3, 7, 1024 } ) {
+            const auto batched = query.batched( batch_size );
+
+            REQUIRE( batched.to_vector() == query.to_vector() );
+            REQUIRE( batched.count() == 20 );
+            REQUIRE( batched.sum() == query.sum() );
+            REQUIRE( batched.where( is_odd ).to_vector() == query.where( is_odd ).to_vector() );
+            REQUIRE( linq::from( &numbers ).batched( batch_size ).skip( 98 ).to_vector() == std::vector{ 98, 99 } );
+            REQUIRE( linq::from( &numbers ).batched( batch_size ).take( 0 ).count() == 0 );
+        }
+    }
+
+    SECTION( "enumerating directly" ) {
+        auto elements = std::vector<int>();
+
+        for ( const auto element : query.batched() )
+            elements.push_back( element );
+
+        REQUIRE( elements == query.to_vector() );
+    }
+
+    SECTION( "stopping early" ) {
+        auto visited = std::vector<int>();
+
+        query.batched( 4 ).for_each( [&visited]( int element ) {
+            visited.push_back( element );
+            return visited.size() < 5;
+        } );
+
+        REQUIRE( visited == std::vector{ 81, 121, 169, 225, 289 } );
+        REQUIRE( query.batched( 4 ).first() == 81 );
+        REQUIRE( query.batched( 4 ).any( []( int i ) { return i == 289; } ) );
+    }
+
+    SECTION( "sources and stages without batch support" ) {
+        const auto list = std::list<int>( numbers.begin(), numbers.end() );
+
+        REQUIRE( linq::from( &list ).where( is_odd ).batched( 8 ).to_vector() ==
+                 linq::from( &numbers ).where( is_odd ).to_vector() );
+
+        REQUIRE( linq::from( &numbers ).reverse().take( 3 ).batched( 2 ).to_vector() == std::vector{ 99, 98, 97 } );
+
+        const auto names = linq::from( &numbers ).take( 3 ).select( []( int i ) {
+            return person{ .name = std::to_string( i ), .age = i };
+        } );
+
+        REQUIRE( names.batched( 2 ).count() == 3 );
+        REQUIRE( names.batched( 2 ).last()->name == "2" );
+    }
+}
+
+TEST_CASE( "cache" ) {
+    auto numbers     = std::vector<int>{ 5, 3, 8, 1, 9, 2 };
+    auto evaluations = 0;
+
+    const auto squared = linq::from( &numbers ).select( [&evaluations]( int i ) {
+        ++evaluations;
+        return i * i;
+    } );
+
+    SECTION( "enumerates the source once" ) {
+        const auto cached = squared.cache();
+
+        REQUIRE( evaluations == 0 );
+        REQUIRE( cached.count() == 6 );
+        REQUIRE( cached.size() == 6 );
+        REQUIRE( cached.to_vector() == std::vector{ 25, 9, 64, 1, 81, 4 } );
+        REQUIRE( cached.element_at( 2 ) == 64 );
+        REQUIRE( !cached.element_at( 6 ).has_value() );
+        REQUIRE( cached.sum() == 184 );
+        REQUIRE( cached.data()[4] == 81 );
+
+        auto elements = std::vector<int>();
+
+        for ( const auto element : cached )
+            elements.push_back( element );
+
+        REQUIRE( elements == cached.to_vector() );
+
+        // Subsequent operators share the cache.
+        REQUIRE( cached.where( []( int i ) { return i > 10; } ).count() == 3 );
+        REQUIRE( cached.reverse().first() == 4 );
+        REQUIRE( evaluations == 6 );
+    }
+
+    SECTION( "invalidate" ) {
+        const auto cached = squared.cache();
+
+        REQUIRE( cached.max() == 81 );
+
+        numbers.push_back( 10 );
+
+        REQUIRE( cached.max() == 81 );
+
+        cached.invalidate();
+
+        REQUIRE( cached.max() == 100 );
+        REQUIRE( cached.count() == 7 );
+        REQUIRE( evaluations == 13 );
+    }
+
+    SECTION( "sorting once" ) {
+        auto key_evaluations = 0;
+
+        const auto sorted = linq::from( &numbers )
+                                .order_by_ascending( [&key_evaluations]( int i ) {
+                                    ++key_evaluations;
+                                    return i;
+                                } )
+                                .cache();
+
+        REQUIRE( sorted.to_vector() == std::vector{ 1, 2, 3, 5, 8, 9 } );
+        REQUIRE( sorted.first() == 1 );
+        REQUIRE( sorted.last() == 9 );
+        REQUIRE( key_evaluations == 6 );
+    }
+
+    SECTION( "empty ranges" ) {
+        const auto empty = linq::from( &numbers ).where( []( int i ) { return i > 100; } ).cache();
+
+        REQUIRE( empty.count() == 0 );
+        REQUIRE( !empty.first().has_value() );
+        REQUIRE( empty.to_vector().empty() );
+    }
+}
@@ -35,3 +35,27 @@ TEST_CASE( "last" ) {
     STATIC_REQUIRE( num1.value() == 4 );
     STATIC_REQUIRE( num2.value() == 2 );
 }
+
+TEST_CASE( "last of filtered ranges" ) {
+    const auto numbers = std::vector{ 1, 2, 3, 4, 5 };
+
+    const auto odd = linq::from( &numbers ).where( []( int i ) {
+        return i % 2 == 1;
+    } );
+
+    REQUIRE( odd.last() == 5 );
+    REQUIRE( odd.last( []( int i ) { return i < 5; } ) == 3 );
+    REQUIRE( odd.last( []( int i ) { return i > 5; } ).has_value() == false );
+
+    const auto none = linq::from( &numbers ).where( []( int i ) {
+        return i > 5;
+    } );
+
+    REQUIRE( none.last().has_value() == false );
+
+    const auto squares = linq::from( &numbers ).select( []( int i ) {
+        return i * i;
+    } );
+
+    REQUIRE( squares.last() == 25 );
+}
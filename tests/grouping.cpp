@@ -0,0 +1,173 @@
+#include "datatypes.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <linq.hpp>
+
+using namespace std::string_literals;
+
+TEST_CASE( "group_by" ) {
+    const auto words = std::vector{ "apple"s, "bob"s, "avocado"s, "cat"s, "banana"s, "cherry"s, "axe"s };
+
+    const auto query = linq::from( &words ).group_by( []( const std::string& word ) {
+        return word.front();
+    } );
+
+    SECTION( "groups in order of first occurrence" ) {
+        const auto keys = query
+                              .select( []( const auto& group ) {
+                                  return group.key();
+                              } )
+                              .to_vector();
+
+        REQUIRE( keys == std::vector{ 'a', 'b', 'c' } );
+    }
+
+    SECTION( "elements keep their order" ) {
+        auto groups = std::vector<std::vector<std::string>>();
+
+        for ( const auto& group : query )
+            groups.push_back( group.to_vector() );
+
+        REQUIRE( groups.size() == 3 );
+        REQUIRE( groups.at( 0 ) == std::vector{ "apple"s, "avocado"s, "axe"s } );
+        REQUIRE( groups.at( 1 ) == std::vector{ "bob"s, "banana"s } );
+        REQUIRE( groups.at( 2 ) == std::vector{ "cat"s, "cherry"s } );
+    }
+
+    SECTION( "groups are ranges" ) {
+        const auto sizes = query
+                               .select( []( const auto& group ) {
+                                   return group.select( linq::size ).sum().value_or( 0 );
+                               } )
+                               .to_vector();
+
+        REQUIRE( sizes == std::vector<size_t>{ 15, 9, 9 } );
+    }
+
+    SECTION( "empty range" ) {
+        const auto empty = std::vector<std::string>();
+        REQUIRE( linq::from( &empty ).group_by( linq::size ).count() == 0 );
+    }
+}
+
+TEST_CASE( "to_lookup" ) {
+    auto numbers = std::vector<int>();
+
+    for ( int i = 0; i < 10'000; ++i )
+        numbers.push_back( ( i * 37 ) % 1000 );
+
+    const auto lookup = linq::from( &numbers ).to_lookup( []( int n ) {
+        return n % 100;
+    } );
+
+    REQUIRE( lookup.size() == 100 );
+    REQUIRE( lookup.contains( 42 ) );
+    REQUIRE_FALSE( lookup.contains( 100 ) );
+    REQUIRE( lookup[42].size() == 100 );
+    REQUIRE( lookup[42].key() == 42 );
+    REQUIRE( lookup[42].all( []( int n ) {
+        return n % 100 == 42;
+    } ) );
+    REQUIRE( lookup[100].size() == 0 );
+
+    // Elements within a group keep their original order.
+    const auto expected = linq::from( &numbers )
+                              .where( []( int n ) {
+                                  return n % 100 == 7;
+                              } )
+                              .to_vector();
+
+    REQUIRE( lookup[7].to_vector() == expected );
+
+    const auto total = lookup
+                           .select( []( const auto& group ) {
+                               return group.size();
+                           } )
+                           .sum();
+
+    REQUIRE( total == numbers.size() );
+}
+
+TEST_CASE( "to_lookup missing key owns its key" ) {
+    const auto words  = std::vector{ "apple"s, "bob"s, "avocado"s };
+    const auto lookup = linq::from( &words ).to_lookup( []( const std::string& word ) {
+        return word.substr( 0, 1 );
+    } );
+
+    // The key argument is a temporary that is destroyed before key() is called.
+    const auto group = lookup[std::string( "zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz" )];
+
+    REQUIRE( group.size() == 0 );
+    REQUIRE( group.key() == "zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz" );
+    REQUIRE( lookup[std::string( "zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz" )].key() == "zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz" );
+    REQUIRE( lookup["a"s].key() == "a" );
+}
+
+TEST_CASE( "aggregate_by" ) {
+    const auto people = std::vector<person>{
+        { .name = "P1", .age = 20 },
+        { .name = "P2", .age = 30 },
+        { .name = "P1", .age = 22 },
+        { .name = "P3", .age = 40 },
+        { .name = "P2", .age = 31 },
+    };
+
+    const auto result = linq::from( &people )
+                            .aggregate_by(
+                                []( const person& p ) {
+                                    return p.name;
+                                },
+                                0,
+                                []( int sum, const person& p ) {
+                                    return sum + p.age;
+                                } )
+                            .to_vector();
+
+    REQUIRE( result.size() == 3 );
+    REQUIRE( result.at( 0 ) == std::pair{ "P1"s, 42 } );
+    REQUIRE( result.at( 1 ) == std::pair{ "P2"s, 61 } );
+    REQUIRE( result.at( 2 ) == std::pair{ "P3"s, 40 } );
+}
+
+TEST_CASE( "reduce_by" ) {
+    const auto numbers = std::vector{ 5, 12, 3, 17, 8, 11, 4 };
+
+    const auto is_even = []( int n ) {
+        return n % 2 == 0;
+    };
+
+    const auto min_by_parity = linq::from( &numbers )
+                                   .reduce_by(
+                                       is_even,
+                                       []( int a, int b ) {
+                                           return std::min( a, b );
+                                       } )
+                                   .to_map();
+
+    const auto max_by_parity = linq::from( &numbers )
+                                   .reduce_by(
+                                       is_even,
+                                       []( int a, int b ) {
+                                           return std::max( a, b );
+                                       } )
+                                   .to_map();
+
+    REQUIRE( min_by_parity == std::map<bool, int>{ { false, 3 }, { true, 4 } } );
+    REQUIRE( max_by_parity == std::map<bool, int>{ { false, 17 }, { true, 12 } } );
+}
+
+TEST_CASE( "count_by" ) {
+    auto numbers = std::vector<int>();
+
+    for ( int i = 0; i < 10'000; ++i )
+        numbers.push_back( i % 7 );
+
+    const auto counts = linq::from( &numbers )
+                            .count_by( []( int n ) {
+                                return n;
+                            } )
+                            .to_vector();
+
+    REQUIRE( counts.size() == 7 );
+    REQUIRE( counts.front() == std::pair<int, size_t>{ 0, 1429 } );
+    REQUIRE( counts.back() == std::pair<int, size_t>{ 6, 1428 } );
+}
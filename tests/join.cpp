@@ -31,4 +31,134 @@ TEST_CASE( "join" ) {
                                     };
                                 } )
                             .to_vector();
+
+    REQUIRE( result.size() == 3 );
+    REQUIRE( result.at( 0 ).name == "P1P1" );
+    REQUIRE( result.at( 0 ).age == 42 );
+    REQUIRE( result.at( 1 ).name == "P1P1" );
+    REQUIRE( result.at( 1 ).age == 46 );
+    REQUIRE( result.at( 2 ).name == "P3P3" );
+    REQUIRE( result.at( 2 ).age == 45 );
+}
+
+TEST_CASE( "join without std::hash" ) {
+    struct key {
+        int value{};
+
+        bool operator==( const key& ) const = default;
+    };
+
+    const auto numbers1 = std::vector{ 1, 2, 3, 4 };
+    const auto numbers2 = std::vector{ 4, 2, 2, 5 };
+
+    const auto result = linq::from( &numbers1 )
+                            .join(
+                                linq::from( &numbers2 ),
+                                []( int n ) {
+                                    return key{ n };
+                                },
+                                []( int n ) {
+                                    return key{ n };
+                                },
+                                []( int a, int b ) {
+                                    return a * 10 + b;
+                                } )
+                            .to_vector();
+
+    REQUIRE( result == std::vector{ 22, 22, 44 } );
+}
+
+TEST_CASE( "join enumerated twice" ) {
+    const auto ids    = std::vector{ 3, 1, 2, 1 };
+    const auto values = std::vector<std::pair<int, char>>{ { 1, 'a' }, { 2, 'b' }, { 1, 'c' } };
+
+    const auto query = linq::from( &ids ).join(
+        linq::from( &values ),
+        linq::self,
+        []( const std::pair<int, char>& p ) {
+            return p.first;
+        },
+        []( int, const std::pair<int, char>& p ) {
+            return p.second;
+        } );
+
+    REQUIRE( query.to_vector() == std::vector{ 'a', 'c', 'b', 'a', 'c' } );
+    REQUIRE( query.to_vector() == std::vector{ 'a', 'c', 'b', 'a', 'c' } );
+}
+
+TEST_CASE( "join_sorted" ) {
+    SECTION( "matches join" ) {
+        const auto numbers1 = std::vector{ 1, 2, 2, 3, 5, 5, 5, 8 };
+        const auto numbers2 = std::vector{ 0, 2, 2, 2, 4, 5, 8, 8, 9 };
+
+        const auto key     = linq::self;
+        const auto combine = []( int a, int b ) {
+            return std::make_pair( a, b );
+        };
+
+        const auto expected =
+            linq::from( &numbers1 ).join( linq::from( &numbers2 ), key, key, combine ).to_vector();
+
+        const auto result =
+            linq::from( &numbers1 ).join_sorted( linq::from( &numbers2 ), key, key, combine ).to_vector();
+
+        REQUIRE( result.size() == 11 );
+        REQUIRE( result == expected );
+    }
+
+    SECTION( "with different element types" ) {
+        const auto people = std::vector<person>{
+            { .name = "P1", .age = 20 },
+            { .name = "P2", .age = 21 },
+            { .name = "P3", .age = 21 },
+            { .name = "P4", .age = 30 },
+        };
+
+        const auto ages = std::vector{ 19, 21, 30, 30 };
+
+        const auto result = linq::from( &people )
+                                .join_sorted(
+                                    linq::from( &ages ),
+                                    []( const person& p ) {
+                                        return p.age;
+                                    },
+                                    linq::self,
+                                    []( const person& p, int ) {
+                                        return p.name;
+                                    } )
+                                .to_vector();
+
+        REQUIRE( result == std::vector<std::string>{ "P2", "P3", "P4", "P4" } );
+    }
+
+    SECTION( "without matches" ) {
+        const auto numbers1 = std::vector{ 1, 3, 5 };
+        const auto numbers2 = std::vector{ 2, 4, 6 };
+
+        const auto count = linq::from( &numbers1 )
+                               .join_sorted( linq::from( &numbers2 ), linq::self, linq::self, std::plus() )
+                               .count();
+
+        REQUIRE( count == 0 );
+    }
+
+    SECTION( "sorts an ordered range once per enumeration" ) {
+        const auto numbers1 = std::vector{ 1, 2, 3 };
+        const auto numbers2 = std::vector{ 3, 1, 2 };
+
+        auto key_calls = 0;
+
+        const auto sorted = linq::from( &numbers2 ).order_by_ascending( [&key_calls]( int n ) {
+            ++key_calls;
+            return n;
+        } );
+
+        const auto query = linq::from( &numbers1 ).join_sorted( sorted, linq::self, linq::self, std::plus() );
+
+        REQUIRE( query.to_vector() == std::vector{ 2, 4, 6 } );
+        REQUIRE( key_calls == 3 );
+
+        REQUIRE( query.count() == 3 );
+        REQUIRE( key_calls == 6 );
+    }
 }
@@ -0,0 +1,505 @@
+#include <algorithm>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <functional>
+#include <linq.hpp>
+#include <numeric>
+#include <string>
+#include <thread>
+
+using namespace std::string_literals;
+
+TEST_CASE( "as_parallel with small ranges" ) {
+    const auto numbers = std::vector{ 1, 2, 3, 4, 5 };
+    const auto empty   = std::vector<int>();
+
+    REQUIRE( linq::from( &numbers ).as_parallel().sum() == 15 );
+    REQUIRE( linq::from( &numbers ).as_parallel().as_ordered().to_vector() == numbers );
+    REQUIRE( !linq::from( &empty ).as_parallel().sum().has_value() );
+    REQUIRE( !linq::from( &empty ).as_parallel().any( []( int ) {
+        return true;
+    } ) );
+    REQUIRE( linq::from( &empty ).as_parallel().aggregate( 0, std::plus() ) == 0 );
+    REQUIRE( linq::from_to( 7, 7 ).as_parallel().to_vector() == std::vector{ 7 } );
+
+    // Cached ranges are split like containers.
+    const auto cached = linq::from( &numbers )
+                             .where( []( int i ) {
+                                 return i > 1;
+                             } )
+                             .cache();
+
+    REQUIRE( cached.as_parallel().sum() == 14 );
+    REQUIRE( cached.to_vector( linq::parallel ) == std::vector{ 2, 3, 4, 5 } );
+}
+
+TEST_CASE( "aggregate with a combine function" ) {
+    const auto words = std::vector<std::string>{ "apple", "banana", "cherry", "date" };
+
+    const auto letters = linq::from( &words ).aggregate(
+        size_t( 0 ),
+        []( size_t count, const std::string& word ) {
+            return count + word.size();
+        },
+        std::plus() );
+
+    REQUIRE( letters == 21 );
+
+    // Ranges without random access are aggregated as a single chunk.
+    const auto long_words = linq::from( &words )
+                                .where( []( const std::string& word ) {
+                                    return word.size() > 4;
+                                } )
+                                .aggregate(
+                                    std::string(),
+                                    []( std::string text, const std::string& word ) {
+                                        return text + word;
+                                    },
+                                    std::plus() );
+
+    REQUIRE( long_words == "applebananacherry" );
+
+    REQUIRE( linq::from_to( 1, 100 ).aggregate( 0, std::plus(), std::plus() ) == 5050 );
+    REQUIRE( linq::from( &words ).reduce( linq::parallel, std::plus() ) == "applebananacherrydate" );
+}
+
+TEST_CASE( "to_vector( linq::parallel )" ) {
+    const auto words = std::vector<std::string>{ "apple", "banana", "cherry", "date" };
+
+    REQUIRE( linq::from( &words ).to_vector( linq::parallel ) == words );
+    REQUIRE( linq::from_to( 1, 5 ).to_vector( linq::parallel ) == std::vector{ 1, 2, 3, 4, 5 } );
+
+    // Ranges without random access are materialized on the calling thread.
+    const auto short_words = linq::from( &words ).where( []( const std::string& word ) {
+        return word.size() < 6;
+    } );
+
+    REQUIRE( short_words.to_vector( linq::parallel ) == std::vector<std::string>{ "apple", "date" } );
+}
+
+TEST_CASE( "to_sharded_map" ) {
+    const auto pairs = std::vector<std::pair<std::string, int>>{ { "a", 1 }, { "b", 2 }, { "a", 3 }, { "c", 4 } };
+
+    const linq::sharded_map<std::string, int> map = linq::from( &pairs ).to_sharded_map();
+
+    REQUIRE( map.size() == 3 );
+    REQUIRE( map.at( "a" ) == 1 );
+    REQUIRE( *map.find( "c" ) == 4 );
+    REQUIRE( map.find( "d" ) == nullptr );
+    REQUIRE( map.contains( "b" ) );
+    REQUIRE( !map.contains( "d" ) );
+    REQUIRE_THROWS_AS( map.at( "d" ), std::out_of_range );
+
+    REQUIRE( map.to_unordered_map() == linq::from( &pairs ).to_unordered_map() );
+    REQUIRE( linq::from( &pairs ).to_unordered_map( linq::parallel ) == linq::from( &pairs ).to_unordered_map() );
+
+    // Ranges without random access are stored in a single shard.
+    const auto filtered = linq::from( &pairs ).where( []( const std::pair<std::string, int>& pair ) {
+        return pair.second > 1;
+    } );
+
+    REQUIRE( filtered.to_sharded_map().shards().size() == 1 );
+    REQUIRE( filtered.to_unordered_map( linq::parallel ).at( "a" ) == 3 );
+}
+
+TEST_CASE( "to_lookup( linq::parallel )" ) {
+    const auto words = std::vector<std::string>{ "apple", "bob", "avocado", "cat", "banana" };
+
+    const auto first_letter = []( const std::string& word ) {
+        return word.front();
+    };
+
+    const auto lookup = linq::from( &words ).to_lookup( linq::parallel, first_letter );
+
+    REQUIRE( lookup.size() == 3 );
+    REQUIRE( lookup['a'].to_vector() == std::vector<std::string>{ "apple", "avocado" } );
+    REQUIRE( lookup['b'].to_vector() == std::vector<std::string>{ "bob", "banana" } );
+    REQUIRE( lookup['c'].key() == 'c' );
+    REQUIRE( !lookup.contains( 'd' ) );
+
+    // Ranges without random access are grouped on the calling thread.
+    const auto short_words = linq::from( &words ).where( []( const std::string& word ) {
+        return word.size() < 6;
+    } );
+
+    REQUIRE( short_words.to_lookup( linq::parallel, first_letter ).size() == 3 );
+}
+
+#ifndef LINQ_NO_THREADS
+TEST_CASE( "parallel to_unordered_map keeps the first value of a key" ) {
+    auto numbers = std::vector<int>( LINQ_PARALLEL_THRESHOLD * 5 + 123 );
+    std::iota( numbers.begin(), numbers.end(), 0 );
+
+    // Every key occurs in many chunks.
+    const auto to_pair = []( int i ) {
+        return std::pair( i % 10007, i );
+    };
+
+    const auto expected = linq::from( &numbers ).select( to_pair ).to_unordered_map();
+
+    for ( const size_t thread_count : { 1, 2, 3, 8 } ) {
+        linq::set_max_threads( thread_count );
+
+        const auto map = linq::from( &numbers ).select( to_pair ).to_sharded_map();
+
+        REQUIRE( map.size() == expected.size() );
+        REQUIRE( map.at( 10006 ) == 10006 );
+
+        auto is_sharded = true;
+
+        for ( size_t shard = 0; shard < map.shards().size(); ++shard ) {
+            for ( const auto& pair : map.shards()[shard] )
+                is_sharded = is_sharded && map.shard_of( pair.first ) == shard;
+        }
+
+        REQUIRE( is_sharded );
+
+        REQUIRE( map.to_unordered_map() == expected );
+        REQUIRE( linq::from( &numbers ).select( to_pair ).to_unordered_map( linq::parallel ) == expected );
+        REQUIRE( linq::from( &numbers ).as_parallel().select( to_pair ).to_unordered_map() == expected );
+    }
+
+    linq::set_max_threads( 0 );
+}
+
+TEST_CASE( "parallel to_lookup equals the sequential lookup" ) {
+    auto numbers = std::vector<int>( LINQ_PARALLEL_THRESHOLD * 5 + 123 );
+    std::iota( numbers.begin(), numbers.end(), 0 );
+
+    const auto to_text = []( int i ) {
+        return std::to_string( i );
+    };
+
+    // Keys that occur in many chunks, and keys that first occur in a later chunk.
+    const auto scattered_key = []( const std::string& text ) {
+        return std::hash<std::string>()( text ) % 1009;
+    };
+
+    const auto run_key = []( const std::string& text ) {
+        return text.size() * 1000 + static_cast<size_t>( text.front() - '0' );
+    };
+
+    const auto groups_of = []( const auto& lookup ) {
+        return lookup
+            .select( []( const auto& group ) {
+                return std::pair( group.key(), group.to_vector() );
+            } )
+            .to_vector();
+    };
+
+    const auto texts              = linq::from( &numbers ).select( to_text ).to_vector();
+    const auto expected_scattered = groups_of( linq::from( &texts ).to_lookup( scattered_key ) );
+    const auto expected_runs      = groups_of( linq::from( &texts ).to_lookup( run_key ) );
+
+    for ( const size_t thread_count : { 1, 2, 3, 8 } ) {
+        linq::set_max_threads( thread_count );
+
+        const auto scattered = linq::from( &texts ).to_lookup( linq::parallel, scattered_key );
+        const auto runs      = linq::from( &numbers ).as_parallel().select( to_text ).to_lookup( run_key );
+
+        REQUIRE( groups_of( scattered ) == expected_scattered );
+        REQUIRE( groups_of( runs ) == expected_runs );
+        REQUIRE( scattered[scattered_key( "42"s )].any( []( const std::string& text ) {
+            return text == "42";
+        } ) );
+        REQUIRE( runs.contains( 5001 ) );
+    }
+
+    linq::set_max_threads( 0 );
+}
+
+TEST_CASE( "parallel to_vector keeps the source order" ) {
+    auto numbers = std::vector<int>( LINQ_PARALLEL_THRESHOLD * 5 + 321 );
+    std::iota( numbers.begin(), numbers.end(), 0 );
+
+    const auto to_text = []( int i ) {
+        return std::to_string( i );
+    };
+
+    const auto is_odd = []( int i ) {
+        return i % 2 == 1;
+    };
+
+    const auto expected_text = linq::from( &numbers ).select( to_text ).to_vector();
+    const auto expected_odd  = linq::from( &numbers ).where( is_odd ).to_vector();
+
+    for ( const size_t thread_count : { 1, 2, 3, 8 } ) {
+        linq::set_max_threads( thread_count );
+
+        // The size of select is known up front, so that the threads store the elements in place.
+        REQUIRE( linq::from( &numbers ).select( to_text ).to_vector( linq::parallel ) == expected_text );
+        REQUIRE( linq::from( &numbers ).as_parallel().select( to_text ).to_vector() == expected_text );
+
+        // Filtered chunks are stored in buffers, which are joined in source order.
+        REQUIRE( linq::from( &numbers ).as_parallel().as_ordered().where( is_odd ).to_vector() == expected_odd );
+    }
+
+    linq::set_max_threads( 0 );
+}
+
+TEST_CASE( "parallel aggregate and reduce are reproducible" ) {
+    auto values = std::vector<float>( LINQ_PARALLEL_THRESHOLD * 5 + 77 );
+
+    for ( size_t i = 0; i < values.size(); ++i )
+        values[i] = 1.0f / static_cast<float>( i % 1000 + 1 );
+
+    auto sums       = std::vector<float>();
+    auto reductions = std::vector<float>();
+    auto strings    = std::vector<std::string>();
+
+    for ( const size_t thread_count : { 1, 2, 3, 8 } ) {
+        linq::set_max_threads( thread_count );
+
+        sums.push_back( linq::from( &values ).aggregate( 0.0f, std::plus(), std::plus() ) );
+        reductions.push_back( linq::from( &values ).reduce( linq::parallel, std::plus() ) );
+
+        // Combining in source order keeps non-commutative operations intact.
+        strings.push_back( linq::from( &values )
+                               .select( []( float f ) {
+                                   return f == 1.0f ? "x"s : ""s;
+                               } )
+                               .aggregate( ""s, std::plus(), std::plus() ) );
+    }
+
+    linq::set_max_threads( 0 );
+
+    // The partial results are combined in the same order for any number of threads.
+    REQUIRE( std::all_of( sums.begin(), sums.end(), [&]( float sum ) {
+        return sum == sums.front();
+    } ) );
+
+    REQUIRE( reductions == sums );
+    REQUIRE( strings.front() == std::string( ( values.size() + 999 ) / 1000, 'x' ) );
+    REQUIRE( std::all_of( strings.begin(), strings.end(), [&]( const std::string& text ) {
+        return text == strings.front();
+    } ) );
+
+    const auto sequential = linq::from( &values ).aggregate( 0.0, []( double sum, float f ) {
+        return sum + f;
+    } );
+
+    REQUIRE( std::abs( sums.front() - sequential ) < 1e-3 );
+}
+
+TEST_CASE( "as_parallel" ) {
+    // Large enough to be split across several threads.
+    auto numbers = std::vector<int>( LINQ_PARALLEL_THRESHOLD * 6 + 123 );
+    std::iota( numbers.begin(), numbers.end(), 0 );
+
+    const auto is_even = []( int i ) {
+        return i % 2 == 0;
+    };
+
+    const auto squared = []( int i ) {
+        return static_cast<int64_t>( i ) * i;
+    };
+
+    const auto expected = linq::from( &numbers ).where( is_even ).select( squared );
+
+    for ( const size_t thread_count : { 1, 2, 3, 8 } ) {
+        linq::set_max_threads( thread_count );
+
+        const auto query = linq::from( &numbers ).as_parallel().where( is_even ).select( squared );
+
+        REQUIRE( query.count() == expected.count() );
+        REQUIRE( linq::from( &numbers ).as_parallel().count() == numbers.size() );
+        REQUIRE( linq::from( &numbers ).as_parallel().count( is_even ) == ( numbers.size() + 1 ) / 2 );
+
+        REQUIRE( query.any( []( int64_t i ) {
+            return i == 64;
+        } ) );
+        REQUIRE( linq::from( &numbers ).as_parallel().any( []( int i ) {
+            return i == 300'000;
+        } ) );
+        REQUIRE( !linq::from( &numbers ).as_parallel().any( []( int i ) {
+            return i < 0;
+        } ) );
+
+        REQUIRE( query.sum() == expected.sum() );
+
+        const auto max = query.aggregate( int64_t( 0 ), []( int64_t a, int64_t b ) {
+            return std::max( a, b );
+        } );
+
+        REQUIRE( max == expected.max() );
+
+        REQUIRE( query.as_ordered().to_vector() == expected.to_vector() );
+
+        // Unordered chunks may be stitched in any order.
+        auto unordered = query.to_vector();
+        std::sort( unordered.begin(), unordered.end() );
+
+        REQUIRE( unordered == expected.to_vector() );
+
+        REQUIRE( query.as_sequential().to_vector() == expected.to_vector() );
+    }
+
+    linq::set_max_threads( 0 );
+}
+
+TEST_CASE( "thread_pool" ) {
+    auto pool = linq::thread_pool( 3 );
+
+    REQUIRE( pool.concurrency() == 4 );
+
+    // Tasks that workers submit are pushed onto their own deques and stolen by the others.
+    auto count = std::atomic<int>( 0 );
+
+    for ( int i = 0; i < 100; ++i ) {
+        pool.submit( [&pool, &count]() {
+            for ( int j = 0; j < 10; ++j ) {
+                pool.submit( [&count]() {
+                    count.fetch_add( 1 );
+                } );
+            }
+
+            count.fetch_add( 1 );
+        } );
+    }
+
+    pool.wait( [&count]() {
+        return count.load() == 1100;
+    } );
+
+    REQUIRE( count.load() == 1100 );
+}
+
+TEST_CASE( "thread_pool wait sleeps without pending tasks" ) {
+    auto pool       = linq::thread_pool( 1 );
+    auto is_started = std::atomic<bool>( false );
+    auto is_done    = std::atomic<bool>( false );
+
+    pool.submit( [&is_started, &is_done]() {
+        is_started.store( true );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 200 ) );
+        is_done.store( true );
+    } );
+
+    // Let the worker take the task, so that the waiting thread has nothing to execute.
+    while ( !is_started.load() )
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+
+    const auto cpu_start = std::clock();
+
+    pool.wait( [&is_done]() {
+        return is_done.load();
+    } );
+
+    // The waiting thread would use about as much processor time as the task sleeps if it kept polling.
+    const auto cpu_seconds = static_cast<double>( std::clock() - cpu_start ) / CLOCKS_PER_SEC;
+
+    REQUIRE( is_done.load() );
+    REQUIRE( cpu_seconds < 0.1 );
+}
+
+// An executor that never executes its tasks by itself.
+struct deferring_executor {
+    void submit( std::function<void()> task ) {
+        tasks.push_back( std::move( task ) );
+    }
+
+    void wait( const std::function<bool()>& is_done ) {
+        while ( !is_done() ) {
+            // The tasks are never executed here.
+        }
+    }
+
+    auto concurrency() const -> size_t {
+        return 4;
+    }
+
+    std::vector<std::function<void()>> tasks;
+};
+
+TEST_CASE( "parallel operations on executors" ) {
+    auto numbers = std::vector<int64_t>( LINQ_PARALLEL_THRESHOLD * 5 + 17 );
+    std::iota( numbers.begin(), numbers.end(), 0 );
+
+    const auto expected = int64_t( numbers.size() * ( numbers.size() - 1 ) / 2 );
+
+    SECTION( "thread_pool" ) {
+        auto pool = linq::thread_pool( 3 );
+
+        REQUIRE( linq::from( &numbers ).as_parallel( pool ).sum() == expected );
+        REQUIRE( linq::from( &numbers ).reduce( linq::parallel.on( pool ), std::plus() ) == expected );
+        REQUIRE( linq::from( &numbers ).to_vector( linq::parallel.on( pool ) ) == numbers );
+    }
+
+    SECTION( "The calling thread executes tasks that were not started" ) {
+        auto executor = deferring_executor();
+
+        REQUIRE( linq::from( &numbers ).as_parallel( executor ).sum() == expected );
+        REQUIRE( linq::from( &numbers ).to_vector( linq::parallel.on( executor ) ) == numbers );
+        REQUIRE( !executor.tasks.empty() );
+
+        // Tasks that are executed late do nothing.
+        for ( auto& task : executor.tasks )
+            task();
+    }
+
+    SECTION( "Default executor" ) {
+        auto executor = deferring_executor();
+        linq::set_default_executor( executor );
+
+        const auto sorted = linq::from( &numbers )
+                                .order_by_descending( []( int64_t i ) {
+                                    return i % 1000;
+                                } )
+                                .then_by(
+                                    []( int64_t i ) {
+                                        return i;
+                                    },
+                                    linq::sort_direction::ascending )
+                                .to_vector();
+
+        REQUIRE( linq::from( &numbers ).as_parallel().sum() == expected );
+        REQUIRE( !executor.tasks.empty() );
+
+        linq::reset_default_executor();
+
+        REQUIRE( sorted.front() == 999 );
+        REQUIRE( std::is_sorted( sorted.begin(), sorted.end(), []( int64_t a, int64_t b ) {
+            return a % 1000 > b % 1000 || ( a % 1000 == b % 1000 && a < b );
+        } ) );
+    }
+}
+
+TEST_CASE( "nested parallel operations share the thread pool" ) {
+    auto pool = linq::thread_pool( 3 );
+
+    const auto size  = int64_t( LINQ_PARALLEL_THRESHOLD * 2 );
+    const auto inner = linq::from_to( int64_t( 1 ), int64_t( size ) );
+
+    const auto sum = linq::from_to( int64_t( 0 ), int64_t( size ) )
+                         .as_parallel( pool )
+                         .select( [&]( int64_t i ) {
+                             if ( i % 16384 != 0 )
+                                 return i;
+
+                             return inner.reduce( linq::parallel.on( pool ), std::plus() ) - size * ( size + 1 ) / 2 + i;
+                         } )
+                         .sum();
+
+    REQUIRE( sum == size * ( size + 1 ) / 2 );
+}
+
+TEST_CASE( "as_parallel on from_to" ) {
+    linq::set_max_threads( 4 );
+
+    const auto size  = size_t( LINQ_PARALLEL_THRESHOLD * 4 + 1 );
+    const auto range = linq::from_to( 1, int( size ) );
+    const auto query = range.as_parallel().as_ordered();
+
+    REQUIRE( query.count() == size );
+    REQUIRE( query.to_vector() == range.to_vector() );
+    REQUIRE( query.select( []( int i ) {
+                      return static_cast<int64_t>( i );
+                  } )
+                 .sum() == int64_t( size * ( size + 1 ) / 2 ) );
+
+    linq::set_max_threads( 0 );
+}
+#endif
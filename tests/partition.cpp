@@ -41,3 +41,51 @@ TEST_CASE( "take_while" ) {
     REQUIRE( result.size() == 4 );
     REQUIRE( result == std::vector{ 1, 2, 3, 4 } );
 }
+
+TEST_CASE( "random access" ) {
+    auto numbers = std::vector<int>();
+
+    for ( int i = 0; i < 100; ++i )
+        numbers.push_back( i );
+
+    const auto doubled = linq::from( &numbers ).select( []( int i ) {
+        return i * 2;
+    } );
+
+    SECTION( "skip and take" ) {
+        const auto page = doubled.skip( 90 ).take( 20 );
+
+        REQUIRE( page.count() == 10 );
+        REQUIRE( page.to_vector() == std::vector{ 180, 182, 184, 186, 188, 190, 192, 194, 196, 198 } );
+        REQUIRE( page.element_at( 3 ) == 186 );
+        REQUIRE( page.element_at( 10 ).has_value() == false );
+
+        REQUIRE( doubled.skip( 200 ).count() == 0 );
+        REQUIRE( doubled.take( 5 ).count() == 5 );
+        REQUIRE( doubled.skip( 10 ).take( 0 ).element_at( 0 ).has_value() == false );
+    }
+
+    SECTION( "reverse" ) {
+        const auto reversed = doubled.skip( 95 ).reverse();
+
+        REQUIRE( reversed.count() == 5 );
+        REQUIRE( reversed.element_at( 0 ) == 198 );
+        REQUIRE( reversed.element_at( 4 ) == 190 );
+        REQUIRE( reversed.element_at( 5 ).has_value() == false );
+        REQUIRE( reversed.skip( 3 ).to_vector() == std::vector{ 192, 190 } );
+    }
+
+    SECTION( "sorted ranges" ) {
+        const auto sorted = linq::from( &numbers ).order_by_descending( linq::self );
+
+        REQUIRE( sorted.count() == 100 );
+        REQUIRE( sorted.element_at( 10 ) == 89 );
+    }
+
+    SECTION( "forward-only containers" ) {
+        const auto list = std::list{ 1, 2, 3, 4 };
+
+        REQUIRE( linq::from( &list ).skip( 2 ).count() == 2 );
+        REQUIRE( linq::from( &list ).element_at( 3 ) == 4 );
+    }
+}
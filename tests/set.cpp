@@ -1,6 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
+#include <cctype>
 #include <linq.hpp>
 
+using namespace std::string_literals;
+
 TEST_CASE( "distinct" ) {
     const auto numbers          = std::vector{ 1, 2, 3, 3, 5, 4, 5, 6, 7 };
     const auto distinct_numbers = linq::from( &numbers ).distinct().to_vector();
@@ -8,3 +11,86 @@ TEST_CASE( "distinct" ) {
     REQUIRE( distinct_numbers.size() == 7 );
     REQUIRE( distinct_numbers == std::vector{ 1, 2, 3, 5, 4, 6, 7 } );
 }
+
+TEST_CASE( "distinct with many elements" ) {
+    auto numbers = std::vector<int>();
+
+    for ( int i = 0; i < 100'000; ++i )
+        numbers.push_back( i % 1000 );
+
+    const auto distinct_numbers = linq::from( &numbers ).distinct().to_vector();
+
+    REQUIRE( distinct_numbers.size() == 1000 );
+    REQUIRE( distinct_numbers.front() == 0 );
+    REQUIRE( distinct_numbers.back() == 999 );
+}
+
+TEST_CASE( "distinct after select" ) {
+    const auto words  = std::vector{ "a"s, "bb"s, "cc"s, "d"s, "eee"s };
+    const auto result = linq::from( &words ).select( linq::size ).distinct().to_vector();
+
+    REQUIRE( result == std::vector<size_t>{ 1, 2, 3 } );
+}
+
+TEST_CASE( "distinct evaluates every element once" ) {
+    const auto numbers = std::vector{ 1, 2, 1, 3, 2, 1 };
+
+    auto calls = 0;
+
+    const auto query = linq::from( &numbers )
+                           .select( [&calls]( int i ) {
+                               ++calls;
+                               return i * 10;
+                           } )
+                           .distinct();
+
+    auto pulled = std::vector<int>();
+
+    for ( const auto i : query )
+        pulled.push_back( i );
+
+    REQUIRE( pulled == std::vector{ 10, 20, 30 } );
+    REQUIRE( calls == 6 );
+
+    REQUIRE( query.to_vector() == std::vector{ 10, 20, 30 } );
+    REQUIRE( calls == 12 );
+}
+
+TEST_CASE( "distinct with custom hasher" ) {
+    const auto words = std::vector{ "Hello"s, "hello"s, "World"s, "HELLO"s, "world"s };
+
+    const auto lower = []( std::string str ) {
+        for ( auto& ch : str )
+            ch = static_cast<char>( std::tolower( static_cast<unsigned char>( ch ) ) );
+
+        return str;
+    };
+
+    const auto result = linq::from( &words )
+                            .distinct(
+                                [&]( const std::string& str ) {
+                                    return std::hash<std::string>()( lower( str ) );
+                                },
+                                [&]( const std::string& a, const std::string& b ) {
+                                    return lower( a ) == lower( b );
+                                } )
+                            .to_vector();
+
+    REQUIRE( result == std::vector{ "Hello"s, "World"s } );
+}
+
+TEST_CASE( "distinct without std::hash" ) {
+    struct point {
+        int x{};
+        int y{};
+
+        bool operator==( const point& ) const = default;
+    };
+
+    STATIC_REQUIRE_FALSE( linq::details::is_hashable_v<point> );
+
+    const auto points = std::vector<point>{ { 1, 2 }, { 3, 4 }, { 1, 2 }, { 5, 6 }, { 3, 4 } };
+    const auto result = linq::from( &points ).distinct().to_vector();
+
+    REQUIRE( result == std::vector<point>{ { 1, 2 }, { 3, 4 }, { 5, 6 } } );
+}
@@ -1,6 +1,31 @@
+#include "datatypes.hpp"
 #include <catch2/catch_test_macros.hpp>
 #include <linq.hpp>
 
+namespace {
+// An element type that counts its copies.
+struct tracked {
+    int key{};
+
+    explicit tracked( int k )
+        : key( k ) {
+    }
+
+    tracked( const tracked& other )
+        : key( other.key ) {
+        ++copy_count;
+    }
+
+    auto operator=( const tracked& other ) -> tracked& {
+        key = other.key;
+        ++copy_count;
+        return *this;
+    }
+
+    static inline int copy_count = 0;
+};
+} // namespace
+
 using namespace std::string_literals;
 
 TEST_CASE( "order_by" ) {
@@ -119,3 +144,389 @@ TEST_CASE( "reverse" ) {
     REQUIRE( result.size() == 4 );
     REQUIRE( result == std::vector{ 4, 3, 2, 1 } );
 }
+
+TEST_CASE( "reverse without buffering" ) {
+    const auto numbers = std::vector{ 1, 2, 3, 4, 5, 6 };
+    const auto is_even = []( int i ) {
+        return i % 2 == 0;
+    };
+
+    SECTION( "where and select" ) {
+        const auto result = linq::from( &numbers )
+                                .where( is_even )
+                                .select( []( int i ) {
+                                    return std::to_string( i );
+                                } )
+                                .reverse()
+                                .to_vector();
+
+        REQUIRE( result == std::vector<std::string>{ "6", "4", "2" } );
+    }
+
+    SECTION( "where with a non-matching first element" ) {
+        const auto result = linq::from( &numbers ).skip( 1 ).where( []( int i ) {
+            return i % 3 != 2;
+        } );
+
+        REQUIRE( result.reverse().to_vector() == std::vector{ 6, 4, 3 } );
+    }
+
+    SECTION( "empty ranges" ) {
+        const auto empty = std::vector<int>();
+
+        REQUIRE( linq::from( &empty ).reverse().to_vector().empty() );
+        REQUIRE( linq::from( &numbers ).where( []( int i ) { return i > 10; } ).reverse().to_vector().empty() );
+    }
+
+    SECTION( "sorted ranges" ) {
+        const auto result = linq::from( &numbers ).order_by_descending( is_even ).reverse().to_vector();
+
+        REQUIRE( result == std::vector{ 5, 3, 1, 6, 4, 2 } );
+    }
+
+    SECTION( "mutable containers" ) {
+        auto values = std::vector{ 1, 2, 3 };
+
+        for ( int& value : linq::from_mutable( &values ).reverse() )
+            value *= 10;
+
+        REQUIRE( values == std::vector{ 10, 20, 30 } );
+    }
+
+    SECTION( "forward-only containers" ) {
+        const auto list = std::list{ 1, 2, 3 };
+
+        REQUIRE( linq::from( &list ).reverse().to_vector() == std::vector{ 3, 2, 1 } );
+    }
+}
+
+TEST_CASE( "order_by key caching" ) {
+    const auto words = std::vector{ "hello"s, "world"s, "here"s, "are"s, "some"s, "sorted"s, "words"s };
+
+    SECTION( "computes each key once" ) {
+        auto key_count = 0;
+
+        const auto result = linq::from( &words )
+                                .order_by_descending( [&]( const std::string& word ) {
+                                    ++key_count;
+                                    return word.substr( 1 );
+                                } )
+                                .to_vector();
+
+        REQUIRE( key_count == 7 );
+        REQUIRE( result == std::vector{ "are"s, "sorted"s, "world"s, "words"s, "some"s, "here"s, "hello"s } );
+    }
+
+    SECTION( "keys returned by reference" ) {
+        const auto result = linq::from( &words )
+                                .order_by_ascending( []( const std::string& word ) -> const std::string& {
+                                    return word;
+                                } )
+                                .to_vector();
+
+        REQUIRE( result == std::vector{ "are"s, "hello"s, "here"s, "some"s, "sorted"s, "words"s, "world"s } );
+    }
+
+    SECTION( "empty range" ) {
+        const auto empty = std::vector<std::string>();
+        REQUIRE( linq::from( &empty ).order_by_ascending( linq::size ).to_vector().empty() );
+    }
+}
+
+TEST_CASE( "then_by chain" ) {
+    struct item {
+        int         a{};
+        std::string b;
+        double      c{};
+    };
+
+    const auto items = std::vector<item>{
+        { 2, "x", 1.0 }, { 1, "y", 2.0 }, { 2, "x", 0.5 }, { 1, "x", 3.0 }, { 2, "w", 9.0 }, { 1, "y", 1.0 },
+    };
+
+    auto key_count = std::array{ 0, 0, 0 };
+
+    const auto query = linq::from( &items )
+                           .order_by_ascending( [&]( const item& i ) {
+                               ++key_count[0];
+                               return i.a;
+                           } )
+                           .then_by_descending( [&]( const item& i ) {
+                               ++key_count[1];
+                               return i.b;
+                           } )
+                           .then_by_ascending( [&]( const item& i ) {
+                               ++key_count[2];
+                               return i.c;
+                           } );
+
+    const auto result = query
+                            .select( []( const item& i ) {
+                                return i.c;
+                            } )
+                            .to_vector();
+
+    // Every key of every level is computed exactly once, so the chain is sorted once.
+    REQUIRE( key_count == std::array{ 6, 6, 6 } );
+    REQUIRE( result == std::vector{ 1.0, 2.0, 3.0, 0.5, 1.0, 9.0 } );
+}
+
+TEST_CASE( "order_by with take" ) {
+    auto numbers = std::vector<int>();
+
+    for ( int i = 0; i < 1000; ++i )
+        numbers.push_back( ( i * 7919 ) % 251 );
+
+    const auto by_tens = []( int n ) {
+        return n / 10;
+    };
+
+    const auto sorted = linq::from( &numbers ).order_by_descending( by_tens ).then_by_ascending( linq::self ).to_vector();
+
+    SECTION( "matches a full sort" ) {
+        for ( const size_t count : { 0, 1, 5, 50, 999, 1000, 2000 } ) {
+            const auto result = linq::from( &numbers )
+                                    .order_by_descending( by_tens )
+                                    .then_by_ascending( linq::self )
+                                    .take( count )
+                                    .to_vector();
+
+            const auto expected = std::vector( sorted.begin(), sorted.begin() + std::min<size_t>( count, 1000 ) );
+
+            REQUIRE( result == expected );
+        }
+    }
+
+    SECTION( "is stable" ) {
+        const auto people = std::vector<person>{
+            { .name = "P1", .age = 20 },
+            { .name = "P2", .age = 30 },
+            { .name = "P3", .age = 20 },
+            { .name = "P4", .age = 30 },
+            { .name = "P5", .age = 10 },
+            { .name = "P6", .age = 30 },
+        };
+
+        const auto names = linq::from( &people )
+                               .order_by_descending( []( const person& p ) {
+                                   return p.age;
+                               } )
+                               .take( 4 )
+                               .select( []( const person& p ) {
+                                   return p.name;
+                               } )
+                               .to_vector();
+
+        REQUIRE( names == std::vector{ "P2"s, "P4"s, "P6"s, "P1"s } );
+    }
+}
+
+TEST_CASE( "order_by with arithmetic keys" ) {
+    enum class color { red = -1, green, blue };
+
+    struct row {
+        int           id{};
+        int           small{};
+        std::int64_t  wide{};
+        double        real{};
+        color         tint{};
+        unsigned char byte{};
+    };
+
+    auto rows = std::vector<row>();
+
+    for ( int i = 0; i < 5000; ++i ) {
+        const auto r = ( static_cast<std::int64_t>( i ) * 2654435761 ) % 1000003;
+
+        rows.push_back( {
+            .id    = i,
+            .small = static_cast<int>( r % 7 ) - 3,
+            .wide  = ( r - 500000 ) * 1000000007,
+            .real  = i % 11 == 0 ? -0.0 : static_cast<double>( r % 2001 - 1000 ) / 8.0,
+            .tint  = static_cast<color>( r % 3 - 1 ),
+            .byte  = static_cast<unsigned char>( r ),
+        } );
+    }
+
+    // Sorts the rows with a comparison sort for reference.
+    const auto reference = [&rows]( auto less ) {
+        auto result = rows;
+        std::stable_sort( result.begin(), result.end(), less );
+
+        auto ids = std::vector<int>();
+
+        for ( const auto& r : result )
+            ids.push_back( r.id );
+
+        return ids;
+    };
+
+    const auto ids_of = []( const auto& range ) {
+        return range
+            .select( []( const row& r ) {
+                return r.id;
+            } )
+            .to_vector();
+    };
+
+    SECTION( "small domain" ) {
+        const auto result = ids_of( linq::from( &rows ).order_by_descending( []( const row& r ) {
+            return r.small;
+        } ) );
+
+        REQUIRE( result == reference( []( const row& a, const row& b ) {
+                     return a.small > b.small;
+                 } ) );
+    }
+
+    SECTION( "wide signed keys" ) {
+        const auto result = ids_of( linq::from( &rows ).order_by_ascending( []( const row& r ) {
+            return r.wide;
+        } ) );
+
+        REQUIRE( result == reference( []( const row& a, const row& b ) {
+                     return a.wide < b.wide;
+                 } ) );
+    }
+
+    SECTION( "floating point keys" ) {
+        const auto result = ids_of( linq::from( &rows ).order_by_ascending( []( const row& r ) -> const double& {
+            return r.real;
+        } ) );
+
+        REQUIRE( result == reference( []( const row& a, const row& b ) {
+                     return a.real < b.real;
+                 } ) );
+    }
+
+    SECTION( "chain with mixed directions" ) {
+        const auto result = ids_of( linq::from( &rows )
+                                        .order_by_ascending( []( const row& r ) {
+                                            return r.tint;
+                                        } )
+                                        .then_by_descending( []( const row& r ) {
+                                            return static_cast<float>( r.real );
+                                        } )
+                                        .then_by_ascending( []( const row& r ) {
+                                            return r.byte;
+                                        } ) );
+
+        REQUIRE( result == reference( []( const row& a, const row& b ) {
+                     if ( a.tint != b.tint )
+                         return a.tint < b.tint;
+                     if ( a.real != b.real )
+                         return a.real > b.real;
+                     return a.byte < b.byte;
+                 } ) );
+    }
+}
+
+TEST_CASE( "order_by unstable" ) {
+    auto words = std::vector<std::string>();
+
+    for ( int i = 0; i < 500; ++i )
+        words.push_back( std::to_string( ( i * 7919 ) % 1000 ) );
+
+    const auto result = linq::from( &words )
+                            .order_by_descending( linq::size, linq::sort_stability::unstable )
+                            .then_by_ascending( []( const std::string& s ) -> const char& {
+                                return s.front();
+                            } )
+                            .to_vector();
+
+    REQUIRE( result.size() == words.size() );
+    REQUIRE( std::is_permutation( result.begin(), result.end(), words.begin() ) );
+
+    REQUIRE( std::is_sorted( result.begin(), result.end(), []( const std::string& a, const std::string& b ) {
+        return a.size() != b.size() ? a.size() > b.size() : a.front() < b.front();
+    } ) );
+}
+
+TEST_CASE( "order_by over a container" ) {
+    auto values = std::vector<tracked>();
+
+    for ( int i = 0; i < 100; ++i )
+        values.emplace_back( ( i * 37 ) % 100 );
+
+    const auto by_key = []( const tracked& t ) {
+        return t.key;
+    };
+
+    SECTION( "yields references to the source elements" ) {
+        tracked::copy_count = 0;
+
+        const auto sorted = linq::from( &values ).where( []( const tracked& t ) {
+            return t.key % 2 == 0;
+        } );
+
+        auto expected_key = 0;
+
+        for ( const tracked& t : sorted.order_by_ascending( by_key ) ) {
+            REQUIRE( t.key == expected_key );
+            REQUIRE( &t == &values[static_cast<size_t>( t.key * 73 % 100 )] );
+            expected_key += 2;
+        }
+
+        for ( const tracked& t : sorted.order_by_descending( by_key ).take( 10 ) )
+            REQUIRE( t.key >= 80 );
+
+        REQUIRE( expected_key == 100 );
+        REQUIRE( tracked::copy_count == 0 );
+    }
+
+    SECTION( "copies elements of other ranges" ) {
+        const auto result = linq::from( &values )
+                                .select( []( const tracked& t ) {
+                                    return t.key * 2;
+                                } )
+                                .order_by_descending( linq::self )
+                                .take( 3 )
+                                .to_vector();
+
+        REQUIRE( result == std::vector{ 198, 196, 194 } );
+    }
+}
+
+#ifndef LINQ_NO_THREADS
+TEST_CASE( "order_by parallel" ) {
+    auto values = std::vector<std::pair<int, int>>();
+
+    for ( int i = 0; i < 300'000; ++i )
+        values.emplace_back( ( i * 37 ) % 1009, i );
+
+    // A pair key is sorted by comparisons rather than by radix sort.
+    const auto by_first = []( const std::pair<int, int>& p ) {
+        return std::pair( p.first / 3, 0 );
+    };
+
+    auto expected = values;
+    std::stable_sort( expected.begin(), expected.end(), [&]( const auto& a, const auto& b ) {
+        return by_first( a ) > by_first( b );
+    } );
+
+    auto sorted_values = values;
+    std::sort( sorted_values.begin(), sorted_values.end() );
+
+    for ( const size_t thread_count : { 1, 2, 3, 5, 8 } ) {
+        linq::set_max_threads( thread_count );
+
+        const auto stable = linq::from( &values ).order_by_descending( by_first ).to_vector();
+
+        REQUIRE( stable == expected );
+
+        const auto unstable =
+            linq::from( &values ).order_by_descending( by_first, linq::sort_stability::unstable ).to_vector();
+
+        REQUIRE( std::is_sorted( unstable.begin(), unstable.end(), [&]( const auto& a, const auto& b ) {
+            return by_first( a ) > by_first( b );
+        } ) );
+
+        auto elements = unstable;
+        std::sort( elements.begin(), elements.end() );
+
+        REQUIRE( elements == sorted_values );
+    }
+
+    linq::set_max_threads( 0 );
+}
+#endif